@@ -0,0 +1,412 @@
+/**
+ *    @file  async.hpp
+ *   @brief  Asynchronous input stream based on C++20 coroutines.
+ *
+ *  This header file defines `KAsyncStreamIn` class which parses records from an
+ *  asynchronous byte source. Refilling the stream buffer suspends the calling
+ *  coroutine instead of blocking the thread.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  09:51
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_ASYNC_HPP__
+#define  KSEQPP_ASYNC_HPP__
+
+#if __has_include( <coroutine> ) && defined( __cpp_impl_coroutine )
+
+#include <coroutine>
+#include <exception>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  /**
+   *  @brief  Lazily started coroutine returning a value of type `T`.
+   *
+   *  It can be awaited by another coroutine or driven manually by `resume()`
+   *  until it is `done()`.
+   */
+  template< typename T >
+    class KTask {
+      public:
+        /* Nested classes */
+        struct promise_type {
+          T value{ };
+          std::exception_ptr ex;
+          std::coroutine_handle<> cont;
+
+          struct final_awaiter {
+              inline bool
+            await_ready( ) noexcept
+            {
+              return false;
+            }
+
+              inline std::coroutine_handle<>
+            await_suspend( std::coroutine_handle< promise_type > h ) noexcept
+            {
+              auto cont = h.promise().cont;
+              return cont ? cont : std::noop_coroutine();
+            }
+
+              inline void
+            await_resume( ) noexcept
+            { }
+          };
+
+            inline KTask
+          get_return_object( )
+          {
+            return KTask( std::coroutine_handle< promise_type >::from_promise( *this ) );
+          }
+
+            inline std::suspend_always
+          initial_suspend( ) noexcept
+          {
+            return { };
+          }
+
+            inline final_awaiter
+          final_suspend( ) noexcept
+          {
+            return { };
+          }
+
+            inline void
+          return_value( T v )
+          {
+            this->value = std::move( v );
+          }
+
+            inline void
+          unhandled_exception( )
+          {
+            this->ex = std::current_exception();
+          }
+        };
+        /* Lifecycle */
+        KTask( KTask const& ) = delete;
+        KTask& operator=( KTask const& ) = delete;
+
+        KTask( KTask&& other ) noexcept : h( other.h )
+        {
+          other.h = nullptr;
+        }
+
+        KTask& operator=( KTask&& other ) noexcept
+        {
+          if ( this == &other ) return *this;
+          if ( this->h ) this->h.destroy();
+          this->h = other.h;
+          other.h = nullptr;
+          return *this;
+        }
+
+        ~KTask( ) noexcept
+        {
+          if ( this->h ) this->h.destroy();
+        }
+        /* Awaitable interface */
+          inline bool
+        await_ready( ) const noexcept
+        {
+          return false;
+        }
+
+          inline std::coroutine_handle<>
+        await_suspend( std::coroutine_handle<> cont ) noexcept
+        {
+          this->h.promise().cont = cont;
+          return this->h;
+        }
+
+          inline T
+        await_resume( )
+        {
+          return this->get();
+        }
+        /* Manual driving */
+          inline bool
+        done( ) const
+        {
+          return this->h.done();
+        }
+
+          inline void
+        resume( )
+        {
+          this->h.resume();
+        }
+
+          inline T
+        get( )
+        {
+          if ( this->h.promise().ex ) std::rethrow_exception( this->h.promise().ex );
+          return std::move( this->h.promise().value );
+        }
+      private:
+        /* Lifecycle */
+        explicit KTask( std::coroutine_handle< promise_type > h_ ) : h( h_ ) { }
+        /* Data members */
+        std::coroutine_handle< promise_type > h;
+    };
+
+  /**
+   *  @brief  Input stream parsing records from an asynchronous byte source.
+   *
+   *  The source should provide `read( char* buf, std::size_t n )` returning an
+   *  awaitable which results in the number of bytes read into `buf`: 0 at the
+   *  end of the input and -1 on error (e.g. a non-blocking socket wrapper).
+   *
+   *  Records are parsed by the same parser as `KStreamIn` from the bytes received
+   *  so far. If a record is not complete yet, the parse is rolled back and retried
+   *  after more bytes are awaited from the source; so refills suspend the caller
+   *  rather than blocking the thread. The amount of bytes awaited grows with the
+   *  size of the incomplete record; so the retries take amortised linear time.
+   *
+   *  The source reads into a buffer which is parsed in place: the parser is
+   *  pointed at the received bytes instead of copying them, and the parsed
+   *  bytes are only discarded when the buffer is refilled.
+   */
+  template< typename TSource >
+    class KAsyncStreamIn {
+      public:
+        /* Typedefs */
+        using source_type = TSource;
+        using size_type = std::string::size_type;
+        /* Consts */
+        constexpr static size_type DEFAULT_CHUNKSIZE = 65536;
+        /* Lifecycle */
+        KAsyncStreamIn( source_type& src_, size_type chunksize_=DEFAULT_CHUNKSIZE )
+          : src( src_ ), chunksize( chunksize_ ), parser( this, KAsyncStreamIn::feed, chunksize_ ),
+          cursor( 0 ), is_starved( false ), src_eof( false ), src_err( false )
+        { }
+
+        KAsyncStreamIn( KAsyncStreamIn const& ) = delete;
+        KAsyncStreamIn& operator=( KAsyncStreamIn const& ) = delete;
+        /* Accessors */
+          inline unsigned long int
+        counts( ) const
+        {
+          return this->parser.counts();
+        }
+
+          inline field::Field
+        get_fields( ) const
+        {
+          return this->parser.get_fields();
+        }
+        /* Mutators */
+          inline void
+        set_fields( field::Field fields_ )
+        {
+          this->parser.set_fields( fields_ );
+        }
+        /* Methods */
+          inline bool
+        err( ) const
+        {
+          return this->parser.err();
+        }
+
+          inline bool
+        eof( ) const
+        {
+          return this->parser.eof();
+        }
+
+          inline bool
+        tqs( ) const
+        {
+          return this->parser.tqs();
+        }
+
+          inline bool
+        fail( ) const
+        {
+          return this->parser.fail();
+        }
+
+        operator bool( ) const
+        {
+          return !this->fail();
+        }
+
+        /**
+         *  @brief  Parse the next record.
+         *
+         *  @return an awaitable resulting in `true` if a record was read; i.e. the
+         *  same as the state of the stream afterwards.
+         */
+          inline KTask< bool >
+        next( KSeq& rec )
+        {
+          while ( true ) {
+            auto state = this->parser.save();
+            auto offset = this->cursor - state.unread;
+            this->is_starved = false;
+            this->parser >> rec;
+            if ( !this->is_starved ) co_return !this->parser.fail();
+            // roll back and wait for more bytes
+            this->parser.restore( state );
+            this->cursor = offset;
+            co_await this->fill( std::max( this->chunksize, this->pending.size() - offset ) );
+          }
+        }
+
+        /**
+         *  @brief  Read a batch of records into the given vector.
+         *
+         *  The records already in the vector are parsed into; so their strings keep
+         *  their capacity. The vector is resized to the number of read records.
+         *
+         *  @return an awaitable resulting in the number of read records.
+         */
+          inline KTask< std::vector< KSeq >::size_type >
+        read( std::vector< KSeq >& recs, std::vector< KSeq >::size_type const size )
+        {
+          if ( recs.size() < size ) recs.resize( size );
+          std::vector< KSeq >::size_type i = 0;
+          for ( ; i < size; ++i ) {
+            bool ok = co_await this->next( recs[ i ] );
+            if ( !ok ) break;
+          }
+          recs.resize( i );
+          co_return i;
+        }
+      private:
+        /* Nested classes */
+        using feed_type = long int(*)( KAsyncStreamIn*, char*, long int );
+
+        class Parser_ : public KStreamIn< KAsyncStreamIn*, feed_type > {
+          public:
+            /* Typedefs */
+            using base_type = KStreamIn< KAsyncStreamIn*, feed_type >;
+            /* Nested classes */
+            struct State {
+              typename base_type::size_type unread;
+              bool is_eof;
+              bool is_tqs;
+              bool is_ready;
+              bool last;
+              unsigned long int counter;
+              unsigned long int nfiltered;
+              unsigned long int offset;
+            };
+            /* Lifecycle */
+            template< typename ...TArgs >
+              Parser_( TArgs&&... args )
+                : base_type( std::forward< TArgs >( args )... ), owned( this->buf )
+              { }
+
+            ~Parser_( ) noexcept
+            {
+              this->buf = this->owned;
+            }
+            /* Methods */
+            /**
+             *  @brief  Parse the given bytes in place as the next buffer.
+             *
+             *  It should be called by the read function; the bytes should be left
+             *  untouched until the next read or `restore`.
+             */
+              inline void
+            lend( char* p )
+            {
+              this->buf = p;
+            }
+
+              inline State
+            save( ) const
+            {
+              return { this->m_end > this->m_begin ? this->m_end - this->m_begin : 0,
+                       this->is_eof, this->is_tqs, this->is_ready, this->last, this->counter,
+                       this->nfiltered, this->tell() };
+            }
+
+            /**
+             *  @brief  Restore the parser state.
+             *
+             *  The buffer is discarded; the unread bytes are fed again.
+             */
+              inline void
+            restore( State const& state )
+            {
+              this->buf = this->owned;
+              this->m_begin = 0;
+              this->m_end = 0;
+              this->is_eof = state.is_eof;
+              this->is_tqs = state.is_tqs;
+              this->is_ready = state.is_ready;
+              this->last = state.last;
+              this->counter = state.counter;
+              this->nfiltered = state.nfiltered;
+              this->nconsumed = state.offset;
+            }
+          private:
+            /* Data members */
+            char* owned;  /**< @brief the buffer allocated by the parser */
+        };
+        /* Data members */
+        source_type& src;      /**< @brief asynchronous byte source */
+        size_type chunksize;   /**< @brief minimum number of bytes awaited from the source at once */
+        Parser_ parser;        /**< @brief the record parser */
+        std::string pending;   /**< @brief received bytes; the ones before `cursor` are parsed or in the parser */
+        size_type cursor;      /**< @brief next byte in `pending` to be passed to the parser */
+        bool is_starved;       /**< @brief the parser needed more bytes than received */
+        bool src_eof;          /**< @brief end of the source is reached */
+        bool src_err;          /**< @brief the source failed */
+        /* Methods */
+          static inline long int
+        feed( KAsyncStreamIn* self, char* buf, long int size )
+        {
+          if ( self->cursor == self->pending.size() ) {
+            if ( self->src_err ) return -1;
+            if ( !self->src_eof ) self->is_starved = true;
+            return 0;
+          }
+          ( void )buf;  // parsed in place
+          size_type len = std::min( static_cast< size_type >( size ),
+                                    self->pending.size() - self->cursor );
+          self->parser.lend( &self->pending[ self->cursor ] );
+          self->cursor += len;
+          return len;
+        }
+
+        /**
+         *  @brief  Discard the bytes before `cursor` and await `size` more bytes.
+         *
+         *  It should be called when the parser holds no bytes of `pending`.
+         */
+          inline KTask< bool >
+        fill( size_type size )
+        {
+          this->pending.erase( 0, this->cursor );
+          this->cursor = 0;
+          size_type begin = this->pending.size();
+          this->pending.resize( begin + size );
+          size_type total = 0;
+          while ( total < size ) {
+            long int n = co_await this->src.read( &this->pending[ begin + total ], size - total );
+            if ( n < 0 ) this->src_err = true;
+            if ( n <= 0 ) {
+              this->src_eof = true;
+              break;
+            }
+            total += n;
+          }
+          this->pending.resize( begin + total );
+          co_return true;
+        }
+    };
+}  /* -----  end of namespace klibpp  ----- */
+
+#endif  /* ----- __cpp_impl_coroutine ----- */
+#endif  /* ----- #ifndef KSEQPP_ASYNC_HPP__  ----- */
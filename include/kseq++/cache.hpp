@@ -0,0 +1,566 @@
+/**
+ *    @file  cache.hpp
+ *   @brief  Binary record cache.
+ *
+ *  This header file defines `KCacheWriter` and `KCacheReader` classes which
+ *  write and read a compact binary container of sequence records. A cache file
+ *  is mapped into memory by the reader and its records are iterated without
+ *  being parsed or copied; so a dataset which is read many times can be
+ *  converted once by `to_cache` and reloaded almost instantly.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:29
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_CACHE_HPP__
+#define  KSEQPP_CACHE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  /**
+   *  @brief  Layout of the cache files.
+   *
+   *  All integers are stored in the native byte order. A file consists of:
+   *
+   *  - `Header`: identifies the file and the index; protected by a checksum.
+   *  - Blocks of up to a fixed number of records; each one is a `Block` header
+   *    followed by four columns of 32-bit lengths (names, comments, sequences,
+   *    and qualities) and then four columns of concatenated field bytes. If all
+   *    sequences of a block consist of A, C, G, and T, they are 2-bit packed (if
+   *    enabled). Blocks are padded to 8 bytes.
+   *  - Block index: an `IndexEntry` per block.
+   */
+  namespace cache {
+    /* Consts */
+    constexpr char MAGIC[ 8 ] = { 'K', 'S', 'Q', 'C', 'A', 'C', 'H', 'E' };
+    constexpr std::uint32_t VERSION = 1;
+    constexpr std::uint32_t PACKED = 1;     /**< @brief flag: 2-bit packed sequences */
+    constexpr std::uint32_t NCOLUMNS = 4;   /**< @brief name, comment, sequence, and quality */
+
+    struct Header {
+      char magic[ 8 ];           /**< @brief `MAGIC` */
+      std::uint32_t version;     /**< @brief format version */
+      std::uint32_t flags;       /**< @brief `PACKED` if packing is enabled */
+      std::uint64_t nrecords;    /**< @brief total number of records */
+      std::uint64_t nblocks;     /**< @brief number of blocks */
+      std::uint64_t index;       /**< @brief file offset of the block index */
+      std::uint64_t checksum;    /**< @brief XXH64 of the preceding header bytes */
+    };
+
+    struct Block {
+      std::uint32_t nrecords;                /**< @brief number of records in the block */
+      std::uint32_t flags;                   /**< @brief `PACKED` if the sequences are packed */
+      std::uint64_t sizes[ NCOLUMNS ];       /**< @brief size of each byte column */
+    };
+
+    struct IndexEntry {
+      std::uint64_t offset;  /**< @brief file offset of the block */
+      std::uint64_t first;   /**< @brief index of the first record in the block */
+    };
+
+      inline std::uint64_t
+    header_checksum( Header const& h )
+    {
+      return KHash64::of( reinterpret_cast< const char* >( &h ), offsetof( Header, checksum ) );
+    }
+
+      inline std::uint64_t
+    packed_size( std::uint64_t len )
+    {
+      return ( len + 3 ) / 4;
+    }
+
+    /**
+     *  @brief  Unpack `len` bases of a 2-bit packed sequence appending them to `out`.
+     */
+      inline void
+    unpack( const unsigned char* s, std::uint64_t len, std::string& out )
+    {
+      static const char bases[] = "ACGT";
+      std::string::size_type pos = out.size();
+      out.resize( pos + len );
+      for ( std::uint64_t i = 0; i < len; ++i ) {
+        out[ pos + i ] = bases[ ( s[ i / 4 ] >> ( 2 * ( i % 4 ) ) ) & 3 ];
+      }
+    }
+  }  /* -----  end of namespace cache  ----- */
+
+  /**
+   *  @brief  Record view into a mapped cache file.
+   *
+   *  The fields point into the mapping and are not NUL-terminated. A 2-bit
+   *  packed sequence is unpacked into `buffer` to which `seq` then points.
+   */
+  struct KCacheRecord {
+    /* Typedefs */
+    using size_type = std::uint64_t;
+    /* Data members */
+    const char* name;
+    size_type name_len;
+    const char* comment;
+    size_type comment_len;
+    const char* seq;
+    size_type seq_len;
+    const char* qual;
+    size_type qual_len;
+    std::string buffer;  /**< @brief unpacked sequence of packed blocks */
+    /* Methods */
+    /**
+     *  @brief  Copy the fields to a record.
+     */
+      inline void
+    get( KSeq& rec ) const
+    {
+      rec.name.assign( this->name, this->name_len );
+      rec.comment.assign( this->comment, this->comment_len );
+      rec.seq.assign( this->seq, this->seq_len );
+      rec.qual.assign( this->qual, this->qual_len );
+    }
+  };
+
+  /**
+   *  @brief  Cache file writer.
+   *
+   *  Records are buffered in columns until a block is full. The index and the
+   *  final header are written when the writer is closed (or destructed). An
+   *  `std::runtime_error` is thrown on I/O errors.
+   */
+  class KCacheWriter {
+    public:
+      /* Typedefs */
+      using size_type = std::uint64_t;
+      /* Consts */
+      constexpr static size_type DEFAULT_BLOCKSIZE = 8192;  /**< @brief records per block */
+      /* Lifecycle */
+      KCacheWriter( const char* filename, bool packed_=true,
+          size_type blocksize_=DEFAULT_BLOCKSIZE )
+        : packed( packed_ ), blocksize( blocksize_ ), nrecords( 0 ), offset( 0 )
+      {
+        if ( this->blocksize == 0 ) throw std::invalid_argument( "block size should be positive" );
+        this->fp = std::fopen( filename, "wb" );
+        if ( this->fp == nullptr ) {
+          throw std::runtime_error( "cannot open '" + std::string( filename ) + "' for writing" );
+        }
+        cache::Header header = cache::Header();  // placeholder until closed
+        this->put( &header, sizeof( header ) );
+        this->clear_block();
+      }
+
+      KCacheWriter( KCacheWriter const& ) = delete;
+      KCacheWriter& operator=( KCacheWriter const& ) = delete;
+
+      ~KCacheWriter( ) noexcept
+      {
+        try {
+          this->close();
+        }
+        catch ( ... ) { }
+      }
+      /* Accessors */
+        inline size_type
+      counts( ) const
+      {
+        return this->nrecords + this->lengths[ 0 ].size();
+      }
+      /* Methods */
+        inline KCacheWriter&
+      operator<<( KSeq const& rec )
+      {
+        std::string const* fields[ cache::NCOLUMNS ] = { &rec.name, &rec.comment, &rec.seq, &rec.qual };
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          if ( fields[ i ]->size() > std::numeric_limits< std::uint32_t >::max() ) {
+            throw std::runtime_error( "record field is too long for the cache" );
+          }
+        }
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          this->lengths[ i ].push_back( static_cast< std::uint32_t >( fields[ i ]->size() ) );
+          this->columns[ i ] += *fields[ i ];
+        }
+        if ( this->lengths[ 0 ].size() == this->blocksize ) this->flush_block();
+        return *this;
+      }
+
+      /**
+       *  @brief  Write the last block, the index, and the header; and close the file.
+       */
+        inline void
+      close( )
+      {
+        if ( this->fp == nullptr ) return;
+        this->flush_block();
+        cache::Header header;
+        std::memcpy( header.magic, cache::MAGIC, sizeof( header.magic ) );
+        header.version = cache::VERSION;
+        header.flags = this->packed ? cache::PACKED : 0;
+        header.nrecords = this->nrecords;
+        header.nblocks = this->index.size();
+        header.index = this->offset;
+        header.checksum = cache::header_checksum( header );
+        if ( !this->index.empty() ) {
+          this->put( this->index.data(), this->index.size() * sizeof( cache::IndexEntry ) );
+        }
+        bool ok = ( std::fseek( this->fp, 0, SEEK_SET ) == 0 &&
+                    std::fwrite( &header, sizeof( header ), 1, this->fp ) == 1 );
+        ok = ( std::fclose( this->fp ) == 0 ) && ok;
+        this->fp = nullptr;
+        if ( !ok ) throw std::runtime_error( "cannot write the cache file" );
+      }
+    private:
+      /* Data members */
+      std::FILE* fp;                                         /**< @brief output file */
+      bool packed;                                           /**< @brief pack ACGT-only blocks */
+      size_type blocksize;                                   /**< @brief records per block */
+      size_type nrecords;                                    /**< @brief number of records in written blocks */
+      size_type offset;                                      /**< @brief current file offset */
+      std::vector< std::uint32_t > lengths[ cache::NCOLUMNS ];  /**< @brief field lengths of the current block */
+      std::string columns[ cache::NCOLUMNS ];                /**< @brief field bytes of the current block */
+      std::vector< cache::IndexEntry > index;                /**< @brief block index */
+      /* Methods */
+        inline void
+      put( const void* data, size_type size )
+      {
+        if ( size != 0 && std::fwrite( data, size, 1, this->fp ) != 1 ) {
+          throw std::runtime_error( "cannot write the cache file" );
+        }
+        this->offset += size;
+      }
+
+        inline void
+      clear_block( )
+      {
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          this->lengths[ i ].clear();
+          this->columns[ i ].clear();
+        }
+      }
+
+      /**
+       *  @brief  Pack the sequence column in place if it consists of A, C, G, and T.
+       */
+        inline bool
+      pack_sequences( )
+      {
+        std::string& seqs = this->columns[ 2 ];
+        for ( char c : seqs ) {
+          if ( c != 'A' && c != 'C' && c != 'G' && c != 'T' ) return false;
+        }
+        std::string packed_seqs;
+        std::string::size_type pos = 0;
+        for ( std::uint32_t len : this->lengths[ 2 ] ) {
+          std::string::size_type start = packed_seqs.size();
+          packed_seqs.resize( start + cache::packed_size( len ), 0 );
+          for ( std::uint32_t i = 0; i < len; ++i ) {
+            unsigned char code = ( seqs[ pos + i ] >> 1 ) & 3;  // A: 0, C: 1, G: 3, T: 2
+            code = ( code >> 1 ) ? ( code ^ 1 ) : code;          // A: 0, C: 1, G: 2, T: 3
+            packed_seqs[ start + i / 4 ] |= static_cast< char >( code << ( 2 * ( i % 4 ) ) );
+          }
+          pos += len;
+        }
+        seqs.swap( packed_seqs );
+        return true;
+      }
+
+        inline void
+      flush_block( )
+      {
+        if ( this->lengths[ 0 ].empty() ) return;
+        cache::Block block;
+        block.nrecords = static_cast< std::uint32_t >( this->lengths[ 0 ].size() );
+        block.flags = ( this->packed && this->pack_sequences() ) ? cache::PACKED : 0;
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) block.sizes[ i ] = this->columns[ i ].size();
+        this->index.push_back( { this->offset, this->nrecords } );
+        this->put( &block, sizeof( block ) );
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          this->put( this->lengths[ i ].data(), this->lengths[ i ].size() * sizeof( std::uint32_t ) );
+        }
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          this->put( this->columns[ i ].data(), this->columns[ i ].size() );
+        }
+        static const char padding[ 8 ] = { 0 };
+        this->put( padding, ( 8 - this->offset % 8 ) % 8 );
+        this->nrecords += block.nrecords;
+        this->clear_block();
+      }
+  };
+
+  /**
+   *  @brief  Cache file reader.
+   *
+   *  The file is mapped into memory; records are returned as views by `next`, or
+   *  copied by `operator>>`. The constructor throws `std::runtime_error` if the
+   *  file cannot be mapped or is not a valid cache file.
+   */
+  class KCacheReader {
+    public:
+      /* Typedefs */
+      using size_type = std::uint64_t;
+      /* Lifecycle */
+      explicit KCacheReader( const char* filename )
+        : data( nullptr ), length( 0 ), block( 0 ), record( 0 ), in_block( 0 ), good( true )
+      {
+        int fd = ::open( filename, O_RDONLY );
+        if ( fd == -1 ) throw std::runtime_error( "cannot open '" + std::string( filename ) + "'" );
+        struct stat st;
+        if ( ::fstat( fd, &st ) == 0 && st.st_size >= static_cast< off_t >( sizeof( cache::Header ) ) ) {
+          this->length = st.st_size;
+          void* addr = ::mmap( nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0 );
+          if ( addr != MAP_FAILED ) this->data = static_cast< const char* >( addr );
+        }
+        ::close( fd );
+        if ( this->data == nullptr ) throw std::runtime_error( "cannot map '" + std::string( filename ) + "'" );
+#ifdef MADV_SEQUENTIAL
+        ::madvise( const_cast< char* >( this->data ), this->length, MADV_SEQUENTIAL );
+#endif
+        std::memcpy( &this->header, this->data, sizeof( this->header ) );
+        if ( std::memcmp( this->header.magic, cache::MAGIC, sizeof( cache::MAGIC ) ) != 0 ||
+             this->header.version != cache::VERSION ||
+             this->header.checksum != cache::header_checksum( this->header ) ||
+             this->header.index > this->length ||
+             this->header.nblocks > ( this->length - this->header.index ) / sizeof( cache::IndexEntry ) ) {
+          this->unmap();
+          throw std::runtime_error( "'" + std::string( filename ) + "' is not a valid cache file" );
+        }
+        this->index = reinterpret_cast< const cache::IndexEntry* >( this->data + this->header.index );
+        this->load_block();
+      }
+
+      KCacheReader( KCacheReader const& ) = delete;
+      KCacheReader& operator=( KCacheReader const& ) = delete;
+
+      ~KCacheReader( ) noexcept
+      {
+        this->unmap();
+      }
+      /* Accessors */
+      /**
+       *  @brief  Total number of records.
+       */
+        inline size_type
+      size( ) const
+      {
+        return this->header.nrecords;
+      }
+
+      /**
+       *  @brief  Index of the next record.
+       */
+        inline size_type
+      tell( ) const
+      {
+        return this->record;
+      }
+      /* Methods */
+        inline bool
+      eof( ) const
+      {
+        return this->record >= this->header.nrecords;
+      }
+
+      operator bool( ) const
+      {
+        return this->good;
+      }
+
+      /**
+       *  @brief  Get the next record as a view into the mapping.
+       *
+       *  @return `false` if there is no more record.
+       */
+        inline bool
+      next( KCacheRecord& rec )
+      {
+        if ( this->eof() ) return false;
+        if ( this->in_block == this->blk.nrecords ) {
+          ++this->block;
+          this->load_block();
+          // a corrupted (or empty) block leaves the previous block's columns behind
+          if ( this->eof() || this->blk.nrecords == 0 ) return false;
+        }
+        const char** fields[ cache::NCOLUMNS ] = { &rec.name, &rec.comment, &rec.seq, &rec.qual };
+        KCacheRecord::size_type* lens[ cache::NCOLUMNS ] = { &rec.name_len, &rec.comment_len,
+                                                             &rec.seq_len, &rec.qual_len };
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          *lens[ i ] = this->lengths[ i ][ this->in_block ];
+          *fields[ i ] = this->columns[ i ] + this->pos[ i ];
+          this->pos[ i ] += *lens[ i ];
+        }
+        if ( this->blk.flags & cache::PACKED ) {
+          this->pos[ 2 ] += cache::packed_size( rec.seq_len ) - rec.seq_len;
+          rec.buffer.clear();
+          cache::unpack( reinterpret_cast< const unsigned char* >( rec.seq ), rec.seq_len, rec.buffer );
+          rec.seq = rec.buffer.data();
+        }
+        ++this->in_block;
+        ++this->record;
+        return true;
+      }
+
+        inline KCacheReader&
+      operator>>( KSeq& rec )
+      {
+        if ( this->next( this->view ) ) this->view.get( rec );
+        else this->good = false;
+        return *this;
+      }
+
+      /**
+       *  @brief  Move to the record with the given index using the block index.
+       */
+        inline void
+      seek( size_type idx )
+      {
+        if ( this->header.nblocks == 0 ) return;
+        idx = std::min( idx, this->header.nrecords );
+        const cache::IndexEntry* last = this->index + this->header.nblocks;
+        const cache::IndexEntry* e = std::upper_bound( this->index, last, idx,
+            []( size_type i, cache::IndexEntry const& entry ) { return i < entry.first; } );
+        this->block = ( e - this->index ) - 1;
+        this->good = true;
+        this->load_block();  // unset `good` if the block is corrupted
+        KCacheRecord rec;
+        while ( this->record < idx && this->next( rec ) );
+      }
+    private:
+      /* Data members */
+      const char* data;                                  /**< @brief mapped file */
+      size_type length;                                  /**< @brief mapped size */
+      cache::Header header;                              /**< @brief file header */
+      const cache::IndexEntry* index;                    /**< @brief block index */
+      size_type block;                                   /**< @brief current block */
+      size_type record;                                  /**< @brief index of the next record */
+      cache::Block blk;                                  /**< @brief current block header */
+      std::uint32_t in_block;                            /**< @brief index of the next record in the block */
+      const std::uint32_t* lengths[ cache::NCOLUMNS ];   /**< @brief length columns of the block */
+      const char* columns[ cache::NCOLUMNS ];            /**< @brief byte columns of the block */
+      size_type pos[ cache::NCOLUMNS ];                  /**< @brief offsets of the next fields in the columns */
+      KCacheRecord view;                                 /**< @brief record view used by `operator>>` */
+      bool good;                                         /**< @brief state of the last read */
+      /* Methods */
+        inline void
+      unmap( )
+      {
+        if ( this->data != nullptr ) ::munmap( const_cast< char* >( this->data ), this->length );
+        this->data = nullptr;
+      }
+
+      /**
+       *  @brief  Check that the block lies within the file and its field lengths
+       *  add up to the size of each column.
+       */
+        inline bool
+      valid_block( cache::IndexEntry const& entry ) const
+      {
+        if ( entry.offset > this->header.index ||
+             this->header.index - entry.offset < sizeof( cache::Block ) ) return false;
+        cache::Block b;
+        std::memcpy( &b, this->data + entry.offset, sizeof( b ) );
+        size_type avail = this->header.index - entry.offset - sizeof( b );
+        size_type need = static_cast< size_type >( b.nrecords ) * cache::NCOLUMNS * sizeof( std::uint32_t );
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          if ( b.sizes[ i ] > avail ) return false;
+          need += b.sizes[ i ];
+        }
+        if ( need > avail ) return false;
+        // the fields should exactly fill their columns
+        const char* p = this->data + entry.offset + sizeof( b );
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          bool packed = ( i == 2 && ( b.flags & cache::PACKED ) );
+          std::uint64_t sum = 0;
+          for ( std::uint32_t j = 0; j < b.nrecords; ++j ) {
+            std::uint32_t len;
+            std::memcpy( &len, p, sizeof( len ) );
+            p += sizeof( len );
+            sum += packed ? cache::packed_size( len ) : len;
+          }
+          if ( sum != b.sizes[ i ] ) return false;
+        }
+        return true;
+      }
+
+        inline void
+      load_block( )
+      {
+        this->in_block = 0;
+        this->blk = cache::Block();
+        if ( this->block >= this->header.nblocks ) return;
+        cache::IndexEntry const& entry = this->index[ this->block ];
+        this->record = entry.first;
+        if ( !this->valid_block( entry ) ) {  // truncated or corrupted file
+          this->blk = cache::Block();
+          this->record = this->header.nrecords;
+          this->good = false;
+          return;
+        }
+        const char* p = this->data + entry.offset;
+        std::memcpy( &this->blk, p, sizeof( this->blk ) );
+        p += sizeof( this->blk );
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          this->lengths[ i ] = reinterpret_cast< const std::uint32_t* >( p );
+          p += this->blk.nrecords * sizeof( std::uint32_t );
+        }
+        for ( std::uint32_t i = 0; i < cache::NCOLUMNS; ++i ) {
+          this->columns[ i ] = p;
+          this->pos[ i ] = 0;
+          p += this->blk.sizes[ i ];
+        }
+      }
+  };
+
+  /**
+   *  @brief  Convert the remaining records of an input stream to a cache file.
+   *
+   *  @return the number of converted records.
+   */
+  template< typename TStream >
+      inline KCacheWriter::size_type
+    to_cache( TStream& in, KCacheWriter& out )
+    {
+      KCacheWriter::size_type count = 0;
+      KSeq rec;
+      while ( in >> rec ) {
+        out << rec;
+        ++count;
+      }
+      return count;
+    }
+
+  /**
+   *  @brief  Write the remaining records of a cache file to an output stream.
+   *
+   *  @return the number of written records.
+   */
+  template< typename TStream >
+      inline KCacheReader::size_type
+    from_cache( KCacheReader& in, TStream& out )
+    {
+      KCacheReader::size_type count = 0;
+      KSeq rec;
+      while ( in >> rec ) {
+        out << rec;
+        ++count;
+      }
+      return count;
+    }
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_CACHE_HPP__  ----- */
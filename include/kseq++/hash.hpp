@@ -0,0 +1,189 @@
+/**
+ *    @file  hash.hpp
+ *   @brief  Streaming duplicate detection.
+ *
+ *  This header file defines `KDedup` class which remembers the hashes of the
+ *  sequences seen so far within a fixed memory budget, and `read_unique` which
+ *  skips the records (or pairs) whose sequences have been seen before.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:24
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_HASH_HPP__
+#define  KSEQPP_HASH_HPP__
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  namespace dedup {
+    /**
+     *  @brief  Duplicate detection mode.
+     *
+     *  - `exact`: an open-addressing table of 64-bit hashes. Once the table is
+     *    full, new hashes are no longer remembered; so a later duplicate of them
+     *    passes, but a unique record is never rejected (up to hash collisions).
+     *  - `bloom`: a Bloom filter which remembers any number of hashes; a unique
+     *    record is rejected with a probability growing with the number of
+     *    records per bit.
+     */
+    enum Mode { exact, bloom };
+  }  /* -----  end of namespace dedup  ----- */
+
+  /**
+   *  @brief  Set of sequence hashes within a fixed memory budget.
+   */
+  class KDedup {
+    public:
+      /* Typedefs */
+      using size_type = std::vector< std::uint64_t >::size_type;
+      /* Consts */
+      constexpr static unsigned int BLOOM_NHASH = 4;  /**< @brief number of bits set per hash in `bloom` mode */
+      /* Lifecycle */
+      /**
+       *  @brief  Remember hashes in at most `budget` bytes.
+       *
+       *  The table size is the largest power of two fitting in the budget.
+       */
+      explicit KDedup( size_type budget, dedup::Mode mode_=dedup::exact )
+        : mode( mode_ ), count( 0 ), nmissed( 0 )
+      {
+        size_type n = 1;
+        while ( 2 * n * sizeof( std::uint64_t ) <= budget ) n *= 2;
+        if ( n * sizeof( std::uint64_t ) > budget ) throw std::invalid_argument( "memory budget is too small" );
+        this->table.resize( n, 0 );
+        this->mask = n - 1;
+        this->max_count = n - n / 4;  // load factor of 3/4
+      }
+      /* Accessors */
+      /**
+       *  @brief  Number of distinct hashes inserted so far.
+       */
+        inline size_type
+      size( ) const
+      {
+        return this->count;
+      }
+
+      /**
+       *  @brief  Number of new hashes not remembered since the table was full (`exact` mode).
+       */
+        inline size_type
+      missed( ) const
+      {
+        return this->nmissed;
+      }
+
+        inline bool
+      saturated( ) const
+      {
+        return this->mode == dedup::exact && this->count >= this->max_count;
+      }
+      /* Methods */
+      /**
+       *  @brief  Insert a hash.
+       *
+       *  @return `true` if the hash has not been seen before; i.e. the record is
+       *  unique so far.
+       */
+        inline bool
+      insert( std::uint64_t h )
+      {
+        if ( this->mode == dedup::bloom ) return this->insert_bloom( h );
+        if ( h == 0 ) h = 1;  // zero marks empty slots
+        for ( size_type i = h & this->mask; ; i = ( i + 1 ) & this->mask ) {
+          if ( this->table[ i ] == h ) return false;
+          if ( this->table[ i ] == 0 ) {
+            if ( this->count >= this->max_count ) {
+              ++this->nmissed;
+              return true;
+            }
+            this->table[ i ] = h;
+            ++this->count;
+            return true;
+          }
+        }
+      }
+
+        inline void
+      clear( )
+      {
+        std::fill( this->table.begin(), this->table.end(), 0 );
+        this->count = 0;
+        this->nmissed = 0;
+      }
+    private:
+      /* Data members */
+      std::vector< std::uint64_t > table;  /**< @brief hash table or Bloom filter words */
+      dedup::Mode mode;                    /**< @brief detection mode */
+      size_type mask;                      /**< @brief table size minus one */
+      size_type max_count;                 /**< @brief maximum number of hashes in `exact` mode */
+      size_type count;                     /**< @brief number of distinct hashes inserted */
+      size_type nmissed;                   /**< @brief number of hashes not remembered */
+      /* Methods */
+        inline bool
+      insert_bloom( std::uint64_t h )
+      {
+        // double hashing: the bit positions are derived from the two halves of the hash
+        std::uint64_t h1 = h;
+        std::uint64_t h2 = ( h >> 32 ) | ( h << 32 ) | 1;
+        std::uint64_t nbits = static_cast< std::uint64_t >( this->table.size() ) * 64;
+        bool seen = true;
+        for ( unsigned int i = 0; i < BLOOM_NHASH; ++i ) {
+          std::uint64_t bit = ( h1 + i * h2 ) & ( nbits - 1 );
+          std::uint64_t& word = this->table[ bit >> 6 ];
+          std::uint64_t flag = std::uint64_t( 1 ) << ( bit & 63 );
+          seen &= ( ( word & flag ) != 0 );
+          word |= flag;
+        }
+        if ( !seen ) ++this->count;
+        return !seen;
+      }
+  };
+
+  /* Set hashing on an input stream if possible */
+  template< typename TStream >
+      inline auto
+    enable_hashing_( TStream& ks, int ) -> decltype( ks.set_hashing(), void() )
+    {
+      if ( !ks.is_hashing() ) ks.set_hashing();
+    }
+
+  template< typename TStream >
+      inline void
+    enable_hashing_( TStream&, long )
+    { }
+
+  /**
+   *  @brief  Read the next record (or pair) whose sequence has not been seen before.
+   *
+   *  The sequence hash is computed by the stream while parsing; so hashing is set
+   *  on an input stream if it is not already. For a `KPairedStreamIn`, hashing
+   *  should be set on both streams before being passed to its constructor; then
+   *  a pair is a duplicate if both of its mates are the same as a previous pair.
+   *  The number of skipped records can be obtained by comparing `counts()` with
+   *  the number of the returned ones.
+   */
+  template< typename TStream, typename TRecord >
+      inline TStream&
+    read_unique( TStream& ks, TRecord& rec, KDedup& seen )
+    {
+      enable_hashing_( ks, 0 );
+      if ( !ks.is_hashing() ) throw std::invalid_argument( "the stream does not hash the sequences" );
+      while ( ks >> rec ) {
+        if ( seen.insert( ks.hash() ) ) break;
+      }
+      return ks;
+    }
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_HASH_HPP__  ----- */
@@ -0,0 +1,472 @@
+/**
+ *    @file  header.hpp
+ *   @brief  Structured header fields.
+ *
+ *  This header file defines `KHeader` class, a lazily decoded view of the
+ *  fields encoded in the name and the comment of a record by common sequencing
+ *  platforms: Illumina, Oxford Nanopore (ONT), and PacBio.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:36
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_HEADER_HPP__
+#define  KSEQPP_HEADER_HPP__
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  namespace header {
+    /**
+     *  @brief  Header layout.
+     *
+     *  - `illumina`: "INSTRUMENT:RUN:FLOWCELL:LANE:TILE:X:Y[:UMI]" name and
+     *    "READ:FILTERED:CONTROL:INDEX" comment (CASAVA 1.8 and later).
+     *  - `pacbio`: "MOVIE/ZMW/START_END" (subreads) or "MOVIE/ZMW/ccs" name.
+     *  - `ont`: space-separated "key=value" comment (e.g. "runid=... ch=...").
+     */
+    enum Layout { unknown, illumina, pacbio, ont };
+  }  /* -----  end of namespace header  ----- */
+
+  /**
+   *  @brief  View of a part of a header; it is not NUL-terminated.
+   */
+  struct KHeaderField {
+    /* Typedefs */
+    using size_type = std::string::size_type;
+    /* Data members */
+    const char* data = nullptr;
+    size_type size = 0;
+    /* Methods */
+      inline bool
+    empty( ) const
+    {
+      return this->size == 0;
+    }
+
+      inline std::string
+    str( ) const
+    {
+      return std::string( this->data, this->size );
+    }
+
+      inline bool
+    operator==( const char* s ) const
+    {
+      return std::strlen( s ) == this->size && std::memcmp( this->data, s, this->size ) == 0;
+    }
+
+    /**
+     *  @brief  Decimal value of the field; parsing stops at the first non-digit.
+     */
+      inline unsigned long int
+    to_ulong( ) const
+    {
+      unsigned long int value = 0;
+      for ( size_type i = 0; i < this->size && this->data[ i ] >= '0' && this->data[ i ] <= '9'; ++i ) {
+        value = value * 10 + ( this->data[ i ] - '0' );
+      }
+      return value;
+    }
+  };
+
+  /**
+   *  @brief  Lazily decoded header fields of a record.
+   *
+   *  The separators of the name (':' and '/') and of the comment (' ', ':' and
+   *  '=') are located while the header is being parsed by `read_header`: its
+   *  sinks record the separator positions as the bytes pass through them. The
+   *  accessors then only index into the name and the comment without searching
+   *  them. The view refers to the strings of the record; so it is valid until
+   *  the record is modified.
+   */
+  class KHeader {
+    public:
+      /* Typedefs */
+      using size_type = std::string::size_type;
+      using field_type = KHeaderField;
+      /* Nested classes */
+      /**
+       *  @brief  Sink wrapper recording the separator positions of the name.
+       */
+      template< typename TSink >
+        class NameSink {
+          public:
+            NameSink( TSink& sink_, KHeader& hdr_ ) : sink( sink_ ), hdr( hdr_ ) { }
+              inline size_type
+            size( ) const
+            {
+              return this->sink.size();
+            }
+
+              inline void
+            append( const char* s, size_type n )
+            {
+              this->hdr.scan_name( s, n, this->sink.size() );
+              this->sink.append( s, n );
+            }
+          private:
+            TSink& sink;
+            KHeader& hdr;
+        };
+
+      /**
+       *  @brief  Sink wrapper recording the separator positions of the comment.
+       */
+      template< typename TSink >
+        class CommentSink {
+          public:
+            CommentSink( TSink& sink_, KHeader& hdr_ ) : sink( sink_ ), hdr( hdr_ ) { }
+              inline size_type
+            size( ) const
+            {
+              return this->sink.size();
+            }
+
+              inline void
+            append( const char* s, size_type n )
+            {
+              this->hdr.scan_comment( s, n, this->sink.size() );
+              this->sink.append( s, n );
+            }
+          private:
+            TSink& sink;
+            KHeader& hdr;
+        };
+      /* Lifecycle */
+      KHeader( ) : name( nullptr ), comment( nullptr ) { }
+      /* Accessors */
+        inline header::Layout
+      layout( ) const
+      {
+        if ( this->colons.size() >= 6 ) return header::illumina;
+        if ( this->slashes.size() == 2 ) return header::pacbio;
+        if ( !this->equals.empty() ) return header::ont;
+        return header::unknown;
+      }
+
+      /* Illumina name fields */
+        inline field_type
+      instrument( ) const
+      {
+        return this->name_field( this->colons, 0 );
+      }
+
+        inline field_type
+      run( ) const
+      {
+        return this->name_field( this->colons, 1 );
+      }
+
+        inline field_type
+      flowcell( ) const
+      {
+        return this->name_field( this->colons, 2 );
+      }
+
+        inline field_type
+      lane( ) const
+      {
+        return this->name_field( this->colons, 3 );
+      }
+
+        inline field_type
+      tile( ) const
+      {
+        return this->name_field( this->colons, 4 );
+      }
+
+        inline field_type
+      x( ) const
+      {
+        return this->name_field( this->colons, 5 );
+      }
+
+        inline field_type
+      y( ) const
+      {
+        return this->name_field( this->colons, 6 );
+      }
+
+        inline field_type
+      umi( ) const
+      {
+        return this->name_field( this->colons, 7 );
+      }
+
+      /* Illumina comment fields */
+        inline field_type
+      read( ) const
+      {
+        return this->comment_field( 0 );
+      }
+
+        inline field_type
+      filter( ) const
+      {
+        return this->comment_field( 1 );
+      }
+
+      /**
+       *  @brief  Whether the read is filtered (`Y` filter flag).
+       */
+        inline bool
+      is_filtered( ) const
+      {
+        return this->filter() == "Y";
+      }
+
+        inline field_type
+      control( ) const
+      {
+        return this->comment_field( 2 );
+      }
+
+        inline field_type
+      index( ) const
+      {
+        return this->comment_field( 3 );
+      }
+
+      /* PacBio name fields */
+        inline field_type
+      movie( ) const
+      {
+        return this->name_field( this->slashes, 0 );
+      }
+
+        inline field_type
+      zmw( ) const
+      {
+        return this->name_field( this->slashes, 1 );
+      }
+
+      /**
+       *  @brief  Subread range "START_END" or "ccs".
+       */
+        inline field_type
+      range( ) const
+      {
+        return this->name_field( this->slashes, 2 );
+      }
+
+        inline bool
+      is_ccs( ) const
+      {
+        return this->range() == "ccs";
+      }
+
+        inline field_type
+      range_start( ) const
+      {
+        field_type r = this->range();
+        if ( r.empty() ) return field_type();
+        const char* sep = static_cast< const char* >( std::memchr( r.data, '_', r.size ) );
+        if ( sep == nullptr ) return field_type();
+        return this->make( r.data, sep - r.data );
+      }
+
+        inline field_type
+      range_end( ) const
+      {
+        field_type r = this->range();
+        if ( r.empty() ) return field_type();
+        const char* sep = static_cast< const char* >( std::memchr( r.data, '_', r.size ) );
+        if ( sep == nullptr ) return field_type();
+        return this->make( sep + 1, r.data + r.size - sep - 1 );
+      }
+
+      /* ONT comment fields */
+      /**
+       *  @brief  Number of space-separated tokens in the comment.
+       */
+        inline size_type
+      ntokens( ) const
+      {
+        if ( this->comment == nullptr || this->comment->empty() ) return 0;
+        return this->spaces.size() + 1;
+      }
+
+        inline field_type
+      token( size_type i ) const
+      {
+        if ( i >= this->ntokens() ) return field_type();
+        size_type begin = ( i == 0 ) ? 0 : this->spaces[ i - 1 ] + 1;
+        size_type end = ( i == this->spaces.size() ) ? this->comment->size() : this->spaces[ i ];
+        return this->make( this->comment->data() + begin, end - begin );
+      }
+
+      /**
+       *  @brief  Value of the "key=value" token with the given key (empty if not found).
+       */
+        inline field_type
+      value( const char* key ) const
+      {
+        if ( this->comment == nullptr ) return field_type();
+        size_type len = std::strlen( key );
+        for ( size_type eq : this->equals ) {  // each '=' ends a key
+          size_type begin = this->token_begin( eq );
+          if ( eq - begin != len || std::memcmp( this->comment->data() + begin, key, len ) != 0 ) continue;
+          size_type end = this->token_end( eq );
+          return this->make( this->comment->data() + eq + 1, end - eq - 1 );
+        }
+        return field_type();
+      }
+      /* Methods */
+      /**
+       *  @brief  Tokenise the header of a record which is already parsed.
+       */
+      template< typename TString >
+          inline void
+        assign( BasicKSeq< TString > const& rec )
+        {
+          this->clear();
+          this->scan_name( rec.name.data(), rec.name.size(), 0 );
+          this->scan_comment( rec.comment.data(), rec.comment.size(), 0 );
+          this->bind( rec.name, rec.comment );
+        }
+
+      /**
+       *  @brief  Refer to the given strings whose separators have been scanned.
+       */
+        inline void
+      bind( std::string const& name_, std::string const& comment_ )
+      {
+        this->name = &name_;
+        this->comment = &comment_;
+      }
+
+        inline void
+      clear( )
+      {
+        this->colons.clear();
+        this->slashes.clear();
+        this->spaces.clear();
+        this->ccolons.clear();
+        this->equals.clear();
+        this->name = nullptr;
+        this->comment = nullptr;
+      }
+
+        inline void
+      scan_name( const char* s, size_type n, size_type offset )
+      {
+        for ( size_type i = 0; i < n; ++i ) {
+          if ( s[ i ] == ':' ) this->colons.push_back( offset + i );
+          else if ( s[ i ] == '/' ) this->slashes.push_back( offset + i );
+        }
+      }
+
+        inline void
+      scan_comment( const char* s, size_type n, size_type offset )
+      {
+        for ( size_type i = 0; i < n; ++i ) {
+          if ( s[ i ] == ' ' ) this->spaces.push_back( offset + i );
+          else if ( s[ i ] == '=' ) this->equals.push_back( offset + i );
+          else if ( s[ i ] == ':' && this->spaces.empty() ) this->ccolons.push_back( offset + i );
+        }
+      }
+    private:
+      /* Data members */
+      std::vector< size_type > colons;   /**< @brief positions of ':' in the name */
+      std::vector< size_type > slashes;  /**< @brief positions of '/' in the name */
+      std::vector< size_type > spaces;   /**< @brief positions of ' ' in the comment */
+      std::vector< size_type > ccolons;  /**< @brief positions of ':' in the first comment token */
+      std::vector< size_type > equals;   /**< @brief positions of '=' in the comment */
+      std::string const* name;           /**< @brief name of the record */
+      std::string const* comment;        /**< @brief comment of the record */
+      /* Methods */
+        static inline field_type
+      make( const char* data, size_type size )
+      {
+        field_type f;
+        f.data = data;
+        f.size = size;
+        return f;
+      }
+
+      /**
+       *  @brief  The i-th part of a string split by the separators at the given positions.
+       */
+        static inline field_type
+      split( std::string const* str, std::vector< size_type > const& seps, size_type end, size_type i )
+      {
+        if ( str == nullptr || i > seps.size() ) return field_type();
+        size_type begin = ( i == 0 ) ? 0 : seps[ i - 1 ] + 1;
+        size_type last = ( i == seps.size() ) ? end : seps[ i ];
+        return make( str->data() + begin, last - begin );
+      }
+
+        inline field_type
+      name_field( std::vector< size_type > const& seps, size_type i ) const
+      {
+        if ( this->name == nullptr ) return field_type();
+        return split( this->name, seps, this->name->size(), i );
+      }
+
+        inline field_type
+      comment_field( size_type i ) const
+      {
+        if ( this->comment == nullptr || this->comment->empty() ) return field_type();
+        size_type end = this->spaces.empty() ? this->comment->size() : this->spaces[ 0 ];
+        return split( this->comment, this->ccolons, end, i );
+      }
+
+      /* Begin of the comment token containing the given position. */
+        inline size_type
+      token_begin( size_type pos ) const
+      {
+        size_type begin = 0;
+        for ( size_type sp : this->spaces ) {
+          if ( sp > pos ) break;
+          begin = sp + 1;
+        }
+        return begin;
+      }
+
+      /* End of the comment token containing the given position. */
+        inline size_type
+      token_end( size_type pos ) const
+      {
+        for ( size_type sp : this->spaces ) {
+          if ( sp > pos ) return sp;
+        }
+        return this->comment->size();
+      }
+  };
+
+  /**
+   *  @brief  Read the next record and tokenise its header into the given view.
+   *
+   *  The separators are recorded by the sinks while the name and the comment
+   *  are parsed. Note that the record is parsed by `KStreamIn::parse`; so
+   *  filters, subsampling, field selection, and validation set on the stream
+   *  are not applied, nor is the quality map.
+   *
+   *  @return the stream whose state should be checked as for `operator>>`.
+   */
+  template< typename TStream >
+      inline TStream&
+    read_header( TStream& ks, KSeq& rec, KHeader& hdr )
+    {
+      rec.clear();
+      hdr.clear();
+      KFieldSink< std::string > name( rec.name ), comment( rec.comment ), seq( rec.seq ), qual( rec.qual );
+      KHeader::NameSink< KFieldSink< std::string > > hname( name, hdr );
+      KHeader::CommentSink< KFieldSink< std::string > > hcomment( comment, hdr );
+      ks.parse( hname, hcomment, seq, qual );
+      hdr.bind( rec.name, rec.comment );
+      return ks;
+    }
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_HEADER_HPP__  ----- */
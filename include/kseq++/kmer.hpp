@@ -0,0 +1,307 @@
+/**
+ *    @file  kmer.hpp
+ *   @brief  Streaming k-mer and minimizer extraction.
+ *
+ *  This header file defines sinks which extract canonical k-mers and (w,k)
+ *  minimizers from the sequence of a record while it is being parsed; i.e.
+ *  directly from the stream buffer without storing the sequence.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:21
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_KMER_HPP__
+#define  KSEQPP_KMER_HPP__
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  namespace kmer {
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128_t;  /**< @brief k-mers of up to 64 bases */
+#endif
+
+    /**
+     *  @brief  2-bit code of a nucleotide: A, C, G, T/U (in either case) to 0-3; others to 4.
+     */
+      inline unsigned char
+    nt4( char c )
+    {
+      static const unsigned char table[ 256 ] = {
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 0, 4, 1, 4, 4, 4, 2, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 0, 4, 1, 4, 4, 4, 2, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4
+      };
+      return table[ static_cast< unsigned char >( c ) ];
+    }
+
+    /**
+     *  @brief  Invertible integer hash of a k-mer (Thomas Wang's 64-bit mix).
+     */
+      inline std::uint64_t
+    hash( std::uint64_t key )
+    {
+      key = ~key + ( key << 21 );
+      key = key ^ key >> 24;
+      key = ( key + ( key << 3 ) ) + ( key << 8 );
+      key = key ^ key >> 14;
+      key = ( key + ( key << 2 ) ) + ( key << 4 );
+      key = key ^ key >> 28;
+      key = key + ( key << 31 );
+      return key;
+    }
+
+#ifdef __SIZEOF_INT128__
+      inline std::uint64_t
+    hash( uint128_t key )
+    {
+      return hash( static_cast< std::uint64_t >( key ) ^
+                   hash( static_cast< std::uint64_t >( key >> 64 ) ) );
+    }
+#endif
+  }  /* -----  end of namespace kmer  ----- */
+
+  /**
+   *  @brief  Sink extracting the canonical k-mers of a sequence.
+   *
+   *  The bases are 2-bit encoded and rolled into the forward and the reverse
+   *  complement k-mers as they arrive; so k-mers spanning line breaks or buffer
+   *  refills are found without copying the sequence. A non-ACGT base (e.g. N)
+   *  restarts the k-mers after it. For each k-mer, `callback( kmer, pos )` is
+   *  called with the smaller of the two strands and the k-mer position in the
+   *  sequence. `TKmer` should be an unsigned integer of at least 2k bits; i.e.
+   *  `std::uint64_t` for k <= 32 or `kmer::uint128_t` for k <= 64.
+   *
+   *  The sink should be `reset()` before each record.
+   */
+  template< typename TCallback, typename TKmer=std::uint64_t >
+    class KKmerSink {
+      public:
+        /* Typedefs */
+        using kmer_type = TKmer;
+        using callback_type = TCallback;
+        using size_type = std::string::size_type;
+        /* Lifecycle */
+        KKmerSink( unsigned int k_, callback_type callback_ )
+          : k( k_ ), callback( std::move( callback_ ) ), len( 0 ), run( 0 ),
+          fwd( 0 ), rev( 0 )
+        {
+          if ( this->k == 0 || this->k > 4 * sizeof( kmer_type ) ) {
+            throw std::invalid_argument( "k-mer length is out of range" );
+          }
+          this->shift = 2 * ( this->k - 1 );
+          this->mask = ( this->k == 4 * sizeof( kmer_type ) ) ?
+            ~kmer_type( 0 ) : ( kmer_type( 1 ) << ( 2 * this->k ) ) - 1;
+        }
+        /* Accessors */
+          inline size_type
+        size( ) const
+        {
+          return this->len;
+        }
+
+          inline unsigned int
+        get_k( ) const
+        {
+          return this->k;
+        }
+        /* Methods */
+          inline void
+        append( const char* s, size_type n )
+        {
+          for ( size_type i = 0; i < n; ++i ) {
+            kmer_type c = kmer::nt4( s[ i ] );
+            if ( c > 3 ) {
+              this->run = 0;
+              continue;
+            }
+            this->fwd = ( ( this->fwd << 2 ) | c ) & this->mask;
+            this->rev = ( this->rev >> 2 ) | ( ( 3 ^ c ) << this->shift );
+            if ( ++this->run >= this->k ) {
+              this->callback( this->fwd < this->rev ? this->fwd : this->rev,
+                              this->len + i + 1 - this->k );
+            }
+          }
+          this->len += n;
+        }
+
+          inline void
+        reset( )
+        {
+          this->len = 0;
+          this->run = 0;
+        }
+      private:
+        /* Data members */
+        unsigned int k;           /**< @brief k-mer length */
+        unsigned int shift;       /**< @brief bit offset of the first base of the reverse k-mer */
+        kmer_type mask;           /**< @brief mask of the 2k lower bits */
+        callback_type callback;   /**< @brief k-mer consumer */
+        size_type len;            /**< @brief number of bases consumed so far */
+        size_type run;            /**< @brief number of consecutive ACGT bases so far */
+        kmer_type fwd;            /**< @brief forward k-mer */
+        kmer_type rev;            /**< @brief reverse complement k-mer */
+    };
+
+  /**
+   *  @brief  Sink extracting the (w,k) minimizers of a sequence.
+   *
+   *  A minimizer is the canonical k-mer with the smallest hash value in a window
+   *  of `w` consecutive k-mers (the leftmost one on ties). Each minimizer is
+   *  reported once by `callback( kmer, pos )` when it is selected for the first
+   *  time. The window restarts after a non-ACGT base.
+   *
+   *  The sink should be `reset()` before each record.
+   */
+  template< typename TCallback, typename TKmer=std::uint64_t >
+    class KMinimizerSink {
+      public:
+        /* Typedefs */
+        using kmer_type = TKmer;
+        using callback_type = TCallback;
+        using size_type = std::string::size_type;
+        /* Lifecycle */
+        KMinimizerSink( unsigned int k_, unsigned int w_, callback_type callback_ )
+          : kmers( k_, Push_{ this } ), callback( std::move( callback_ ) ), window( w_ ),
+          count( 0 ), head( 0 ), next( 0 ), last( npos )
+        {
+          if ( w_ == 0 ) throw std::invalid_argument( "window size should be positive" );
+        }
+
+        KMinimizerSink( KMinimizerSink const& ) = delete;
+        KMinimizerSink& operator=( KMinimizerSink const& ) = delete;
+        /* Accessors */
+          inline size_type
+        size( ) const
+        {
+          return this->kmers.size();
+        }
+        /* Methods */
+          inline void
+        append( const char* s, size_type n )
+        {
+          this->kmers.append( s, n );
+        }
+
+          inline void
+        reset( )
+        {
+          this->kmers.reset();
+          this->count = 0;
+          this->last = npos;
+        }
+      private:
+        /* Consts */
+        constexpr static size_type npos = std::string::npos;
+        /* Nested classes */
+        struct Entry_ {
+          std::uint64_t hash;
+          kmer_type kmer;
+          size_type pos;
+        };
+
+        struct Push_ {
+          KMinimizerSink* self;
+            inline void
+          operator()( kmer_type km, size_type pos ) const
+          {
+            self->push( km, pos );
+          }
+        };
+        /* Data members */
+        KKmerSink< Push_, kmer_type > kmers;  /**< @brief k-mer extractor */
+        callback_type callback;               /**< @brief minimizer consumer */
+        std::vector< Entry_ > window;         /**< @brief ring buffer of the last `w` k-mers */
+        size_type count;                      /**< @brief number of k-mers in the current run */
+        size_type head;                       /**< @brief next slot in the ring buffer */
+        size_type next;                       /**< @brief position of the next k-mer in the same run */
+        size_type last;                       /**< @brief position of the last reported minimizer */
+        Entry_ min;                           /**< @brief minimum of the current window */
+        /* Methods */
+          inline void
+        push( kmer_type km, size_type pos )
+        {
+          size_type w = this->window.size();
+          if ( pos != this->next ) this->count = 0;  // a new run after a non-ACGT base
+          this->next = pos + 1;
+          Entry_ e = { kmer::hash( km ), km, pos };
+          if ( this->count == 0 ) this->head = 0;
+          this->window[ this->head ] = e;
+          if ( ++this->head == w ) this->head = 0;
+          ++this->count;
+          if ( this->count == 1 || e.hash < this->min.hash ) this->min = e;
+          else if ( this->count > w && this->min.pos + w <= pos ) {  // the minimum left the window
+            this->min = this->window[ this->head ];  // the oldest one
+            for ( size_type j = 1; j < w; ++j ) {
+              Entry_ const& cand = this->window[ ( this->head + j ) % w ];
+              if ( cand.hash < this->min.hash ) this->min = cand;
+            }
+          }
+          if ( this->count < w || this->min.pos == this->last ) return;
+          this->last = this->min.pos;
+          this->callback( this->min.kmer, this->min.pos );
+        }
+    };
+
+  template< typename TCallback, typename TKmer=std::uint64_t >
+      inline KKmerSink< TCallback, TKmer >
+    make_kmer_sink( unsigned int k, TCallback callback )
+    {
+      return KKmerSink< TCallback, TKmer >( k, std::move( callback ) );
+    }
+
+  /**
+   *  @brief  Parse the next record passing its sequence to the given k-mer sink.
+   *
+   *  The sink is reset first. Only the record boundaries are scanned for other
+   *  fields; the name is stored if requested. Note that the record is parsed by
+   *  `KStreamIn::parse`; so filters, subsampling and validation set on the
+   *  stream are not applied.
+   *
+   *  @return the stream whose state should be checked as for `operator>>`.
+   */
+  template< typename TStream, typename TSink >
+      inline TStream&
+    parse_kmers( TStream& ks, TSink& sink )
+    {
+      KSkipSink name, comment, qual;
+      sink.reset();
+      return ks.parse( name, comment, sink, qual );
+    }
+
+  template< typename TStream, typename TSink >
+      inline TStream&
+    parse_kmers( TStream& ks, std::string& name, TSink& sink )
+    {
+      name.clear();
+      KFieldSink< std::string > name_sink( name );
+      KSkipSink comment, qual;
+      sink.reset();
+      return ks.parse( name_sink, comment, sink, qual );
+    }
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_KMER_HPP__  ----- */
@@ -20,9 +20,21 @@
 
 #include <cassert>
 #include <cctype>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <ios>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <array>
+#include <memory>
+#include <random>
+#include <map>
 #include <vector>
 #include <string>
 #include <thread>
@@ -31,10 +43,44 @@
 
 #include "config.hpp"
 
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <unistd.h>
+#define KSEQPP_HAS_UNISTD 1
+#else
+#define KSEQPP_HAS_UNISTD 0
+#endif
+
+#if defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#define KSEQPP_HAS_AFFINITY 1
+#else
+#define KSEQPP_HAS_AFFINITY 0
+#endif
+
+#if defined( __x86_64__ ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#include <nmmintrin.h>
+#define KSEQPP_HAS_CRC32C_X86 1
+#elif defined( __ARM_FEATURE_CRC32 )
+#include <arm_acle.h>
+#define KSEQPP_HAS_CRC32C_ARM 1
+#endif
+
+#if defined( __has_include )
+#if __has_include( <memory_resource> ) && __cplusplus >= 201703L
+#include <memory_resource>
+#define KSEQPP_HAS_PMR 1
+#endif
+#endif
+#ifndef KSEQPP_HAS_PMR
+#define KSEQPP_HAS_PMR 0
+#endif
+
 namespace klibpp {
   template< typename TFile,
             typename TFunc,
-            typename TSpec >
+            typename TSpec,
+            typename TAlloc = std::allocator< char > >
               class KStream;
 
   class KStreamBase_ {
@@ -44,16 +90,81 @@ namespace klibpp {
       using char_type = char;
   };
 
-  struct KSeq {  // kseq_t
-    std::string name;
-    std::string comment;
-    std::string seq;
-    std::string qual;
+  /**
+   *  @brief  Sequence record with the given string type.
+   *
+   *  It is allocator-aware: the record can be constructed with an allocator
+   *  passed to all of its strings; e.g. records of type `pmr::KSeq` in a
+   *  `std::pmr::vector` are allocated from the memory resource of the vector.
+   */
+  template< typename TString >
+    struct BasicKSeq {  // kseq_t
+      /* Typedefs */
+      using string_type = TString;
+      using allocator_type = typename string_type::allocator_type;
+      /* Data members */
+      string_type name;
+      string_type comment;
+      string_type seq;
+      string_type qual;
+      /* Lifecycle */
+      BasicKSeq( ) = default;
+      BasicKSeq( BasicKSeq const& ) = default;
+      BasicKSeq( BasicKSeq&& ) = default;
+      BasicKSeq& operator=( BasicKSeq const& ) = default;
+      BasicKSeq& operator=( BasicKSeq&& ) = default;
+
+      explicit BasicKSeq( allocator_type const& alloc )
+        : name( alloc ), comment( alloc ), seq( alloc ), qual( alloc )
+      { }
+
+      BasicKSeq( BasicKSeq const& other, allocator_type const& alloc )
+        : name( other.name, alloc ), comment( other.comment, alloc ),
+        seq( other.seq, alloc ), qual( other.qual, alloc )
+      { }
+
+      BasicKSeq( BasicKSeq&& other, allocator_type const& alloc )
+        : name( std::move( other.name ), alloc ), comment( std::move( other.comment ), alloc ),
+        seq( std::move( other.seq ), alloc ), qual( std::move( other.qual ), alloc )
+      { }
+      /* Methods */
+      inline void clear( ) {
+        name.clear();
+        comment.clear();
+        seq.clear();
+        qual.clear();
+      }
+    };
+
+  using KSeq = BasicKSeq< std::string >;
+
+#if KSEQPP_HAS_PMR
+  namespace pmr {
+    using KSeq = BasicKSeq< std::pmr::string >;
+  }  /* -----  end of namespace pmr  ----- */
+#endif  /* ----- KSEQPP_HAS_PMR ----- */
+
+  /**
+   *  @brief  Bytes of a record exactly as they appear in the input.
+   *
+   *  The record starts with its header line at offset zero. The bytes can be
+   *  written to an output stream as they are; e.g. to filter records without
+   *  formatting them again.
+   */
+  struct KRaw {
+    /* Typedefs */
+    using size_type = std::string::size_type;
+    /* Consts */
+    constexpr static size_type npos = std::string::npos;
+    /* Data members */
+    std::string bytes;    /**< @brief record bytes from its header char to its last line end */
+    size_type seq = 0;    /**< @brief offset of the first sequence line */
+    size_type qual = npos;  /**< @brief offset of the first quality line; `npos` for FASTA records */
+    /* Methods */
     inline void clear( ) {
-      name.clear();
-      comment.clear();
-      seq.clear();
-      qual.clear();
+      bytes.clear();
+      seq = 0;
+      qual = npos;
     }
   };
 
@@ -67,14 +178,1491 @@ namespace klibpp {
 
   namespace format {
     enum Format { mix, fasta, fastq };
+
+    /* Input format tags selecting a parser at compile time */
+    struct Mix_ { };          /**< @brief FASTA and/or FASTQ records (default) */
+    struct Fasta_ { };        /**< @brief FASTA records only */
+    struct FastqStrict_ { };  /**< @brief FASTQ records of exactly four lines */
+
+    constexpr Fasta_ fasta_only;
+    constexpr FastqStrict_ fastq_strict;
   }
 
+  namespace field {
+    enum Field { none = 0, name = 1, comment = 2, seq = 4, qual = 8, all = 15 };
+
+      constexpr inline Field
+    operator|( Field lhs, Field rhs )
+    {
+      return static_cast< Field >( static_cast< unsigned int >( lhs ) | rhs );
+    }
+
+      constexpr inline Field
+    operator&( Field lhs, Field rhs )
+    {
+      return static_cast< Field >( static_cast< unsigned int >( lhs ) & rhs );
+    }
+
+      constexpr inline Field
+    operator~( Field f )
+    {
+      return static_cast< Field >( ~static_cast< unsigned int >( f ) & all );
+    }
+  }  /* -----  end of namespace field  ----- */
+
+  /**
+   *  @brief  Byte-wise transformation of quality strings by a lookup table.
+   *
+   *  Transforms can be chained by `then` into one table; so any combination of
+   *  them costs a single table lookup per quality character. Quality values are
+   *  Phred scores encoded by adding an ASCII offset (33 or 64).
+   */
+  class KQualMap {
+    public:
+      /* Typedefs */
+      using size_type = std::string::size_type;
+      using table_type = std::array< char, 256 >;
+      /* Consts */
+      constexpr static int PHRED33 = 33;
+      constexpr static int PHRED64 = 64;
+      constexpr static int MAX_CHAR = 126;  /**< @brief largest printable ASCII character */
+      /* Lifecycle */
+      KQualMap( )
+      {
+        for ( int c = 0; c < 256; ++c ) this->table[ c ] = static_cast< char >( c );
+      }
+      /* Factories */
+      /**
+       *  @brief  Change the quality encoding offset (e.g. Phred+64 to Phred+33).
+       *
+       *  The resulting characters are clamped to the printable range of the
+       *  target encoding.
+       */
+        static inline KQualMap
+      shift( int from, int to )
+      {
+        KQualMap map;
+        for ( int c = from; c < 256; ++c ) {
+          map.table[ c ] = static_cast< char >( std::min( c - from + to, KQualMap::MAX_CHAR ) );
+        }
+        return map;
+      }
+
+      /**
+       *  @brief  Illumina 8-level quality binning.
+       *
+       *  Phred scores 2-9, 10-19, 20-24, 25-29, 30-34, 35-39 and >=40 are mapped
+       *  to 6, 15, 22, 27, 33, 37 and 40 respectively; scores 0 and 1 are kept.
+       */
+        static inline KQualMap
+      bin_illumina( int offset=PHRED33 )
+      {
+        KQualMap map;
+        for ( int c = offset; c < 256; ++c ) {
+          int q = c - offset;
+          if ( q < 2 ) continue;
+          else if ( q < 10 ) q = 6;
+          else if ( q < 20 ) q = 15;
+          else if ( q < 25 ) q = 22;
+          else if ( q < 30 ) q = 27;
+          else if ( q < 35 ) q = 33;
+          else if ( q < 40 ) q = 37;
+          else q = 40;
+          map.table[ c ] = static_cast< char >( q + offset );
+        }
+        return map;
+      }
+
+      /**
+       *  @brief  Clamp Phred scores to the given maximum.
+       */
+        static inline KQualMap
+      cap( int maxq, int offset=PHRED33 )
+      {
+        KQualMap map;
+        for ( int c = offset + maxq + 1; c < 256; ++c ) {
+          map.table[ c ] = static_cast< char >( offset + maxq );
+        }
+        return map;
+      }
+      /* Accessors */
+        inline char
+      operator[]( char c ) const
+      {
+        return this->table[ static_cast< unsigned char >( c ) ];
+      }
+      /* Methods */
+      /**
+       *  @brief  Compose this transform with the given one applied afterwards.
+       */
+        inline KQualMap
+      then( KQualMap const& next ) const
+      {
+        KQualMap map;
+        for ( int c = 0; c < 256; ++c ) map.table[ c ] = next[ this->table[ c ] ];
+        return map;
+      }
+
+      /**
+       *  @brief  Transform `n` characters from `src` into `dst`.
+       *
+       *  The loop is unrolled so that independent lookups are issued together;
+       *  the table fits in L1 cache.
+       */
+        inline void
+      apply( char* dst, const char* src, size_type n ) const
+      {
+        const unsigned char* s = reinterpret_cast< const unsigned char* >( src );
+        const char* t = this->table.data();
+        size_type i = 0;
+        for ( ; i + 4 <= n; i += 4 ) {
+          char c0 = t[ s[ i ] ];
+          char c1 = t[ s[ i + 1 ] ];
+          char c2 = t[ s[ i + 2 ] ];
+          char c3 = t[ s[ i + 3 ] ];
+          dst[ i ] = c0;
+          dst[ i + 1 ] = c1;
+          dst[ i + 2 ] = c2;
+          dst[ i + 3 ] = c3;
+        }
+        for ( ; i < n; ++i ) dst[ i ] = t[ s[ i ] ];
+      }
+
+        inline void
+      apply( std::string& str ) const
+      {
+        this->apply( &str[ 0 ], str.data(), str.size() );
+      }
+    private:
+      /* Data members */
+      table_type table;  /**< @brief lookup table */
+  };
+
+  /**
+   *  @brief  Streaming 64-bit xxHash (XXH64).
+   *
+   *  The input can be given in any number of chunks; the digest is the same as
+   *  hashing the concatenated bytes at once.
+   */
+  class KHash64 {
+    public:
+      /* Typedefs */
+      using size_type = std::string::size_type;
+      /* Lifecycle */
+      explicit KHash64( std::uint64_t seed_=0 ) : seed( seed_ )
+      {
+        this->reset();
+      }
+      /* Methods */
+        static inline std::uint64_t
+      of( const char* s, size_type n, std::uint64_t seed=0 )
+      {
+        KHash64 h( seed );
+        h.update( s, n );
+        return h.digest();
+      }
+
+      /**
+       *  @brief  Combine the hashes of two strings (e.g. the mates of a pair).
+       *
+       *  The result depends on the order of the hashes.
+       */
+        static inline std::uint64_t
+      combine( std::uint64_t h1, std::uint64_t h2 )
+      {
+        return KHash64::avalanche( h1 ^ KHash64::round( PRIME64_4, h2 ) );
+      }
+
+        inline void
+      reset( )
+      {
+        this->v[ 0 ] = this->seed + PRIME64_1 + PRIME64_2;
+        this->v[ 1 ] = this->seed + PRIME64_2;
+        this->v[ 2 ] = this->seed;
+        this->v[ 3 ] = this->seed - PRIME64_1;
+        this->total = 0;
+        this->memsize = 0;
+      }
+
+        inline void
+      update( const char* s, size_type n )
+      {
+        this->total += n;
+        if ( this->memsize + n < 32 ) {
+          std::memcpy( this->mem + this->memsize, s, n );
+          this->memsize += n;
+          return;
+        }
+        const char* end = s + n;
+        if ( this->memsize != 0 ) {  // complete the pending stripe
+          size_type fill = 32 - this->memsize;
+          std::memcpy( this->mem + this->memsize, s, fill );
+          this->stripe( this->mem );
+          s += fill;
+          this->memsize = 0;
+        }
+        for ( ; s + 32 <= end; s += 32 ) this->stripe( s );
+        this->memsize = end - s;
+        std::memcpy( this->mem, s, this->memsize );
+      }
+
+        inline std::uint64_t
+      digest( ) const
+      {
+        std::uint64_t h;
+        if ( this->total >= 32 ) {
+          h = KHash64::rotl( this->v[ 0 ], 1 ) + KHash64::rotl( this->v[ 1 ], 7 ) +
+            KHash64::rotl( this->v[ 2 ], 12 ) + KHash64::rotl( this->v[ 3 ], 18 );
+          for ( int i = 0; i < 4; ++i ) {
+            h ^= KHash64::round( 0, this->v[ i ] );
+            h = h * PRIME64_1 + PRIME64_4;
+          }
+        }
+        else h = this->seed + PRIME64_5;
+        h += this->total;
+        const char* p = this->mem;
+        const char* end = this->mem + this->memsize;
+        for ( ; p + 8 <= end; p += 8 ) {
+          h ^= KHash64::round( 0, KHash64::read64( p ) );
+          h = KHash64::rotl( h, 27 ) * PRIME64_1 + PRIME64_4;
+        }
+        if ( p + 4 <= end ) {
+          h ^= static_cast< std::uint64_t >( KHash64::read32( p ) ) * PRIME64_1;
+          h = KHash64::rotl( h, 23 ) * PRIME64_2 + PRIME64_3;
+          p += 4;
+        }
+        for ( ; p < end; ++p ) {
+          h ^= static_cast< unsigned char >( *p ) * PRIME64_5;
+          h = KHash64::rotl( h, 11 ) * PRIME64_1;
+        }
+        return KHash64::avalanche( h );
+      }
+    private:
+      /* Consts */
+      constexpr static std::uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+      constexpr static std::uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+      constexpr static std::uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+      constexpr static std::uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+      constexpr static std::uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+      /* Data members */
+      std::uint64_t seed;     /**< @brief hash seed */
+      std::uint64_t v[ 4 ];   /**< @brief accumulators */
+      std::uint64_t total;    /**< @brief number of bytes hashed so far */
+      char mem[ 32 ];         /**< @brief pending bytes of an incomplete stripe */
+      size_type memsize;      /**< @brief number of pending bytes */
+      /* Methods */
+        static inline std::uint64_t
+      rotl( std::uint64_t x, int r )
+      {
+        return ( x << r ) | ( x >> ( 64 - r ) );
+      }
+
+        static inline std::uint64_t
+      read64( const char* p )
+      {
+        std::uint64_t x;
+        std::memcpy( &x, p, 8 );
+        return x;
+      }
+
+        static inline std::uint32_t
+      read32( const char* p )
+      {
+        std::uint32_t x;
+        std::memcpy( &x, p, 4 );
+        return x;
+      }
+
+        static inline std::uint64_t
+      round( std::uint64_t acc, std::uint64_t input )
+      {
+        acc += input * PRIME64_2;
+        return KHash64::rotl( acc, 31 ) * PRIME64_1;
+      }
+
+        static inline std::uint64_t
+      avalanche( std::uint64_t h )
+      {
+        h ^= h >> 33;
+        h *= PRIME64_2;
+        h ^= h >> 29;
+        h *= PRIME64_3;
+        h ^= h >> 32;
+        return h;
+      }
+
+        inline void
+      stripe( const char* p )
+      {
+        for ( int i = 0; i < 4; ++i ) {
+          this->v[ i ] = KHash64::round( this->v[ i ], KHash64::read64( p + 8 * i ) );
+        }
+      }
+  };
+
+  /**
+   *  @brief  Streaming CRC-32C (Castagnoli) checksum.
+   *
+   *  It uses the CRC32 instructions of SSE 4.2 (detected at run time) or ARMv8
+   *  (if enabled at compile time); otherwise, a slicing-by-8 table lookup.
+   */
+  class KCrc32c {
+    public:
+      /* Typedefs */
+      using size_type = std::string::size_type;
+      /* Lifecycle */
+      KCrc32c( ) : crc( 0xFFFFFFFF ) { }
+      /* Accessors */
+        static inline bool
+      is_hardware( )
+      {
+#if defined( KSEQPP_HAS_CRC32C_X86 )
+        static const bool supported = __builtin_cpu_supports( "sse4.2" );
+        return supported;
+#elif defined( KSEQPP_HAS_CRC32C_ARM )
+        return true;
+#else
+        return false;
+#endif
+      }
+      /* Methods */
+        static inline std::uint32_t
+      of( const char* s, size_type n )
+      {
+        KCrc32c c;
+        c.update( s, n );
+        return c.digest();
+      }
+
+        inline void
+      reset( )
+      {
+        this->crc = 0xFFFFFFFF;
+      }
+
+        inline void
+      update( const char* s, size_type n )
+      {
+        const unsigned char* p = reinterpret_cast< const unsigned char* >( s );
+#if defined( KSEQPP_HAS_CRC32C_X86 ) || defined( KSEQPP_HAS_CRC32C_ARM )
+        if ( KCrc32c::is_hardware() ) {
+          this->crc = KCrc32c::update_hw( this->crc, p, n );
+          return;
+        }
+#endif
+        this->crc = KCrc32c::update_sw( this->crc, p, n );
+      }
+
+        inline std::uint32_t
+      digest( ) const
+      {
+        return this->crc ^ 0xFFFFFFFF;
+      }
+    private:
+      /* Typedefs */
+      using table_type = std::array< std::array< std::uint32_t, 256 >, 8 >;
+      /* Consts */
+      constexpr static std::uint32_t POLY = 0x82F63B78;  /**< @brief reversed polynomial */
+      /* Data members */
+      std::uint32_t crc;  /**< @brief current (inverted) remainder */
+      /* Methods */
+        static inline table_type const&
+      tables( )
+      {
+        static const table_type t = []() {
+          table_type t_;
+          for ( std::uint32_t i = 0; i < 256; ++i ) {
+            std::uint32_t c = i;
+            for ( int k = 0; k < 8; ++k ) c = ( c >> 1 ) ^ ( POLY & ( 0 - ( c & 1 ) ) );
+            t_[ 0 ][ i ] = c;
+          }
+          for ( std::uint32_t i = 0; i < 256; ++i ) {
+            for ( int k = 1; k < 8; ++k ) {
+              t_[ k ][ i ] = ( t_[ k - 1 ][ i ] >> 8 ) ^ t_[ 0 ][ t_[ k - 1 ][ i ] & 0xFF ];
+            }
+          }
+          return t_;
+        }();
+        return t;
+      }
+
+        static inline std::uint32_t
+      update_sw( std::uint32_t c, const unsigned char* p, size_type n )
+      {
+        table_type const& t = KCrc32c::tables();
+        for ( ; n >= 8; n -= 8, p += 8 ) {
+          std::uint32_t lo = c ^ ( p[ 0 ] | p[ 1 ] << 8 | p[ 2 ] << 16 | static_cast< std::uint32_t >( p[ 3 ] ) << 24 );
+          c = t[ 7 ][ lo & 0xFF ] ^ t[ 6 ][ ( lo >> 8 ) & 0xFF ] ^ t[ 5 ][ ( lo >> 16 ) & 0xFF ] ^
+            t[ 4 ][ lo >> 24 ] ^ t[ 3 ][ p[ 4 ] ] ^ t[ 2 ][ p[ 5 ] ] ^ t[ 1 ][ p[ 6 ] ] ^ t[ 0 ][ p[ 7 ] ];
+        }
+        for ( ; n != 0; --n, ++p ) c = ( c >> 8 ) ^ t[ 0 ][ ( c ^ *p ) & 0xFF ];
+        return c;
+      }
+
+#if defined( KSEQPP_HAS_CRC32C_X86 )
+      __attribute__(( target( "sse4.2" ) ))
+        static inline std::uint32_t
+      update_hw( std::uint32_t c, const unsigned char* p, size_type n )
+      {
+        std::uint64_t c64 = c;
+        for ( ; n >= 8; n -= 8, p += 8 ) {
+          std::uint64_t x;
+          std::memcpy( &x, p, 8 );
+          c64 = _mm_crc32_u64( c64, x );
+        }
+        c = static_cast< std::uint32_t >( c64 );
+        for ( ; n != 0; --n, ++p ) c = _mm_crc32_u8( c, *p );
+        return c;
+      }
+#elif defined( KSEQPP_HAS_CRC32C_ARM )
+        static inline std::uint32_t
+      update_hw( std::uint32_t c, const unsigned char* p, size_type n )
+      {
+        for ( ; n >= 8; n -= 8, p += 8 ) {
+          std::uint64_t x;
+          std::memcpy( &x, p, 8 );
+          c = __crc32cd( c, x );
+        }
+        for ( ; n != 0; --n, ++p ) c = __crc32cb( c, *p );
+        return c;
+      }
+#endif
+  };
+
+  /**
+   *  @brief  Streaming MD5 digest (RFC 1321).
+   */
+  class KMd5 {
+    public:
+      /* Typedefs */
+      using size_type = std::string::size_type;
+      using digest_type = std::array< unsigned char, 16 >;
+      /* Lifecycle */
+      KMd5( )
+      {
+        this->reset();
+      }
+      /* Methods */
+        inline void
+      reset( )
+      {
+        this->state[ 0 ] = 0x67452301;
+        this->state[ 1 ] = 0xEFCDAB89;
+        this->state[ 2 ] = 0x98BADCFE;
+        this->state[ 3 ] = 0x10325476;
+        this->total = 0;
+      }
+
+        inline void
+      update( const char* s, size_type n )
+      {
+        const unsigned char* p = reinterpret_cast< const unsigned char* >( s );
+        size_type pending = this->total % 64;
+        this->total += n;
+        if ( pending != 0 ) {
+          size_type fill = std::min< size_type >( 64 - pending, n );
+          std::memcpy( this->block + pending, p, fill );
+          p += fill;
+          n -= fill;
+          if ( pending + fill < 64 ) return;
+          this->transform( this->block );
+        }
+        for ( ; n >= 64; n -= 64, p += 64 ) this->transform( p );
+        std::memcpy( this->block, p, n );
+      }
+
+        inline digest_type
+      digest( ) const
+      {
+        KMd5 h( *this );
+        std::uint64_t bits = this->total * 8;
+        unsigned char pad[ 72 ] = { 0x80 };
+        size_type npad = ( this->total % 64 < 56 ? 56 : 120 ) - this->total % 64;
+        for ( int i = 0; i < 8; ++i ) pad[ npad + i ] = static_cast< unsigned char >( bits >> ( 8 * i ) );
+        h.update( reinterpret_cast< const char* >( pad ), npad + 8 );
+        digest_type ret;
+        for ( int i = 0; i < 16; ++i ) ret[ i ] = static_cast< unsigned char >( h.state[ i / 4 ] >> ( 8 * ( i % 4 ) ) );
+        return ret;
+      }
+
+      /**
+       *  @brief  Digest as a lower-case hexadecimal string (as printed by `md5sum`).
+       */
+        inline std::string
+      hexdigest( ) const
+      {
+        constexpr char HEX[] = "0123456789abcdef";
+        std::string ret;
+        for ( unsigned char c : this->digest() ) {
+          ret += HEX[ c >> 4 ];
+          ret += HEX[ c & 0xF ];
+        }
+        return ret;
+      }
+    private:
+      /* Data members */
+      std::uint32_t state[ 4 ];   /**< @brief chaining variables */
+      std::uint64_t total;        /**< @brief number of bytes hashed so far */
+      unsigned char block[ 64 ];  /**< @brief pending bytes of an incomplete block */
+      /* Methods */
+        static inline std::uint32_t
+      rotl( std::uint32_t x, int r )
+      {
+        return ( x << r ) | ( x >> ( 32 - r ) );
+      }
+
+        inline void
+      transform( const unsigned char* p )
+      {
+        constexpr static std::uint32_t K[ 64 ] = {
+          0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+          0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+          0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+          0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+          0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+          0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+          0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+          0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391 };
+        constexpr static int R[ 16 ] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+        std::uint32_t m[ 16 ];
+        for ( int i = 0; i < 16; ++i ) {
+          m[ i ] = p[ 4 * i ] | p[ 4 * i + 1 ] << 8 | p[ 4 * i + 2 ] << 16 |
+            static_cast< std::uint32_t >( p[ 4 * i + 3 ] ) << 24;
+        }
+        std::uint32_t a = this->state[ 0 ];
+        std::uint32_t b = this->state[ 1 ];
+        std::uint32_t c = this->state[ 2 ];
+        std::uint32_t d = this->state[ 3 ];
+        for ( int i = 0; i < 64; ++i ) {
+          std::uint32_t f;
+          int g;
+          if ( i < 16 ) {
+            f = ( b & c ) | ( ~b & d );
+            g = i;
+          }
+          else if ( i < 32 ) {
+            f = ( d & b ) | ( ~d & c );
+            g = ( 5 * i + 1 ) % 16;
+          }
+          else if ( i < 48 ) {
+            f = b ^ c ^ d;
+            g = ( 3 * i + 5 ) % 16;
+          }
+          else {
+            f = c ^ ( b | ~d );
+            g = ( 7 * i ) % 16;
+          }
+          std::uint32_t tmp = d;
+          d = c;
+          c = b;
+          b = b + KMd5::rotl( a + f + K[ i ] + m[ g ], R[ ( i / 16 ) * 4 + i % 4 ] );
+          a = tmp;
+        }
+        this->state[ 0 ] += a;
+        this->state[ 1 ] += b;
+        this->state[ 2 ] += c;
+        this->state[ 3 ] += d;
+      }
+  };
+
+  namespace checksum {
+    enum Algorithm {
+      crc32c = 1,  /**< @brief CRC-32C (Castagnoli) */
+      md5 = 2,     /**< @brief MD5 */
+      xxh64 = 4,   /**< @brief 64-bit xxHash */
+      all = 7
+    };
+  }  /* -----  end of namespace checksum  ----- */
+
+  /**
+   *  @brief  A set of streaming checksums of the same bytes.
+   *
+   *  Only the algorithms given as a combination of `checksum::Algorithm` flags
+   *  are computed; the digests of the others are zero (or empty).
+   */
+  class KChecksum {
+    public:
+      /* Typedefs */
+      using size_type = std::string::size_type;
+      /* Lifecycle */
+      KChecksum( unsigned int algorithms_=checksum::all )
+        : algorithms( algorithms_ & checksum::all ), nbytes( 0 )
+      { }
+      /* Accessors */
+        inline unsigned int
+      get_algorithms( ) const
+      {
+        return this->algorithms;
+      }
+
+      /**
+       *  @brief  Number of bytes checksummed so far.
+       */
+        inline std::uint64_t
+      size( ) const
+      {
+        return this->nbytes;
+      }
+
+        inline std::uint32_t
+      get_crc32c( ) const
+      {
+        if ( !( this->algorithms & checksum::crc32c ) ) return 0;
+        return this->crc.digest();
+      }
+
+        inline std::string
+      get_md5( ) const
+      {
+        if ( !( this->algorithms & checksum::md5 ) ) return "";
+        return this->md.hexdigest();
+      }
+
+        inline std::uint64_t
+      get_xxh64( ) const
+      {
+        if ( !( this->algorithms & checksum::xxh64 ) ) return 0;
+        return this->xxh.digest();
+      }
+      /* Methods */
+        inline void
+      update( const char* s, size_type n )
+      {
+        if ( this->algorithms & checksum::crc32c ) this->crc.update( s, n );
+        if ( this->algorithms & checksum::md5 ) this->md.update( s, n );
+        if ( this->algorithms & checksum::xxh64 ) this->xxh.update( s, n );
+        this->nbytes += n;
+      }
+
+        inline void
+      reset( )
+      {
+        this->crc.reset();
+        this->md.reset();
+        this->xxh.reset();
+        this->nbytes = 0;
+      }
+    private:
+      /* Data members */
+      unsigned int algorithms;  /**< @brief enabled algorithms */
+      std::uint64_t nbytes;     /**< @brief number of bytes checksummed so far */
+      KCrc32c crc;              /**< @brief CRC-32C state */
+      KMd5 md;                  /**< @brief MD5 state */
+      KHash64 xxh;              /**< @brief XXH64 state */
+  };
+
+  /**
+   *  @brief  Consumer of the bytes of a record field while it is being parsed.
+   *
+   *  It appends the incoming bytes to the given string if it is enabled;
+   *  otherwise, the bytes are only counted without being copied. If a quality
+   *  map is given, the bytes are transformed while being copied. If a hasher is
+   *  given, the bytes are hashed as well (whether copied or not).
+   */
+  template< typename TString >
+    class KFieldSink {
+      public:
+        /* Typedefs */
+        using string_type = TString;
+        using size_type = typename string_type::size_type;
+        /* Lifecycle */
+        KFieldSink( string_type& str_, bool enabled_=true, KQualMap const* map_=nullptr,
+            KHash64* hasher_=nullptr )
+          : str( str_ ), map( map_ ), hasher( hasher_ ), len( 0 ), enabled( enabled_ )
+        { }
+        /* Accessors */
+          inline size_type
+        size( ) const
+        {
+          return this->len;
+        }
+
+          inline bool
+        is_enabled( ) const
+        {
+          return this->enabled;
+        }
+        /* Mutators */
+          inline void
+        disable( )
+        {
+          this->enabled = false;
+        }
+        /* Methods */
+          inline void
+        append( const typename string_type::value_type* s, size_type n )
+        {
+          if ( this->enabled ) {
+            if ( this->map != nullptr ) {
+              auto pos = this->str.size();
+              this->str.resize( pos + n );
+              this->map->apply( &this->str[ pos ], s, n );
+            }
+            else this->str.append( s, n );
+          }
+          if ( this->hasher != nullptr ) this->hasher->update( s, n );
+          this->len += n;
+        }
+      private:
+        /* Data members */
+        string_type& str;     /**< @brief target string */
+        KQualMap const* map;  /**< @brief transform applied while copying (if any) */
+        KHash64* hasher;      /**< @brief hash of the consumed bytes (if any) */
+        size_type len;        /**< @brief number of bytes consumed so far */
+        bool enabled;         /**< @brief whether to copy the bytes or just count them */
+    };
+
+  /**
+   *  @brief  Sink counting the bytes of a record field without storing them.
+   */
+  class KSkipSink {
+    public:
+      /* Typedefs */
+      using size_type = std::string::size_type;
+      /* Lifecycle */
+      KSkipSink( ) : len( 0 ) { }
+      /* Accessors */
+        inline size_type
+      size( ) const
+      {
+        return this->len;
+      }
+      /* Methods */
+        inline void
+      append( const char*, size_type n )
+      {
+        this->len += n;
+      }
+    private:
+      /* Data members */
+      size_type len;  /**< @brief number of bytes consumed so far */
+  };
+
+  /**
+   *  @brief  Summary statistics of the records in a stream.
+   *
+   *  It is computed by `KStream::scan` directly from the stream buffer without
+   *  storing any records.
+   */
+  struct KStats {
+    /* Typedefs */
+    using size_type = unsigned long int;
+    /* Data members */
+    size_type count = 0;                      /**< @brief number of records */
+    size_type fastq = 0;                      /**< @brief number of FASTQ records */
+    size_type total = 0;                      /**< @brief total number of bases */
+    size_type min_len = 0;                    /**< @brief minimum sequence length */
+    size_type max_len = 0;                    /**< @brief maximum sequence length */
+    size_type gc = 0;                         /**< @brief number of G/C bases */
+    size_type n = 0;                          /**< @brief number of N bases */
+    std::map< size_type, size_type > lengths; /**< @brief sequence length histogram */
+    std::array< size_type, 256 > quals{ };    /**< @brief quality character histogram */
+    /* Sinks */
+    class SeqSink {
+      public:
+        SeqSink( ) : len( 0 ), gc( 0 ), n( 0 ) { }
+          inline std::string::size_type
+        size( ) const
+        {
+          return this->len;
+        }
+          inline void
+        append( const char* s, std::string::size_type n_ )
+        {
+          size_type gc_ = 0;
+          size_type nb = 0;
+          for ( std::string::size_type i = 0; i < n_; ++i ) {
+            char c = s[ i ] & 0xDF;  // upper case
+            gc_ += ( c == 'G' ) | ( c == 'C' );
+            nb += ( c == 'N' );
+          }
+          this->gc += gc_;
+          this->n += nb;
+          this->len += n_;
+        }
+      private:
+        friend struct KStats;
+        std::string::size_type len;
+        size_type gc;
+        size_type n;
+    };
+
+    /**
+     *  @brief  Quality sink holding the qualities of the current record.
+     *
+     *  They are tallied by `add` only when the record is complete; so a
+     *  malformed record leaves the histogram untouched.
+     */
+    class QualSink {
+      public:
+          inline std::string::size_type
+        size( ) const
+        {
+          return this->quals.size();
+        }
+          inline void
+        append( const char* s, std::string::size_type n )
+        {
+          this->quals.append( s, n );
+        }
+          inline void
+        clear( )
+        {
+          this->quals.clear();
+        }
+      private:
+        friend struct KStats;
+        std::string quals;
+    };
+    /* Methods */
+      inline void
+    add( SeqSink const& seq, bool is_fastq )
+    {
+      this->gc += seq.gc;
+      this->n += seq.n;
+      this->add( seq.size(), is_fastq );
+    }
+
+      inline void
+    add( SeqSink const& seq, QualSink const& qual )
+    {
+      for ( char c : qual.quals ) ++this->quals[ static_cast< unsigned char >( c ) ];
+      this->add( seq, qual.size() != 0 );
+    }
+
+      inline void
+    add( size_type len, bool is_fastq )
+    {
+      if ( this->count == 0 || len < this->min_len ) this->min_len = len;
+      if ( len > this->max_len ) this->max_len = len;
+      ++this->count;
+      if ( is_fastq ) ++this->fastq;
+      this->total += len;
+      ++this->lengths[ len ];
+    }
+
+      inline double
+    mean( ) const
+    {
+      if ( this->count == 0 ) return 0;
+      return this->total / static_cast< double >( this->count );
+    }
+
+      inline size_type
+    n50( ) const
+    {
+      size_type acc = 0;
+      for ( auto it = this->lengths.rbegin(); it != this->lengths.rend(); ++it ) {
+        acc += it->first * it->second;
+        if ( 2 * acc >= this->total ) return it->first;
+      }
+      return 0;
+    }
+
+      inline KStats&
+    operator+=( KStats const& other )
+    {
+      if ( other.count == 0 ) return *this;
+      if ( this->count == 0 || other.min_len < this->min_len ) this->min_len = other.min_len;
+      if ( other.max_len > this->max_len ) this->max_len = other.max_len;
+      this->count += other.count;
+      this->fastq += other.fastq;
+      this->total += other.total;
+      this->gc += other.gc;
+      this->n += other.n;
+      for ( auto const& l : other.lengths ) this->lengths[ l.first ] += l.second;
+      for ( std::size_t i = 0; i < this->quals.size(); ++i ) this->quals[ i ] += other.quals[ i ];
+      return *this;
+    }
+  };
+
+  /**
+   *  @brief  Progress of an input stream.
+   *
+   *  `bytes` is the position in the underlying file (i.e. compressed bytes for
+   *  compressed files) if it is known by `KFileOffset`; otherwise, it is the
+   *  number of bytes consumed from the stream. So `total` should be given in the
+   *  same unit (see `set_total`).
+   */
+  struct KProgress {
+    /* Data members */
+    unsigned long int records = 0;  /**< @brief number of parsed records */
+    std::uint64_t bytes = 0;        /**< @brief number of bytes consumed */
+    std::uint64_t total = 0;        /**< @brief total number of bytes (zero if unknown) */
+    double elapsed = 0;             /**< @brief seconds since the stream is opened */
+    /* Methods */
+    /**
+     *  @brief  Fraction of the input consumed; negative if the total size is unknown.
+     */
+      inline double
+    fraction( ) const
+    {
+      if ( this->total == 0 ) return -1;
+      return std::min( this->bytes / static_cast< double >( this->total ), 1.0 );
+    }
+
+      inline double
+    records_per_sec( ) const
+    {
+      if ( this->elapsed <= 0 ) return 0;
+      return this->records / this->elapsed;
+    }
+
+      inline double
+    bytes_per_sec( ) const
+    {
+      if ( this->elapsed <= 0 ) return 0;
+      return this->bytes / this->elapsed;
+    }
+
+    /**
+     *  @brief  Estimated seconds to the end; negative if it cannot be estimated yet.
+     */
+      inline double
+    eta( ) const
+    {
+      double rate = this->bytes_per_sec();
+      if ( this->total == 0 || rate <= 0 ) return -1;
+      if ( this->bytes >= this->total ) return 0;
+      return ( this->total - this->bytes ) / rate;
+    }
+  };
+
+  /**
+   *  @brief  Position in the underlying file of an input stream.
+   *
+   *  It returns a negative value if the position is unknown; it is specialized
+   *  for file descriptors here and for `gzFile` in `seqio.hpp`. It should be
+   *  specialized for other file types to report their progress in file bytes.
+   */
+  template< typename TFile >
+    struct KFileOffset {
+        static inline long long int
+      of( TFile const& )
+      {
+        return -1;
+      }
+    };
+
+#if KSEQPP_HAS_UNISTD
+  template< >
+    struct KFileOffset< int > {
+        static inline long long int
+      of( int const& fd )
+      {
+        return ::lseek( fd, 0, SEEK_CUR );
+      }
+    };
+#endif
+
+  /**
+   *  @brief  Record filter checked by the input stream while a record is parsed.
+   *
+   *  A record is rejected if its name does not start with `prefix`, its length
+   *  is out of [`min_len`, `max_len`], the fraction of N bases exceeds `max_n`,
+   *  or the mean Phred quality of a FASTQ record is lower than `min_qual`.
+   *  Rejected records are skipped by the stream.
+   *
+   *  The qualities are measured as they are returned by the stream; i.e. after
+   *  the stream quality map (see `set_qualmap`) if any. So `qual_offset` is the
+   *  offset of the encoding which the map produces (e.g. `PHRED33` for a map
+   *  converting Phred+64 input to Phred+33).
+   */
+  struct KFilter {
+    /* Typedefs */
+    using size_type = std::string::size_type;
+    /* Data members */
+    size_type min_len = 0;                                          /**< @brief minimum sequence length */
+    size_type max_len = std::numeric_limits< size_type >::max();    /**< @brief maximum sequence length */
+    double max_n = 1;                                               /**< @brief maximum fraction of N bases */
+    double min_qual = 0;                                            /**< @brief minimum mean Phred quality */
+    int qual_offset = KQualMap::PHRED33;                            /**< @brief quality encoding offset (after the quality map) */
+    std::string prefix;                                             /**< @brief required name prefix */
+    /* Nested classes */
+    /**
+     *  @brief  Values measured while a record is being parsed.
+     */
+    struct Tally {
+      bool rejected = false;     /**< @brief the record is already known to be rejected */
+      size_type n = 0;           /**< @brief number of N bases */
+      unsigned long int qsum = 0;  /**< @brief sum of quality characters */
+    };
+
+    enum Role { name, comment, seq, qual };
+
+    /**
+     *  @brief  Sink wrapper measuring a field for the filter.
+     *
+     *  The bytes are forwarded to the underlying sink until the record is known
+     *  to be rejected; e.g. a name prefix mismatch or a too long sequence stops
+     *  copying the rest of the record. Qualities are measured after the given
+     *  quality map (if any) which the underlying sink applies to them.
+     */
+    template< typename TSink, Role TRole >
+      class Sink {
+        public:
+          Sink( TSink& sink_, KFilter const& filter_, Tally& tally_, KQualMap const* map_=nullptr )
+            : sink( sink_ ), filter( filter_ ), tally( tally_ ), map( map_ ), len( 0 ) { }
+            inline size_type
+          size( ) const
+          {
+            return this->len;
+          }
+            inline void
+          append( const char* s, size_type n )
+          {
+            if ( TRole == name ) this->check_prefix( s, n );
+            else if ( TRole == seq ) this->count_n( s, n );
+            else if ( TRole == qual ) this->sum_qual( s, n );
+            if ( !this->tally.rejected ) this->sink.append( s, n );
+            this->len += n;
+          }
+        private:
+          TSink& sink;
+          KFilter const& filter;
+          Tally& tally;
+          KQualMap const* map;
+          size_type len;
+
+            inline void
+          check_prefix( const char* s, size_type n )
+          {
+            if ( this->len >= this->filter.prefix.size() ) return;
+            size_type m = std::min( n, this->filter.prefix.size() - this->len );
+            if ( std::memcmp( s, this->filter.prefix.data() + this->len, m ) != 0 ) {
+              this->tally.rejected = true;
+            }
+          }
+
+            inline void
+          count_n( const char* s, size_type n )
+          {
+            size_type nb = 0;
+            for ( size_type i = 0; i < n; ++i ) nb += ( ( s[ i ] & 0xDF ) == 'N' );
+            this->tally.n += nb;
+            if ( this->len + n > this->filter.max_len ) this->tally.rejected = true;
+          }
+
+            inline void
+          sum_qual( const char* s, size_type n )
+          {
+            unsigned long int sum = 0;
+            if ( this->map != nullptr ) {
+              KQualMap const& m = *this->map;
+              for ( size_type i = 0; i < n; ++i ) sum += static_cast< unsigned char >( m[ s[ i ] ] );
+            }
+            else {
+              for ( size_type i = 0; i < n; ++i ) sum += static_cast< unsigned char >( s[ i ] );
+            }
+            this->tally.qsum += sum;
+          }
+      };
+    /* Methods */
+    /**
+     *  @brief  Check a parsed record given its field lengths and tally.
+     */
+      inline bool
+    accepts( size_type name_len, size_type seq_len, size_type qual_len, Tally const& tally ) const
+    {
+      if ( tally.rejected || name_len < this->prefix.size() ) return false;
+      if ( seq_len < this->min_len || seq_len > this->max_len ) return false;
+      if ( tally.n > this->max_n * seq_len ) return false;
+      if ( qual_len != 0 &&
+           tally.qsum < ( this->min_qual + this->qual_offset ) * qual_len ) return false;
+      return true;
+    }
+  };
+
+  /**
+   *  @brief  Record validator checked by the input stream while a record is parsed.
+   *
+   *  Sequence characters should be IUPAC nucleotide codes (either case) or '-'
+   *  if `iupac` is set, and quality characters should be in [`qual_min`,
+   *  `qual_max`]. The first invalid byte fails the stream and is reported by
+   *  the record index and the byte offset in the input.
+   */
+  struct KValidator {
+    /* Typedefs */
+    using size_type = std::string::size_type;
+    /* Consts */
+    constexpr static std::uint32_t IUPAC_MASK = 0x17E34CF;  /**< @brief bit i: 'A'+i is an IUPAC code (ACGTURYSWKMBDHVN) */
+    /* Data members */
+    bool iupac = true;      /**< @brief check sequence characters */
+    char qual_min = '!';    /**< @brief minimum quality character */
+    char qual_max = '~';    /**< @brief maximum quality character */
+    /* Nested classes */
+    /**
+     *  @brief  The first invalid byte found.
+     */
+    struct Error {
+      bool found = false;             /**< @brief whether an invalid byte is found */
+      unsigned long int record = 0;   /**< @brief index of the record containing the byte */
+      unsigned long int offset = 0;   /**< @brief byte offset in the input stream */
+      char byte = 0;                  /**< @brief the invalid byte */
+    };
+
+    enum Role { seq, qual };
+
+    /**
+     *  @brief  Sink wrapper validating a field.
+     *
+     *  The bytes are forwarded to the underlying sink unchanged. The validity of
+     *  a chunk is first checked by a branch-free loop; only an invalid chunk is
+     *  scanned again to locate the first bad byte.
+     */
+    template< typename TSink, Role TRole, typename TStream >
+      class Sink {
+        public:
+          Sink( TSink& sink_, KValidator const& validator_, Error& error_,
+              TStream const& ks_, unsigned long int record_ )
+            : sink( sink_ ), validator( validator_ ), error( error_ ), ks( ks_ ),
+            record( record_ )
+          { }
+            inline size_type
+          size( ) const
+          {
+            return this->sink.size();
+          }
+            inline void
+          append( const char* s, size_type n )
+          {
+            if ( !this->error.found && !this->valid( s, n ) ) {
+              size_type i = 0;
+              while ( this->valid( s + i, 1 ) ) ++i;
+              this->error.found = true;
+              this->error.record = this->record;
+              this->error.offset = this->ks.offset_of( s + i );
+              this->error.byte = s[ i ];
+            }
+            this->sink.append( s, n );
+          }
+        private:
+          TSink& sink;
+          KValidator const& validator;
+          Error& error;
+          TStream const& ks;
+          unsigned long int record;
+
+            inline bool
+          valid( const char* s, size_type n ) const
+          {
+            unsigned int bad = 0;
+            if ( TRole == seq ) {
+              if ( !this->validator.iupac ) return true;
+              for ( size_type i = 0; i < n; ++i ) {
+                unsigned int c = static_cast< unsigned char >( s[ i ] );
+                unsigned int l = ( c & 0xDF ) - 'A';  // upper case letter index
+                bad |= ( ( l >= 26 ) | !( ( IUPAC_MASK >> ( l & 31 ) ) & 1 ) ) & ( c != '-' );
+              }
+            }
+            else {
+              unsigned char lo = this->validator.qual_min;
+              unsigned char hi = this->validator.qual_max;
+              for ( size_type i = 0; i < n; ++i ) {
+                unsigned char c = s[ i ];
+                bad |= ( c < lo ) | ( c > hi );
+              }
+            }
+            return !bad;
+          }
+      };
+  };
+
+  /**
+   *  @brief  Seeded random source for subsampling records.
+   *
+   *  The generated sequence only depends on the seed; so two streams sampled
+   *  with the same seed select records at the same positions (e.g. the mates
+   *  in paired-end files).
+   */
+  class KSampler {
+    public:
+      /* Typedefs */
+      using size_type = unsigned long int;
+      /* Lifecycle */
+      KSampler( std::uint64_t seed ) : rng( seed ) { }
+      /* Methods */
+      /**
+       *  @brief  Uniform random number in (0, 1].
+       */
+        inline double
+      uniform( )
+      {
+        return ( ( this->rng() >> 11 ) + 1 ) * ( 1.0 / 9007199254740992.0 );  // 2^-53
+      }
+
+      /**
+       *  @brief  Uniform random index in [0, n).
+       */
+        inline size_type
+      index( size_type n )
+      {
+        return std::min( static_cast< size_type >( ( 1 - this->uniform() ) * n ), n - 1 );
+      }
+
+      /**
+       *  @brief  Number of items to skip before the next selected one.
+       *
+       *  Selecting each item independently with probability `fraction` is
+       *  equivalent to skipping geometrically distributed gaps; so only one random
+       *  number is drawn per selected item.
+       */
+        inline size_type
+      skip( double fraction )
+      {
+        if ( fraction >= 1 ) return 0;
+        if ( fraction <= 0 ) return std::numeric_limits< size_type >::max();
+        return KSampler::gap( this->uniform(), std::log1p( -fraction ) );
+      }
+
+      /**
+       *  @brief  Gap to the next replaced item in reservoir sampling (Algorithm L).
+       *
+       *  @param  w  The current reservoir weight which is updated by `weight`.
+       */
+        inline size_type
+      skip_reservoir( double w )
+      {
+        return KSampler::gap( this->uniform(), std::log1p( -w ) );
+      }
+
+        inline double
+      weight( size_type k )
+      {
+        return std::exp( std::log( this->uniform() ) / k );
+      }
+    private:
+      /* Data members */
+      std::mt19937_64 rng;  /**< @brief random number generator */
+      /* Methods */
+        static inline size_type
+      gap( double u, double log_q )
+      {
+        if ( log_q == 0 ) return std::numeric_limits< size_type >::max();
+        double g = std::floor( std::log( u ) / log_q );
+        if ( g >= static_cast< double >( std::numeric_limits< size_type >::max() ) ) {
+          return std::numeric_limits< size_type >::max();
+        }
+        return static_cast< size_type >( g );
+      }
+  };
+
+  /**
+   *  @brief  Set of CPUs which the worker threads of a stream are pinned to.
+   *
+   *  An empty set leaves the threads to the scheduler. Pinning is only
+   *  supported on Linux; elsewhere `apply` does nothing and returns `false`.
+   */
+  class KAffinity {
+    public:
+      /* Lifecycle */
+      KAffinity( ) = default;
+
+      KAffinity( std::vector< int > cpus_ )
+        : cpus( std::move( cpus_ ) )
+      { }
+
+      KAffinity( std::initializer_list< int > cpus_ )
+        : cpus( cpus_ )
+      { }
+      /* Accessors */
+        inline std::vector< int > const&
+      get_cpus( ) const
+      {
+        return this->cpus;
+      }
+
+        inline bool
+      empty( ) const
+      {
+        return this->cpus.empty();
+      }
+      /* Methods */
+      /**
+       *  @brief  Pin the given running thread to the CPU set.
+       *
+       *  @return `true` if the thread is pinned or the set is empty.
+       */
+        inline bool
+      apply( std::thread& thread ) const noexcept
+      {
+        if ( this->empty() ) return true;
+        if ( !thread.joinable() ) return false;
+#if KSEQPP_HAS_AFFINITY
+        cpu_set_t set;
+        CPU_ZERO( &set );
+        for ( int cpu : this->cpus ) {
+          if ( cpu >= 0 && cpu < CPU_SETSIZE ) CPU_SET( cpu, &set );
+        }
+        return pthread_setaffinity_np( thread.native_handle(), sizeof( set ), &set ) == 0;
+#else
+        return false;
+#endif
+      }
+    private:
+      /* Data members */
+      std::vector< int > cpus;  /**< @brief CPU indices */
+  };
+
+  /**
+   *  @brief  Buffer size controller of the adaptive streams.
+   *
+   *  It measures the throughput of the read or write calls (bytes per second)
+   *  over windows of `WINDOW` calls, and hill-climbs the buffer size by powers
+   *  of two within [min, max]: the size keeps moving in one direction while the
+   *  throughput improves by more than `TOLERANCE`; otherwise it settles at the
+   *  smaller one of the last two sizes (unless it is significantly slower) and
+   *  probes again after `REPROBE` windows. If the calls transfer
+   *  less than half of the buffer on average (e.g. pipes or network sources),
+   *  the buffer is shrunk since a larger one would not be filled anyway.
+   */
+  class KBufferTuner {
+    public:
+      /* Typedefs */
+      using size_type = unsigned long int;
+      /* Consts */
+      constexpr static unsigned int WINDOW = 8;     /**< @brief number of calls per measurement */
+      constexpr static unsigned int REPROBE = 64;   /**< @brief number of settled windows before probing */
+      constexpr static double TOLERANCE = 0.05;     /**< @brief relative throughput change considered significant */
+      /* Lifecycle */
+      KBufferTuner( size_type min_, size_type max_, size_type initial )
+        : min( min_ ), max( max_ ), current( std::min( std::max( initial, min_ ), max_ ) ),
+        prev_size( 0 ), prev_rate( 0 ), nbytes( 0 ), seconds( 0 ), ncalls( 0 ),
+        direction( 1 ), nidle( 0 )
+      {
+        if ( this->min == 0 || this->min > this->max ) {
+          throw std::invalid_argument( "invalid buffer size bounds" );
+        }
+      }
+      /* Accessors */
+      /**
+       *  @brief  The buffer size to be used for the next calls.
+       */
+        inline size_type
+      size( ) const
+      {
+        return this->current;
+      }
+      /* Methods */
+      /**
+       *  @brief  Record a call which transferred `n` bytes in `secs` seconds using the current size.
+       */
+        inline void
+      observe( size_type n, double secs )
+      {
+        this->nbytes += n;
+        this->seconds += secs;
+        if ( ++this->ncalls < WINDOW ) return;
+        double rate = this->nbytes / std::max( this->seconds, 1e-9 );
+        size_type avg = this->nbytes / this->ncalls;
+        this->nbytes = 0;
+        this->seconds = 0;
+        this->ncalls = 0;
+        if ( 2 * avg < this->current ) {  // short transfers
+          this->settle( this->clamp( this->current / 2 ) );
+          return;
+        }
+        if ( this->direction == 0 ) {
+          if ( ++this->nidle < REPROBE ) return;
+          this->nidle = 0;
+          this->direction = 1;
+          this->prev_rate = 0;
+        }
+        if ( this->prev_rate != 0 && rate < this->prev_rate * ( 1 + TOLERANCE ) ) {
+          // no improvement: keep the smaller size unless it is significantly slower
+          bool worse = rate < this->prev_rate * ( 1 - TOLERANCE );
+          this->settle( this->direction > 0 || worse ? this->prev_size : this->current );
+          return;
+        }
+        this->prev_rate = rate;
+        this->prev_size = this->current;
+        this->step();
+      }
+    private:
+      /* Data members */
+      size_type min;        /**< @brief minimum buffer size */
+      size_type max;        /**< @brief maximum buffer size */
+      size_type current;    /**< @brief current buffer size */
+      size_type prev_size;  /**< @brief the previous buffer size */
+      double prev_rate;     /**< @brief throughput at the previous size (zero if not measured) */
+      size_type nbytes;     /**< @brief bytes transferred in the current window */
+      double seconds;       /**< @brief time spent in the current window */
+      unsigned int ncalls;  /**< @brief number of calls in the current window */
+      int direction;        /**< @brief 1: growing, -1: shrinking, 0: settled */
+      unsigned int nidle;   /**< @brief number of windows since settled */
+      /* Methods */
+        inline size_type
+      clamp( size_type n ) const
+      {
+        return std::min( std::max( n, this->min ), this->max );
+      }
+
+        inline void
+      settle( size_type n )
+      {
+        this->current = n;
+        this->direction = 0;
+        this->nidle = 0;
+        this->prev_rate = 0;
+      }
+
+        inline void
+      step( )
+      {
+        size_type next = this->clamp( this->direction > 0 ? this->current * 2 : this->current / 2 );
+        if ( next == this->current && this->direction > 0 ) {  // at the upper bound: try shrinking
+          this->direction = -1;
+          next = this->clamp( this->current / 2 );
+        }
+        if ( next == this->current ) this->settle( next );
+        else this->current = next;
+      }
+  };
+
   struct KEnd_ {};
   constexpr KEnd_ kend;
 
+  /**
+   *  @brief  Format a record by `puts` calls on the given output.
+   *
+   *  It is shared by the output streams and the buffers which format records
+   *  on their behalf (see `KChunk`); line wrapping is done by their `puts`.
+   */
+  template< typename TOut, typename TString >
+      inline void
+    put_record_( TOut& out, BasicKSeq< TString > const& rec, format::Format fmt,
+        KQualMap const* qmap )
+    {
+      if ( ( fmt == format::mix && rec.qual.empty() ) ||  // FASTA record
+           ( fmt == format::fasta ) ) out.puts( '>' );      // Forced FASTA
+      else {
+        if ( rec.qual.size() != rec.seq.size() ) {
+          throw std::runtime_error( "the sequence length doesn't match with"
+                                    " the length of its quality string.");
+        }
+        out.puts( '@' );  // FASTQ record
+      }
+      out.puts( rec.name );
+      if ( !rec.comment.empty() ) {
+        out.puts( ' ' );
+        out.puts( rec.comment );
+      }
+      out.puts( '\n' );
+      out.puts( rec.seq );
+      if ( ( fmt == format::mix && !rec.qual.empty() ) ||  // FASTQ record
+           ( fmt == format::fastq ) ) {                        // Forced FASTQ
+        out.puts( '\n' );
+        out.puts( '+' );
+        out.puts( '\n' );
+        out.puts( rec.qual, qmap );
+      }
+      out.puts( '\n' );
+    }
+
   template< typename TFile,
-            typename TFunc >
-    class KStream< TFile, TFunc, mode::Out_ > : public KStreamBase_ {
+            typename TFunc,
+            typename TAlloc >
+    class KStream< TFile, TFunc, mode::Out_, TAlloc > : public KStreamBase_ {
       public:
         /* Typedefs */
         using base_type = KStreamBase_;
@@ -82,9 +1670,13 @@ namespace klibpp {
         using size_type = base_type::size_type;
         using char_type = base_type::char_type;
         using close_type = int(*)( TFile );
+        using allocator_type = TAlloc;
+        using alloc_traits = std::allocator_traits< allocator_type >;
       protected:
         /* Consts */
         constexpr static std::make_unsigned_t< size_type > DEFAULT_BUFSIZE = 131072;
+        constexpr static std::make_unsigned_t< size_type > ADAPTIVE_MIN_BUFSIZE = 16384;
+        constexpr static std::make_unsigned_t< size_type > ADAPTIVE_MAX_BUFSIZE = 16777216;
         constexpr static unsigned int DEFAULT_WRAPLEN = 60;
         constexpr static unsigned int FASTQ_DEFAULT_WRAPLEN = 0;  // nowrap
         constexpr static format::Format DEFAULT_FORMAT = format::mix;
@@ -92,6 +1684,11 @@ namespace klibpp {
         char_type* m_buf;                               /**< @brief character buffer */
         char_type* w_buf;                               /**< @brief second character buffer */
         size_type bufsize;                              /**< @brief buffer size */
+        size_type bufcap;                               /**< @brief allocated size of the buffers */
+        std::unique_ptr< KBufferTuner > tuner;          /**< @brief buffer size controller (if adaptive) */
+        bool w_full;                                    /**< @brief the second buffer is a full one */
+        KAffinity affinity;                             /**< @brief CPUs of the writer thread */
+        std::unique_ptr< KChecksum > csum;              /**< @brief checksums of the written bytes (if any) */
         std::thread worker;                             /**< @brief worker thread */
         std::unique_ptr< std::mutex > bufslock;         /**< @brief buffers mutex */
         std::unique_ptr< std::condition_variable > cv;  /**< @brief consumer/producer condition variable */
@@ -102,22 +1699,28 @@ namespace klibpp {
         size_type w_end;                                /**< @brief end second buffer index or error flag if -1 */
         unsigned int wraplen;                           /**< @brief line wrap length */
         unsigned long int counter;                      /**< @brief number of records written so far */
+        unsigned long int nbytes;                       /**< @brief number of bytes passed to the writer so far */
         format::Format fmt;                             /**< @brief format of the output records */
+        std::unique_ptr< KQualMap > qmap;               /**< @brief quality transform (if any) */
         TFile f;                                        /**< @brief file handler */
         TFunc func;                                     /**< @brief write function */
         close_type close;                               /**< @brief close function */
+        allocator_type alloc;                           /**< @brief buffers allocator */
       public:
         KStream( TFile f_,
             TFunc func_,
             spec_type=mode::out,
             format::Format fmt_=DEFAULT_FORMAT,
             std::make_unsigned_t< size_type > bs_=DEFAULT_BUFSIZE,
-            close_type cfunc_=nullptr )
-          : m_buf( new char_type[ bs_ ] ), w_buf( new char_type[ bs_ ] ),
-          bufsize( bs_ ), bufslock( new std::mutex ), cv( new std::condition_variable ),
+            close_type cfunc_=nullptr,
+            allocator_type const& alloc_=allocator_type() )
+          : bufsize( bs_ ), bufcap( bs_ ), w_full( false ), bufslock( new std::mutex ),
+          cv( new std::condition_variable ),
           wraplen( DEFAULT_WRAPLEN ), fmt( fmt_ ), f( std::move( f_ ) ),
-          func( std::move(  func_  ) ), close( cfunc_ )
+          func( std::move(  func_  ) ), close( cfunc_ ), alloc( alloc_ )
         {
+          this->m_buf = this->allocate( bs_ );
+          this->w_buf = this->allocate( bs_ );
           if ( this->fmt == format::fastq ) this->wraplen = FASTQ_DEFAULT_WRAPLEN;
           this->m_begin = 0;
           this->m_end = 0;
@@ -125,6 +1728,7 @@ namespace klibpp {
           this->produced = false;
           this->w_end = 0;
           this->counter = 0;
+          this->nbytes = 0;
           this->worker_start();
         }
 
@@ -182,7 +1786,7 @@ namespace klibpp {
         KStream( KStream const& ) = delete;
         KStream& operator=( KStream const& ) = delete;
 
-        KStream( KStream&& other ) noexcept
+        KStream( KStream&& other ) noexcept : alloc( std::move( other.alloc ) )
         {
           other.worker_join();
           this->m_buf = other.m_buf;
@@ -190,6 +1794,11 @@ namespace klibpp {
           other.m_buf = nullptr;
           other.w_buf = nullptr;
           this->bufsize = other.bufsize;
+          this->bufcap = other.bufcap;
+          this->tuner = std::move( other.tuner );
+          this->w_full = other.w_full;
+          this->affinity = std::move( other.affinity );
+          this->csum = std::move( other.csum );
           this->bufslock = std::move( other.bufslock );
           this->cv = std::move( other.cv );
           this->terminate = false;
@@ -199,24 +1808,44 @@ namespace klibpp {
           this->w_end = other.w_end;
           this->wraplen = other.wraplen;
           this->counter = other.counter;
+          this->nbytes = other.nbytes;
           this->fmt = other.fmt;
+          this->qmap = std::move( other.qmap );
           this->f = std::move( other.f );
           this->func = std::move( other.func );
           this->close = other.close;
+          other.close = nullptr;
           this->worker_start();
         }
 
-        KStream& operator=( KStream&& other ) noexcept
+        KStream& operator=( KStream&& other )
+          noexcept( alloc_traits::propagate_on_container_move_assignment::value )
         {
           if ( this == &other ) return *this;
+          this->worker_join();
           other.worker_join();
-          delete[] this->m_buf;
-          delete[] this->w_buf;
-          this->m_buf = other.m_buf;
-          this->w_buf = other.w_buf;
+          if ( this->close != nullptr ) this->close( this->f );
+          this->deallocate( this->m_buf );
+          this->deallocate( this->w_buf );
+          if ( this->take_alloc( other, typename alloc_traits::propagate_on_container_move_assignment() ) ) {
+            this->m_buf = other.m_buf;
+            this->w_buf = other.w_buf;
+          }
+          else {  // the buffers are reallocated by this stream's allocator
+            this->m_buf = this->allocate( other.bufcap );
+            this->w_buf = this->allocate( other.bufcap );
+            std::copy( other.m_buf, other.m_buf + other.m_begin, this->m_buf );
+            other.deallocate( other.m_buf );
+            other.deallocate( other.w_buf );
+          }
           other.m_buf = nullptr;
           other.w_buf = nullptr;
           this->bufsize = other.bufsize;
+          this->bufcap = other.bufcap;
+          this->tuner = std::move( other.tuner );
+          this->w_full = other.w_full;
+          this->affinity = std::move( other.affinity );
+          this->csum = std::move( other.csum );
           this->bufslock = std::move( other.bufslock );
           this->cv = std::move( other.cv );
           this->terminate = false;
@@ -226,10 +1855,13 @@ namespace klibpp {
           this->w_end = other.w_end;
           this->wraplen = other.wraplen;
           this->counter = other.counter;
+          this->nbytes = other.nbytes;
           this->fmt = other.fmt;
+          this->qmap = std::move( other.qmap );
           this->f = std::move( other.f );
           this->func = std::move( other.func );
           this->close = other.close;
+          other.close = nullptr;
           this->worker_start();
           return *this;
         }
@@ -237,8 +1869,8 @@ namespace klibpp {
         ~KStream( ) noexcept
         {
           this->worker_join();
-          delete[] this->m_buf;
-          delete[] this->w_buf;
+          this->deallocate( this->m_buf );
+          this->deallocate( this->w_buf );
           if ( this->close != nullptr ) this->close( this->f );
         }
         /* Accessors */
@@ -253,6 +1885,71 @@ namespace klibpp {
         {
           return this->fmt;
         }
+
+          inline unsigned int
+        get_wraplen( ) const
+        {
+          return this->wraplen;
+        }
+
+          inline KQualMap const*
+        get_qualmap( ) const
+        {
+          return this->qmap.get();
+        }
+
+        /**
+         *  @brief  Current buffer size (it changes over time if adaptive).
+         */
+          inline size_type
+        get_bufsize( ) const
+        {
+          std::unique_lock< std::mutex > lock( *this->bufslock );
+          return this->bufsize;
+        }
+
+          inline bool
+        is_adaptive( ) const
+        {
+          return this->tuner != nullptr;
+        }
+
+          inline KAffinity const&
+        get_affinity( ) const
+        {
+          return this->affinity;
+        }
+
+          inline bool
+        is_checksumming( ) const
+        {
+          return this->csum != nullptr;
+        }
+
+        /**
+         *  @brief  Checksums of the bytes handed to the write function so far.
+         *
+         *  It waits for the pending write; the bytes still in the buffer are not
+         *  included. So the checksums of the whole output are given after `kend`
+         *  (or `finish`).
+         */
+          inline KChecksum
+        checksums( ) const
+        {
+          std::unique_lock< std::mutex > lock( *this->bufslock );
+          this->cv->wait( lock, [this]{ return !this->produced; } );
+          if ( this->csum == nullptr ) return KChecksum( 0 );
+          return *this->csum;
+        }
+
+        /**
+         *  @brief  Number of (uncompressed) bytes written to the stream so far.
+         */
+          inline unsigned long int
+        bytes( ) const
+        {
+          return this->nbytes + this->m_begin;
+        }
         /* Mutators */
           inline void
         set_wraplen( unsigned int len )
@@ -277,6 +1974,87 @@ namespace klibpp {
         {
           this->fmt = fmt_;
         }
+
+        /**
+         *  @brief  Transform quality strings by the given map while writing.
+         *
+         *  For example, `KQualMap::shift( 33, 64 )` writes Phred+64 qualities
+         *  from Phred+33 records; i.e. the inverse of the input transform.
+         */
+          inline void
+        set_qualmap( KQualMap const& map )
+        {
+          this->qmap.reset( new KQualMap( map ) );
+        }
+
+          inline void
+        reset_qualmap( )
+        {
+          this->qmap.reset();
+        }
+
+        /**
+         *  @brief  Adapt the buffer size within [min, max] to the measured write throughput.
+         *
+         *  Only the writes of full buffers are measured by the writer thread (see
+         *  `KBufferTuner`); the size is changed when a buffer is handed over to it.
+         *  A larger size reallocates both buffers, and a smaller one reuses them.
+         */
+          inline void
+        set_adaptive( std::make_unsigned_t< size_type > min=ADAPTIVE_MIN_BUFSIZE,
+            std::make_unsigned_t< size_type > max=ADAPTIVE_MAX_BUFSIZE )
+        {
+          std::unique_ptr< KBufferTuner > t( new KBufferTuner( min, max, this->bufsize ) );
+          std::unique_lock< std::mutex > lock( *this->bufslock );
+          this->tuner = std::move( t );
+        }
+
+        /**
+         *  @brief  Stop adapting; the current buffer size is kept.
+         */
+          inline void
+        reset_adaptive( )
+        {
+          std::unique_lock< std::mutex > lock( *this->bufslock );
+          this->tuner.reset();
+        }
+
+        /**
+         *  @brief  Compute the given checksums (`checksum::Algorithm` flags) of the output.
+         *
+         *  The checksums are updated by the writer thread with each buffer right
+         *  before it is passed to the write function; i.e. they are of the
+         *  uncompressed output for compressing write functions. The bytes written
+         *  before calling this are not included.
+         */
+          inline void
+        set_checksums( unsigned int algorithms=checksum::all )
+        {
+          std::unique_ptr< KChecksum > c( new KChecksum( algorithms ) );
+          std::unique_lock< std::mutex > lock( *this->bufslock );
+          this->cv->wait( lock, [this]{ return !this->produced; } );
+          this->csum = std::move( c );
+        }
+
+          inline void
+        reset_checksums( )
+        {
+          std::unique_lock< std::mutex > lock( *this->bufslock );
+          this->cv->wait( lock, [this]{ return !this->produced; } );
+          this->csum.reset();
+        }
+
+        /**
+         *  @brief  Pin the writer thread to the given CPUs.
+         *
+         *  @return `false` if the thread could not be pinned (see `KAffinity`).
+         */
+          inline bool
+        set_affinity( KAffinity aff )
+        {
+          this->affinity = std::move( aff );
+          return this->affinity.apply( this->worker );
+        }
         /* Methods */
           inline bool
         fail( ) const
@@ -284,33 +2062,29 @@ namespace klibpp {
           return this->m_end == -1;
         }
 
+        template< typename TString >
+            inline KStream&
+          operator<<( BasicKSeq< TString > const& rec )
+          {
+            put_record_( *this, rec, this->fmt, this->qmap.get() );
+            if ( *this ) this->counter++;
+            return *this;
+          }
+
+        /**
+         *  @brief  Write a record from its raw input bytes.
+         *
+         *  The bytes are appended to the output buffer as they are; so neither
+         *  the output format, nor line wrapping, nor the quality map is applied.
+         *  A line end is added if the record lacks one (i.e. the last record of an
+         *  input without a trailing newline).
+         */
           inline KStream&
-        operator<<( const KSeq& rec )
+        operator<<( KRaw const& raw )
         {
-          if ( ( this->fmt == format::mix && rec.qual.empty() ) ||  // FASTA record
-               ( this->fmt == format::fasta ) ) this->puts( '>' );      // Forced FASTA
-          else {
-            if ( rec.qual.size() != rec.seq.size() ) {
-              throw std::runtime_error( "the sequence length doesn't match with"
-                                        " the length of its quality string.");
-            }
-            this->puts( '@' );  // FASTQ record
-          }
-          this->puts( rec.name );
-          if ( !rec.comment.empty() ) {
-            this->puts( ' ' );
-            this->puts( rec.comment );
-          }
-          this->puts( '\n' );
-          this->puts( rec.seq );
-          if ( ( this->fmt == format::mix && !rec.qual.empty() ) ||  // FASTQ record
-               ( this->fmt == format::fastq ) ) {                        // Forced FASTQ
-            this->puts( '\n' );
-            this->puts( '+' );
-            this->puts( '\n' );
-            this->puts( rec.qual );
-          }
-          this->puts( '\n' );
+          if ( raw.bytes.empty() ) return *this;
+          this->write( raw.bytes.data(), raw.bytes.size() );
+          if ( raw.bytes.back() != '\n' ) this->puts( '\n' );
           if ( *this ) this->counter++;
           return *this;
         }
@@ -334,27 +2108,51 @@ namespace klibpp {
           return !this->fail();
         }
         /* Low-level methods */
+        template< typename TTraits, typename TStrAlloc >
+            inline bool
+          puts( std::basic_string< char_type, TTraits, TStrAlloc > const& s,
+              KQualMap const* map=nullptr ) noexcept
+          {
+            using str_size_type = typename std::basic_string< char_type, TTraits, TStrAlloc >::size_type;
+            if ( this->fail() ) return false;
+
+            str_size_type cursor = 0;
+            str_size_type len = 0;
+            while ( cursor != s.size() ) {
+              assert( cursor < s.size() );
+              if ( this->m_begin >= this->bufsize ) this->async_write();
+              if ( this->fail() ) break;
+              // `len == 0`: the line break is already written just before the buffer got full
+              if ( this->wraplen && len != 0 && cursor % this->wraplen == 0 ) {
+                this->m_buf[ this->m_begin++ ] = '\n';
+              }
+              len = std::min( s.size() - cursor,
+                  static_cast< str_size_type >( this->bufsize - this->m_begin ) );
+              if ( this->wraplen )
+                len = std::min( len, this->wraplen - cursor % this->wraplen );
+              if ( map != nullptr ) map->apply( this->m_buf + this->m_begin, &s[ cursor ], len );
+              else std::copy( &s[ cursor ], &s[ cursor ] + len, this->m_buf + this->m_begin );
+              this->m_begin += len;
+              cursor += len;
+            }
+            return !this->fail();
+          }
+
+        /**
+         *  @brief  Append `n` bytes to the output buffer verbatim.
+         */
           inline bool
-        puts( std::string const& s ) noexcept
+        write( const char_type* s, size_type n ) noexcept
         {
           if ( this->fail() ) return false;
-
-          std::string::size_type cursor = 0;
-          std::string::size_type len = 0;
-          while ( cursor != s.size() ) {
-            assert( cursor < s.size() );
+          while ( n > 0 ) {
             if ( this->m_begin >= this->bufsize ) this->async_write();
             if ( this->fail() ) break;
-            if ( this->wraplen && cursor != 0 && cursor % this->wraplen == 0 ) {
-              this->m_buf[ this->m_begin++ ] = '\n';
-            }
-            len = std::min( s.size() - cursor,
-                static_cast< std::string::size_type >( this->bufsize - this->m_begin ) );
-            if ( this->wraplen )
-              len = std::min( len, this->wraplen - cursor % this->wraplen );
-            std::copy( &s[ cursor ], &s[ cursor ] + len, this->m_buf + this->m_begin );
+            size_type len = std::min( n, this->bufsize - this->m_begin );
+            std::memcpy( this->m_buf + this->m_begin, s, len );
             this->m_begin += len;
-            cursor += len;
+            s += len;
+            n -= len;
           }
           return !this->fail();
         }
@@ -368,6 +2166,26 @@ namespace klibpp {
           return !this->fail();
         }
 
+        /**
+         *  @brief  Flush the buffer, stop the writer thread, and close the file.
+         *
+         *  Nothing can be written afterwards (the stream fails), but the counters
+         *  and the checksums remain available.
+         *
+         *  @return `false` if writing or closing the file failed.
+         */
+          inline bool
+        finish( )
+        {
+          bool ok = !this->fail();
+          this->worker_join();
+          if ( this->w_end < 0 ) ok = false;
+          if ( this->close != nullptr && this->close( this->f ) != 0 ) ok = false;
+          this->close = nullptr;
+          this->m_end = -1;
+          return ok;
+        }
+
           inline void
         flush( ) noexcept
         {
@@ -376,10 +2194,80 @@ namespace klibpp {
             // wait until it is actually written to the file.
             std::unique_lock< std::mutex > lock( *this->bufslock );
             this->cv->wait( lock, [this]{ return !this->produced; } );
+            if ( this->w_end < 0 ) this->m_end = -1;  // fail now rather than on the next write
           }
         }
       private:
         /* Methods */
+          inline char_type*
+        allocate( std::make_unsigned_t< size_type > n )
+        {
+          return alloc_traits::allocate( this->alloc, n );
+        }
+
+          inline void
+        deallocate( char_type* p ) noexcept
+        {
+          if ( p == nullptr ) return;
+          alloc_traits::deallocate( this->alloc, p, this->bufcap );
+        }
+
+        /**
+         *  @brief  Take the allocator of `other` on move assignment if it propagates.
+         *
+         *  @return `true` if the buffers of `other` can be taken over; i.e. they are
+         *  deallocatable by the allocator of this stream.
+         */
+          inline bool
+        take_alloc( KStream& other, std::true_type )
+        {
+          this->alloc = std::move( other.alloc );
+          return true;
+        }
+
+          inline bool
+        take_alloc( KStream& other, std::false_type ) const
+        {
+          return this->alloc == other.alloc;
+        }
+
+        /**
+         *  @brief  Set the size of the buffers; the allocations are reused if they are large enough.
+         *
+         *  NOTE: It should be called with the buffers lock held, when the second
+         *  buffer is filled and before the first one is; the second buffer is
+         *  reallocated with its content.
+         */
+          inline void
+        resize( size_type n ) noexcept
+        {
+          if ( n == this->bufsize ) return;
+          if ( n > this->bufcap ) {
+            char_type* nw_buf;
+            char_type* nm_buf;
+            try {
+              nw_buf = this->allocate( n );
+            }
+            catch ( ... ) {
+              return;  // keep the current buffers
+            }
+            try {
+              nm_buf = this->allocate( n );
+            }
+            catch ( ... ) {
+              alloc_traits::deallocate( this->alloc, nw_buf, n );
+              return;
+            }
+            std::copy( this->w_buf, this->w_buf + this->w_end, nw_buf );
+            this->deallocate( this->w_buf );
+            this->deallocate( this->m_buf );
+            this->w_buf = nw_buf;
+            this->m_buf = nm_buf;
+            this->bufcap = n;
+          }
+          this->bufsize = n;
+        }
+
           inline void
         async_write( bool term=false ) noexcept
         {
@@ -391,7 +2279,10 @@ namespace klibpp {
             this->m_end = this->w_end;
             if ( !this->fail() ) {
               this->w_end = this->m_begin;
+              this->w_full = ( this->m_begin >= this->bufsize );
+              this->nbytes += this->m_begin;
               std::copy( this->m_buf, this->m_buf + this->m_begin, this->w_buf );
+              if ( this->tuner != nullptr ) this->resize( this->tuner->size() );
               this->produced = true;
               if ( term ) this->terminate = true;  /**< XXX: only set here! */
             }
@@ -408,9 +2299,15 @@ namespace klibpp {
             {
               std::unique_lock< std::mutex > lock( *this->bufslock );
               this->cv->wait( lock, [this]{ return this->produced; } );
+              if ( this->csum != nullptr && this->w_end > 0 ) this->csum->update( this->w_buf, this->w_end );
+              auto start = std::chrono::steady_clock::now();
               if ( !this->func( this->f, this->w_buf, this->w_end ) && this->w_end ) {
                 this->w_end = -1;
               }
+              if ( this->tuner != nullptr && this->w_full && this->w_end > 0 ) {
+                std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+                this->tuner->observe( this->w_end, elapsed.count() );
+              }
               this->produced = false;
               if ( this->terminate || this->w_end < 0 ) term = true;
             }
@@ -428,13 +2325,16 @@ namespace klibpp {
           inline void
         worker_start( )
         {
+          if ( this->fail() ) return;  // e.g. finished
           this->worker = std::thread( [this](){ this->writer(); } );
+          this->affinity.apply( this->worker );
         }
     };
 
   template< typename TFile,
-            typename TFunc >
-    class KStream< TFile, TFunc, mode::In_ > : public KStreamBase_ {  // kstream_t
+            typename TFunc,
+            typename TAlloc >
+    class KStream< TFile, TFunc, mode::In_, TAlloc > : public KStreamBase_ {  // kstream_t
       public:
         /* Typedefs */
         using base_type = KStreamBase_;
@@ -442,6 +2342,165 @@ namespace klibpp {
         using size_type = base_type::size_type;
         using char_type = base_type::char_type;
         using close_type = int(*)( TFile );
+        using allocator_type = TAlloc;
+        using alloc_traits = std::allocator_traits< allocator_type >;
+        /* Nested classes */
+        /**
+         *  @brief  Input iterator over the records of the stream.
+         *
+         *  All iterators of a stream share one record which is parsed into on each
+         *  increment; so the strings of the record keep their capacity.
+         */
+        class iterator {
+          public:
+            /* Typedefs */
+            using iterator_category = std::input_iterator_tag;
+            using value_type = KSeq;
+            using difference_type = std::ptrdiff_t;
+            using pointer = KSeq*;
+            using reference = KSeq&;
+            /* Nested classes */
+            class proxy {
+              public:
+                proxy( KSeq const& rec ) : value( rec ) { }
+                  inline KSeq&
+                operator*( )
+                {
+                  return this->value;
+                }
+              private:
+                KSeq value;
+            };
+            /* Lifecycle */
+            iterator( ) : ks( nullptr ) { }
+            explicit iterator( KStream* ks_ ) : ks( ks_ ) { ++( *this ); }
+            /* Operators */
+              inline reference
+            operator*( ) const
+            {
+              return this->ks->current;
+            }
+
+              inline pointer
+            operator->( ) const
+            {
+              return &this->ks->current;
+            }
+
+              inline iterator&
+            operator++( )
+            {
+              if ( !( *this->ks >> this->ks->current ) ) this->ks = nullptr;
+              return *this;
+            }
+
+              inline proxy
+            operator++( int )
+            {
+              proxy ret( this->ks->current );
+              ++( *this );
+              return ret;
+            }
+
+              inline bool
+            operator==( iterator const& other ) const
+            {
+              return this->ks == other.ks;
+            }
+
+              inline bool
+            operator!=( iterator const& other ) const
+            {
+              return this->ks != other.ks;
+            }
+          private:
+            KStream* ks;  /**< @brief the stream or null if it is past the end */
+        };
+
+        /**
+         *  @brief  Range over the batches of records in the stream.
+         *
+         *  Each batch is parsed into the same vector; so the records keep their
+         *  capacity between the batches.
+         */
+        class batch_range {
+          public:
+            /* Typedefs */
+            using batch_type = std::vector< KSeq >;
+            using size_type = batch_type::size_type;
+            /* Nested classes */
+            class iterator {
+              public:
+                /* Typedefs */
+                using iterator_category = std::input_iterator_tag;
+                using value_type = batch_type;
+                using difference_type = std::ptrdiff_t;
+                using pointer = batch_type*;
+                using reference = batch_type&;
+                /* Lifecycle */
+                iterator( ) : range( nullptr ) { }
+                explicit iterator( batch_range* range_ ) : range( range_ ) { ++( *this ); }
+                /* Operators */
+                  inline reference
+                operator*( ) const
+                {
+                  return this->range->batch;
+                }
+
+                  inline pointer
+                operator->( ) const
+                {
+                  return &this->range->batch;
+                }
+
+                  inline iterator&
+                operator++( )
+                {
+                  if ( this->range->ks->read( this->range->batch, this->range->size ) == 0 ) {
+                    this->range = nullptr;
+                  }
+                  return *this;
+                }
+
+                  inline void
+                operator++( int )
+                {
+                  ++( *this );
+                }
+
+                  inline bool
+                operator==( iterator const& other ) const
+                {
+                  return this->range == other.range;
+                }
+
+                  inline bool
+                operator!=( iterator const& other ) const
+                {
+                  return this->range != other.range;
+                }
+              private:
+                batch_range* range;  /**< @brief the range or null if it is past the end */
+            };
+            /* Lifecycle */
+            batch_range( KStream* ks_, size_type size_ ) : ks( ks_ ), size( size_ ) { }
+            /* Methods */
+              inline iterator
+            begin( )
+            {
+              return iterator( this );
+            }
+
+              inline iterator
+            end( )
+            {
+              return iterator( );
+            }
+          private:
+            KStream* ks;       /**< @brief the stream */
+            size_type size;    /**< @brief maximum number of records in a batch */
+            batch_type batch;  /**< @brief current batch */
+        };
       protected:
         /* Separators */
         constexpr static char_type SEP_SPACE = 0;  // isspace(): \t, \n, \v, \f, \r
@@ -450,35 +2509,83 @@ namespace klibpp {
         constexpr static char_type SEP_MAX = 2;
         /* Consts */
         constexpr static std::make_unsigned_t< size_type > DEFAULT_BUFSIZE = 16384;
+        constexpr static std::make_unsigned_t< size_type > ADAPTIVE_MIN_BUFSIZE = 4096;
+        constexpr static std::make_unsigned_t< size_type > ADAPTIVE_MAX_BUFSIZE = 4194304;
+        /* Forward declarations */
+        class ReadAhead_;
         /* Data members */
         char_type* buf;                      /**< @brief character buffer */
         size_type bufsize;                   /**< @brief buffer size */
-        size_type begin;                     /**< @brief begin buffer index */
-        size_type end;                       /**< @brief end buffer index or error flag if -1 */
+        size_type bufcap;                    /**< @brief allocated buffer size */
+        std::unique_ptr< KBufferTuner > tuner;  /**< @brief buffer size controller (if adaptive) */
+        size_type m_begin;                   /**< @brief begin buffer index */
+        size_type m_end;                     /**< @brief end buffer index or error flag if -1 */
         bool is_eof;                         /**< @brief eof flag */
         bool is_tqs;                         /**< @brief truncated quality string flag */
         bool is_ready;                       /**< @brief next record ready flag */
         bool last;                           /**< @brief last read was successful */
         unsigned long int counter;           /**< @brief number of parsed records so far */
+        field::Field fields;                 /**< @brief record fields to be stored */
+        std::unique_ptr< KQualMap > qmap;    /**< @brief quality transform (if any) */
+        std::unique_ptr< KFilter > filter;   /**< @brief record filter (if any) */
+        unsigned long int nfiltered;         /**< @brief number of rejected records so far */
+        std::unique_ptr< KSampler > sampler; /**< @brief random source of subsampling (if any) */
+        double fraction;                     /**< @brief subsampling fraction */
+        unsigned int unit;                   /**< @brief number of consecutive records sampled together */
+        unsigned long int ntaken;            /**< @brief remaining records of the current sampled unit */
+        std::unique_ptr< KValidator > validator;  /**< @brief record validator (if any) */
+        KValidator::Error verror;            /**< @brief the first invalid byte */
+        unsigned long int nconsumed;         /**< @brief number of bytes in the previous buffers */
+        std::unique_ptr< KHash64 > hasher;   /**< @brief sequence hasher (if any) */
+        std::uint64_t seqhash;               /**< @brief hash of the last record sequence */
+        KRaw* capture;                       /**< @brief raw bytes of the current record (if requested) */
+        size_type cbegin;                    /**< @brief first byte in the buffer not captured yet */
+        ReadAhead_* ra;                      /**< @brief read-ahead worker (if any) */
+        KAffinity affinity;                  /**< @brief CPUs of the read-ahead thread */
+        std::chrono::steady_clock::time_point started;  /**< @brief time of opening the stream */
+        std::uint64_t total;                 /**< @brief total size of the input (zero if unknown) */
+        long long int foffset;               /**< @brief file offset after the last read (for reporting) */
+        std::function< void( KProgress const& ) > reporter;  /**< @brief progress callback (if any) */
+        double interval;                     /**< @brief minimum seconds between progress reports */
+        std::chrono::steady_clock::time_point reported;  /**< @brief time of the last report */
+        KSeq current;                        /**< @brief current record of the iterator */
         TFile f;                             /**< @brief file handler */
         TFunc func;                          /**< @brief read function */
         close_type close;                    /**< @brief close function */
+        allocator_type alloc;                /**< @brief buffer allocator */
       public:
         KStream( TFile f_,
             TFunc func_,
             spec_type=mode::in,
             std::make_unsigned_t< size_type > bs_=DEFAULT_BUFSIZE,
-            close_type cfunc_=nullptr )  // ks_init
-          : buf( new char_type[ bs_ ] ), bufsize( bs_ ),
-          f( std::move( f_ ) ), func( std::move(  func_  ) ), close( cfunc_ )
+            close_type cfunc_=nullptr,
+            allocator_type const& alloc_=allocator_type() )  // ks_init
+          : bufsize( bs_ ), bufcap( bs_ ), f( std::move( f_ ) ), func( std::move(  func_  ) ),
+          close( cfunc_ ), alloc( alloc_ )
         {
-          this->begin = 0;
-          this->end = 0;
+          this->buf = this->allocate( bs_ );
+          this->m_begin = 0;
+          this->m_end = 0;
           this->is_eof = false;
           this->is_tqs = false;
           this->is_ready = false;
           this->last = false;
           this->counter = 0;
+          this->fields = field::all;
+          this->nfiltered = 0;
+          this->fraction = 1;
+          this->unit = 1;
+          this->ntaken = 0;
+          this->nconsumed = 0;
+          this->seqhash = 0;
+          this->capture = nullptr;
+          this->cbegin = 0;
+          this->ra = nullptr;
+          this->started = std::chrono::steady_clock::now();
+          this->total = 0;
+          this->foffset = -1;
+          this->interval = 0;
+          this->reported = this->started;
         }
 
         KStream( TFile f_,
@@ -504,46 +2611,109 @@ namespace klibpp {
         KStream( KStream const& ) = delete;
         KStream& operator=( KStream const& ) = delete;
 
-        KStream( KStream&& other ) noexcept
+        KStream( KStream&& other ) noexcept : alloc( std::move( other.alloc ) )
         {
           this->buf = other.buf;
           other.buf = nullptr;
           this->bufsize = other.bufsize;
-          this->begin = other.begin;
-          this->end = other.end;
+          this->bufcap = other.bufcap;
+          this->tuner = std::move( other.tuner );
+          this->affinity = std::move( other.affinity );
+          this->started = other.started;
+          this->total = other.total;
+          this->foffset = other.foffset;
+          this->reporter = std::move( other.reporter );
+          this->interval = other.interval;
+          this->reported = other.reported;
+          this->m_begin = other.m_begin;
+          this->m_end = other.m_end;
           this->is_eof = other.is_eof;
           this->is_tqs = other.is_tqs;
           this->is_ready = other.is_ready;
           this->last = other.last;
           this->counter = other.counter;
+          this->fields = other.fields;
+          this->qmap = std::move( other.qmap );
+          this->filter = std::move( other.filter );
+          this->nfiltered = other.nfiltered;
+          this->sampler = std::move( other.sampler );
+          this->fraction = other.fraction;
+          this->unit = other.unit;
+          this->ntaken = other.ntaken;
+          this->validator = std::move( other.validator );
+          this->verror = other.verror;
+          this->nconsumed = other.nconsumed;
+          this->hasher = std::move( other.hasher );
+          this->seqhash = other.seqhash;
+          this->capture = nullptr;
+          this->cbegin = 0;
+          this->ra = nullptr;
+          this->current = std::move( other.current );
           this->f = std::move( other.f );
           this->func = std::move( other.func );
           this->close = other.close;
+          other.close = nullptr;
         }
 
-        KStream& operator=( KStream&& other ) noexcept
+        KStream& operator=( KStream&& other )
+          noexcept( alloc_traits::propagate_on_container_move_assignment::value )
         {
           if ( this == &other ) return *this;
-          delete[] this->buf;
-          this->buf = other.buf;
+          if ( this->close != nullptr ) this->close( this->f );
+          this->deallocate( this->buf );
+          if ( this->take_alloc( other, typename alloc_traits::propagate_on_container_move_assignment() ) ) {
+            this->buf = other.buf;
+          }
+          else {  // the buffer is reallocated by this stream's allocator
+            this->buf = this->allocate( other.bufcap );
+            if ( other.m_end > 0 ) std::copy( other.buf, other.buf + other.m_end, this->buf );
+            other.deallocate( other.buf );
+          }
           other.buf = nullptr;
           this->bufsize = other.bufsize;
-          this->begin = other.begin;
-          this->end = other.end;
+          this->bufcap = other.bufcap;
+          this->tuner = std::move( other.tuner );
+          this->affinity = std::move( other.affinity );
+          this->started = other.started;
+          this->total = other.total;
+          this->foffset = other.foffset;
+          this->reporter = std::move( other.reporter );
+          this->interval = other.interval;
+          this->reported = other.reported;
+          this->m_begin = other.m_begin;
+          this->m_end = other.m_end;
           this->is_eof = other.is_eof;
           this->is_tqs = other.is_tqs;
           this->is_ready = other.is_ready;
           this->last = other.last;
           this->counter = other.counter;
+          this->fields = other.fields;
+          this->qmap = std::move( other.qmap );
+          this->filter = std::move( other.filter );
+          this->nfiltered = other.nfiltered;
+          this->sampler = std::move( other.sampler );
+          this->fraction = other.fraction;
+          this->unit = other.unit;
+          this->ntaken = other.ntaken;
+          this->validator = std::move( other.validator );
+          this->verror = other.verror;
+          this->nconsumed = other.nconsumed;
+          this->hasher = std::move( other.hasher );
+          this->seqhash = other.seqhash;
+          this->capture = nullptr;
+          this->cbegin = 0;
+          this->ra = nullptr;
+          this->current = std::move( other.current );
           this->f = std::move( other.f );
           this->func = std::move( other.func );
           this->close = other.close;
+          other.close = nullptr;
           return *this;
         }
 
         ~KStream( ) noexcept
         {
-          delete[] this->buf;
+          this->deallocate( this->buf );
           if ( this->close != nullptr ) this->close( this->f );
         }
         /* Accessors */
@@ -552,17 +2722,293 @@ namespace klibpp {
         {
           return this->counter;
         }
+
+          inline field::Field
+        get_fields( ) const
+        {
+          return this->fields;
+        }
+
+        /**
+         *  @brief  The first invalid byte found by the validator.
+         */
+          inline KValidator::Error const&
+        error( ) const
+        {
+          return this->verror;
+        }
+
+        /**
+         *  @brief  Number of input bytes consumed so far.
+         */
+          inline unsigned long int
+        tell( ) const
+        {
+          return this->nconsumed + std::max< size_type >( std::min( this->m_begin, this->m_end ), 0 );
+        }
+
+        /**
+         *  @brief  Input offset of a byte passed to a sink.
+         *
+         *  A '\r' held back from the end of the previous buffer is not in the
+         *  current one; its offset is the one right before the buffer.
+         */
+          inline unsigned long int
+        offset_of( const char_type* p ) const
+        {
+          if ( p < this->buf || p >= this->buf + this->bufsize ) return this->nconsumed - 1;
+          return this->nconsumed + ( p - this->buf );
+        }
+
+        /**
+         *  @brief  Number of records rejected by the filter or subsampling so far.
+         */
+          inline unsigned long int
+        filtered( ) const
+        {
+          return this->nfiltered;
+        }
+
+        /**
+         *  @brief  XXH64 hash of the sequence of the last record (if hashing is set).
+         */
+          inline std::uint64_t
+        hash( ) const
+        {
+          return this->seqhash;
+        }
+
+          inline bool
+        is_hashing( ) const
+        {
+          return this->hasher != nullptr;
+        }
+
+        /**
+         *  @brief  Current buffer size (it changes over time if adaptive).
+         */
+          inline size_type
+        get_bufsize( ) const
+        {
+          return this->bufsize;
+        }
+
+          inline bool
+        is_adaptive( ) const
+        {
+          return this->tuner != nullptr;
+        }
+
+          inline KAffinity const&
+        get_affinity( ) const
+        {
+          return this->affinity;
+        }
+
+        /**
+         *  @brief  Current progress of the stream.
+         *
+         *  The file position is queried from the underlying file; so it should not
+         *  be called while another thread reads the file (e.g. during `scan`).
+         */
+          inline KProgress
+        progress( ) const
+        {
+          return this->snapshot( KFileOffset< TFile >::of( this->f ) );
+        }
+
+          inline std::uint64_t
+        get_total( ) const
+        {
+          return this->total;
+        }
+        /* Mutators */
+          inline void
+        set_fields( field::Field fields_ )
+        {
+          this->fields = fields_;
+        }
+
+        /**
+         *  @brief  Transform quality strings by the given map while parsing.
+         *
+         *  The transform is fused into copying the quality string out of the
+         *  stream buffer; e.g. `KQualMap::shift( 64, 33 ).then( KQualMap::bin_illumina() )`.
+         */
+          inline void
+        set_qualmap( KQualMap const& map )
+        {
+          this->qmap.reset( new KQualMap( map ) );
+        }
+
+          inline void
+        reset_qualmap( )
+        {
+          this->qmap.reset();
+        }
+
+        /**
+         *  @brief  Skip the records rejected by the given filter.
+         *
+         *  The filter is checked while each record is being parsed; copying a
+         *  record stops as soon as it is known to be rejected.
+         */
+          inline void
+        set_filter( KFilter const& filter_ )
+        {
+          this->filter.reset( new KFilter( filter_ ) );
+        }
+
+          inline void
+        reset_filter( )
+        {
+          this->filter.reset();
+        }
+
+        /**
+         *  @brief  Read a random subset of the records (Bernoulli sampling).
+         *
+         *  Each unit of `unit_` consecutive records (e.g. 2 for interleaved pairs)
+         *  is selected with probability `fraction_`. The records which are not
+         *  selected are only scanned for the record boundaries. Streams sampled
+         *  with the same seed select the same record positions; so sampling both
+         *  files of paired-end reads with one seed keeps the mates together.
+         */
+          inline void
+        set_sampling( double fraction_, std::uint64_t seed, unsigned int unit_=1 )
+        {
+          this->sampler.reset( new KSampler( seed ) );
+          this->fraction = fraction_;
+          this->unit = std::max( unit_, 1u );
+          this->ntaken = 0;
+        }
+
+          inline void
+        reset_sampling( )
+        {
+          this->sampler.reset();
+        }
+
+        /**
+         *  @brief  Validate the sequence and quality characters while parsing.
+         *
+         *  The stream fails at the record containing the first invalid byte which
+         *  is reported by `error()`.
+         */
+          inline void
+        set_validation( KValidator const& validator_=KValidator() )
+        {
+          this->validator.reset( new KValidator( validator_ ) );
+        }
+
+          inline void
+        reset_validation( )
+        {
+          this->validator.reset();
+        }
+
+        /**
+         *  @brief  Hash the sequence of each record while it is parsed.
+         *
+         *  The bytes are hashed as they are copied out of the stream buffer (or
+         *  scanned if the sequence field is not stored); the hash of the last
+         *  record is reported by `hash()`.
+         */
+          inline void
+        set_hashing( std::uint64_t seed=0 )
+        {
+          this->hasher.reset( new KHash64( seed ) );
+        }
+
+          inline void
+        reset_hashing( )
+        {
+          this->hasher.reset();
+          this->seqhash = 0;
+        }
+
+        /**
+         *  @brief  Adapt the buffer size within [min, max] to the measured read throughput.
+         *
+         *  The size is changed only when the buffer is refilled (see `KBufferTuner`);
+         *  a larger buffer is allocated when needed, and a smaller one reuses the
+         *  allocation. It has no effect while reading ahead (e.g. in `skip`).
+         */
+          inline void
+        set_adaptive( std::make_unsigned_t< size_type > min=ADAPTIVE_MIN_BUFSIZE,
+            std::make_unsigned_t< size_type > max=ADAPTIVE_MAX_BUFSIZE )
+        {
+          this->tuner.reset( new KBufferTuner( min, max, this->bufsize ) );
+        }
+
+        /**
+         *  @brief  Stop adapting; the current buffer size is kept.
+         */
+          inline void
+        reset_adaptive( )
+        {
+          this->tuner.reset();
+        }
+
+        /**
+         *  @brief  Set the total size of the input in the unit of `KProgress::bytes`.
+         */
+          inline void
+        set_total( std::uint64_t total_ )
+        {
+          this->total = total_;
+        }
+
+        /**
+         *  @brief  Call `callback` with the progress at most every `interval` seconds.
+         *
+         *  It is checked only when the buffer is refilled; so it adds no cost per
+         *  record. The callback runs in the thread reading the stream and should
+         *  be quick and not throw. It is called once more when the end of the
+         *  input is reached; the last record might not be counted by then, but
+         *  `progress()` gives the final numbers after reading.
+         */
+          inline void
+        set_progress( std::function< void( KProgress const& ) > callback, double interval_=1.0 )
+        {
+          this->reporter = std::move( callback );
+          this->interval = interval_;
+          this->reported = std::chrono::steady_clock::now();
+        }
+
+          inline void
+        reset_progress( )
+        {
+          this->reporter = nullptr;
+        }
+
+        /**
+         *  @brief  Pin the read-ahead thread (reading and decompressing) to the given CPUs.
+         *
+         *  It takes effect when the thread is started (by `scan`).
+         */
+          inline void
+        set_affinity( KAffinity aff )
+        {
+          this->affinity = std::move( aff );
+        }
         /* Methods */
           inline bool
         err( ) const  // ks_err
         {
-          return this->end == -1;
+          return this->m_end == -1;
+        }
+
+          inline bool
+        invalid( ) const
+        {
+          return this->verror.found;
         }
 
           inline bool
         eof( ) const  // ks_eof
         {
-          return this->is_eof && this->begin >= this->end;
+          return this->is_eof && this->m_begin >= this->m_end;
         }
 
           inline bool
@@ -574,48 +3020,256 @@ namespace klibpp {
           inline bool
         fail( ) const
         {
-          return this->err() || this->tqs() || ( this->eof() && !this->last );
+          return this->err() || this->tqs() || this->invalid() || ( this->eof() && !this->last );
         }
 
-          inline KStream&
-        operator>>( KSeq& rec )  // kseq_read
-        {
-          char_type c;
-          this->last = false;
-          if ( !this->is_ready ) {  // then jump to the next header line
-            while ( ( c = this->getc( ) ) && c != '>' && c != '@' );
-            if ( this->fail() ) return *this;
-            this->is_ready = true;
-          }  // else: the first header char has been read in the previous call
-          rec.clear();  // reset all members
-          if ( !this->getuntil( KStream::SEP_SPACE, rec.name, &c ) ) return *this;
-          if ( c != '\n' ) {  // read FASTA/Q comment
-            this->getuntil( KStream::SEP_LINE, rec.comment, nullptr );
-          }
-          while ( ( c = this->getc( ) ) && c != '>' && c != '@' && c != '+' ) {
-            if ( c == '\n' ) continue;  // skip empty lines
-            rec.seq += c;
-            this->getuntil( KStream::SEP_LINE, rec.seq, nullptr, true ); // read the rest of the line
-          }
-          this->last = true;
-          ++this->counter;
-          if ( c == '>' || c == '@' ) this->is_ready = true;  // the first header char has been read
-          if ( c != '+' ) return *this;  // FASTA
-          while ( ( c = this->getc( ) ) && c != '\n' );  // skip the rest of '+' line
-          if ( this->eof() ) {  // error: no quality string
-            this->is_tqs = true;
+        template< typename TString >
+            inline KStream&
+          operator>>( BasicKSeq< TString >& rec )  // kseq_read
+          {
+            return this->read( rec, format::Mix_() );
+          }
+
+        /**
+         *  @brief  Read the next record by the parser selected by the format tag.
+         *
+         *  If the input format is known in advance, `format::fasta_only` or
+         *  `format::fastq_strict` skips the checks needed for mixed input on
+         *  each line. The stream state should be checked afterwards as for
+         *  `operator>>`.
+         */
+        template< typename TString, typename TFormat >
+            inline KStream&
+          read( BasicKSeq< TString >& rec, TFormat tag )
+          {
+            while ( true ) {
+              rec.clear();  // reset all members
+              if ( this->sampler != nullptr && this->ntaken == 0 ) {
+                auto nskip = this->sampler->skip( this->fraction );
+                if ( nskip != 0 && !this->skip( nskip, this->unit, tag ) ) return *this;
+                this->ntaken = this->unit;
+              }
+              if ( this->sampler != nullptr ) --this->ntaken;
+              KFieldSink< TString > name( rec.name, this->fields & field::name );
+              KFieldSink< TString > comment( rec.comment, this->fields & field::comment );
+              if ( this->hasher != nullptr ) this->hasher->reset();
+              KFieldSink< TString > seq( rec.seq, this->fields & field::seq, nullptr, this->hasher.get() );
+              KFieldSink< TString > qual( rec.qual, this->fields & field::qual, this->qmap.get() );
+              if ( this->capture != nullptr ) this->start_capture();
+              bool done;
+              if ( this->validator == nullptr ) {
+                done = this->parse_record( tag, name, comment, seq, qual );
+              }
+              else {
+                auto record = this->counter + this->nfiltered;
+                KValidator::Sink< KFieldSink< TString >, KValidator::seq, KStream >
+                  vseq( seq, *this->validator, this->verror, *this, record );
+                KValidator::Sink< KFieldSink< TString >, KValidator::qual, KStream >
+                  vqual( qual, *this->validator, this->verror, *this, record );
+                done = this->parse_record( tag, name, comment, vseq, vqual );
+              }
+              if ( !done ) continue;
+              if ( this->hasher != nullptr ) this->seqhash = this->hasher->digest();
+              if ( this->capture != nullptr ) this->end_capture( tag );
+              return *this;
+            }
+          }
+
+        /**
+         *  @brief  Read the next record and its raw bytes.
+         *
+         *  The record is parsed as by `read( rec, tag )`, and the input bytes of
+         *  the record are copied into `raw` as well: from its header char to the
+         *  end of its last line (including empty lines and line ends as they are).
+         *  They are collected from the stream buffer chunk by chunk while parsing.
+         */
+        template< typename TString, typename TFormat=format::Mix_ >
+            inline KStream&
+          read( BasicKSeq< TString >& rec, KRaw& raw, TFormat tag=TFormat() )
+          {
+            this->capture = &raw;
+            this->read( rec, tag );
+            this->capture = nullptr;
             return *this;
           }
-          while ( this->getuntil( KStream::SEP_LINE, rec.qual, nullptr, true ) &&
-              rec.qual.size() < rec.seq.size() );
-          if ( this->err() ) return *this;
-          this->is_ready = false;  // we have not come to the next header line
-          if ( rec.seq.size() != rec.qual.size() ) {  // error: qual string is of a different length
-            this->is_tqs = true;  // should return here
+
+        /**
+         *  @brief  Append the raw bytes of at most `n` next records to `bytes`.
+         *
+         *  The records are only scanned for their boundaries (no field is stored),
+         *  and their raw bytes are collected as by `read( rec, raw, tag )`; a line
+         *  end is added to a record lacking one. Filters, subsampling, validation,
+         *  and hashing are not applied. A broken record is not appended.
+         *
+         *  @return the number of appended records.
+         */
+        template< typename TFormat=format::Mix_ >
+            inline unsigned long int
+          read_raw( std::string& bytes, unsigned long int n, TFormat tag=TFormat() )
+          {
+            KRaw raw;
+            unsigned long int i = 0;
+            this->capture = &raw;
+            for ( ; i < n; ++i ) {
+              KSkipSink name, comment, seq, qual;
+              this->start_capture();
+              this->parse( tag, name, comment, seq, qual );
+              if ( this->fail() ) break;
+              this->end_capture( tag );
+              bytes += raw.bytes;
+              if ( raw.bytes.empty() || raw.bytes.back() != '\n' ) bytes += '\n';
+            }
+            this->capture = nullptr;
+            return i;
           }
 
-          return *this;
-        }
+        /**
+         *  @brief  Parse the next record by passing its fields to the given sinks.
+         *
+         *  Each sink should provide `append( const char_type*, size_type )` and
+         *  `size()` methods. The record is parsed from the stream buffer and each
+         *  field is handed to its sink in one or more chunks as it is scanned
+         *  (line separators are excluded).
+         *
+         *  The stream state should be checked afterwards as for `operator>>`.
+         */
+        template< typename TNameSink, typename TCommentSink, typename TSeqSink, typename TQualSink >
+            inline KStream&
+          parse( TNameSink& name, TCommentSink& comment, TSeqSink& seq, TQualSink& qual )
+          {
+            char_type c;
+            this->last = false;
+            if ( !this->is_ready ) {  // then jump to the next header line
+              while ( ( c = this->getc( ) ) && c != '>' && c != '@' );
+              if ( this->fail() ) return *this;
+              this->is_ready = true;
+            }  // else: the first header char has been read in the previous call
+            if ( !this->scanuntil( KStream::SEP_SPACE, name, &c ) ) return *this;
+            if ( c != '\n' ) {  // read FASTA/Q comment
+              this->scanuntil( KStream::SEP_LINE, comment, nullptr );
+            }
+            while ( ( c = this->getc( ) ) && c != '>' && c != '@' && c != '+' ) {
+              if ( c == '\n' ) continue;  // skip empty lines
+              --this->m_begin;  // unget the first char: read the whole line
+              this->scanuntil( KStream::SEP_LINE, seq, nullptr );
+            }
+            this->last = true;
+            ++this->counter;
+            if ( c == '>' || c == '@' ) this->is_ready = true;  // the first header char has been read
+            if ( c != '+' ) return *this;  // FASTA
+            while ( ( c = this->getc( ) ) && c != '\n' );  // skip the rest of '+' line
+            if ( this->eof() ) {  // error: no quality string
+              this->is_tqs = true;
+              return *this;
+            }
+            while ( this->scanuntil( KStream::SEP_LINE, qual, nullptr ) &&
+                qual.size() < seq.size() );
+            if ( this->err() ) return *this;
+            this->is_ready = false;  // we have not come to the next header line
+            if ( seq.size() != qual.size() ) {  // error: qual string is of a different length
+              this->is_tqs = true;  // should return here
+            }
+
+            return *this;
+          }
+
+        template< typename TNameSink, typename TCommentSink, typename TSeqSink, typename TQualSink >
+            inline KStream&
+          parse( format::Mix_, TNameSink& name, TCommentSink& comment, TSeqSink& seq, TQualSink& qual )
+          {
+            return this->parse( name, comment, seq, qual );
+          }
+
+        /**
+         *  @brief  Parse the next FASTA record.
+         *
+         *  Only '>' starts a record; so the lines are not checked for FASTQ
+         *  separators.
+         */
+        template< typename TNameSink, typename TCommentSink, typename TSeqSink, typename TQualSink >
+            inline KStream&
+          parse( format::Fasta_, TNameSink& name, TCommentSink& comment, TSeqSink& seq, TQualSink& )
+          {
+            char_type c;
+            this->last = false;
+            if ( !this->is_ready ) {  // then jump to the next header line
+              while ( ( c = this->getc( ) ) && c != '>' );
+              if ( this->fail() ) return *this;
+              this->is_ready = true;
+            }  // else: the first header char has been read in the previous call
+            if ( !this->scanuntil( KStream::SEP_SPACE, name, &c ) ) return *this;
+            if ( c != '\n' ) {  // read FASTA comment
+              this->scanuntil( KStream::SEP_LINE, comment, nullptr );
+            }
+            while ( ( c = this->getc( ) ) && c != '>' ) {
+              if ( c == '\n' ) continue;  // skip empty lines
+              --this->m_begin;  // unget the first char: read the whole line
+              this->scanuntil( KStream::SEP_LINE, seq, nullptr );
+            }
+            this->last = true;
+            ++this->counter;
+            this->is_ready = ( c == '>' );
+            return *this;
+          }
+
+        /**
+         *  @brief  Parse the next FASTQ record consisting of exactly four lines.
+         *
+         *  When the whole record is in the stream buffer, its four line ends are
+         *  located by `memchr` and the fields are passed to the sinks directly;
+         *  otherwise, it is parsed line by line. A record whose third line does
+         *  not start with '+' is reported as a truncated quality string.
+         */
+        template< typename TNameSink, typename TCommentSink, typename TSeqSink, typename TQualSink >
+            inline KStream&
+          parse( format::FastqStrict_, TNameSink& name, TCommentSink& comment, TSeqSink& seq,
+              TQualSink& qual )
+          {
+            char_type c;
+            this->last = false;
+            if ( !this->is_ready ) {  // then jump to the next header line
+              while ( ( c = this->getc( ) ) && c != '@' );
+              if ( this->fail() ) return *this;
+            }  // else: the first header char has been read in the previous call
+            this->is_ready = false;
+            const char_type* lines[ 4 ];
+            if ( this->find_lines( lines ) ) {
+              const char_type* hdr = this->buf + this->m_begin;
+              const char_type* sep = hdr;
+              while ( !std::isspace( *sep ) ) ++sep;
+              name.append( hdr, sep - hdr );
+              if ( *sep != '\n' ) {
+                comment.append( sep + 1, KStream::chomp( sep + 1, lines[ 0 ] ) - ( sep + 1 ) );
+              }
+              seq.append( lines[ 0 ] + 1, KStream::chomp( lines[ 0 ] + 1, lines[ 1 ] ) - ( lines[ 0 ] + 1 ) );
+              qual.append( lines[ 2 ] + 1, KStream::chomp( lines[ 2 ] + 1, lines[ 3 ] ) - ( lines[ 2 ] + 1 ) );
+              this->m_begin = lines[ 3 ] + 1 - this->buf;
+              this->last = true;
+              ++this->counter;
+            }
+            else {
+              if ( !this->scanuntil( KStream::SEP_SPACE, name, &c ) ) return *this;
+              if ( c != '\n' ) this->scanuntil( KStream::SEP_LINE, comment, nullptr );
+              this->scanuntil( KStream::SEP_LINE, seq, nullptr );
+              this->last = true;
+              ++this->counter;
+              if ( this->getc( ) != '+' ) {  // error: no quality string
+                this->is_tqs = true;
+                return *this;
+              }
+              while ( ( c = this->getc( ) ) && c != '\n' );  // skip the rest of '+' line
+              if ( this->eof() ) {  // error: no quality string
+                this->is_tqs = true;
+                return *this;
+              }
+              this->scanuntil( KStream::SEP_LINE, qual, nullptr );
+              if ( this->err() ) return *this;
+            }
+            if ( seq.size() != qual.size() ) {  // error: qual string is of a different length
+              this->is_tqs = true;
+            }
+            return *this;
+          }
 
         operator bool( ) const
         {
@@ -646,6 +3300,119 @@ namespace klibpp {
           ret.pop_back();
           return ret;
         }
+
+        /**
+         *  @brief  Read a chunk of records into the given vector.
+         *
+         *  The records already in the vector are parsed into; so their strings keep
+         *  their capacity. The vector is resized to the number of read records.
+         *
+         *  @return the number of read records.
+         */
+        template< typename TString, typename TVecAlloc >
+            inline typename std::vector< BasicKSeq< TString >, TVecAlloc >::size_type
+          read( std::vector< BasicKSeq< TString >, TVecAlloc >& recs,
+              typename std::vector< BasicKSeq< TString >, TVecAlloc >::size_type const size )
+          {
+            if ( recs.size() < size ) recs.resize( size );
+            typename std::vector< BasicKSeq< TString >, TVecAlloc >::size_type i = 0;
+            while ( i < size && *this >> recs[ i ] ) ++i;
+            recs.resize( i );
+            return i;
+          }
+
+        /**
+         *  @brief  Draw a uniform random sample of `k` units of the remaining records.
+         *
+         *  It reads the rest of the stream by reservoir sampling (Algorithm L):
+         *  only the records entering the reservoir are parsed; the others are
+         *  scanned for the record boundaries. A unit is `unit_` consecutive
+         *  records (e.g. 2 for interleaved pairs). The sampled records are
+         *  returned in the order of the stream. As in `set_sampling`, sampling
+         *  two streams with the same seed selects the same positions.
+         */
+          inline std::vector< KSeq >
+        sample( std::vector< KSeq >::size_type k, std::uint64_t seed, unsigned int unit_=1 )
+        {
+          using size_type = std::vector< KSeq >::size_type;
+          unit_ = std::max( unit_, 1u );
+          std::vector< std::pair< unsigned long int, std::vector< KSeq > > > reservoir;
+          KSampler rnd( seed );
+          std::vector< KSeq > recs;
+          for ( unsigned long int idx = 0; reservoir.size() < k; ++idx ) {
+            if ( this->read( recs, unit_ ) != unit_ ) break;
+            reservoir.emplace_back( idx, recs );
+          }
+          if ( k != 0 && reservoir.size() == k ) {
+            double w = rnd.weight( k );
+            unsigned long int idx = k;
+            while ( true ) {
+              auto nskip = rnd.skip_reservoir( w );
+              if ( nskip != 0 && !this->skip( nskip, unit_ ) ) break;
+              idx += nskip;
+              auto& slot = reservoir[ rnd.index( k ) ];
+              if ( this->read( recs, unit_ ) != unit_ ) break;
+              slot.first = idx++;
+              std::swap( slot.second, recs );
+              w *= rnd.weight( k );
+            }
+          }
+          std::sort( reservoir.begin(), reservoir.end(),
+                     []( auto const& a, auto const& b ) { return a.first < b.first; } );
+          std::vector< KSeq > ret;
+          ret.reserve( reservoir.size() * unit_ );
+          for ( auto& r : reservoir ) {
+            for ( size_type i = 0; i < r.second.size(); ++i ) ret.push_back( std::move( r.second[ i ] ) );
+          }
+          return ret;
+        }
+
+          inline iterator
+        begin( )
+        {
+          return iterator( this );
+        }
+
+          inline iterator
+        end( )
+        {
+          return iterator( );
+        }
+
+        /**
+         *  @brief  Range over the remaining records in batches of (at most) `size`.
+         */
+          inline batch_range
+        records( std::vector< KSeq >::size_type const size )
+        {
+          return batch_range( this, size );
+        }
+
+        /**
+         *  @brief  Compute summary statistics of the remaining records in the stream.
+         *
+         *  The records are only scanned in the stream buffer and never stored. The
+         *  scan stops at the first malformed record which is not counted. If
+         *  `readahead` is set, the next buffer is fetched (e.g. decompressed) by
+         *  another thread while the current one is being scanned. In that case,
+         *  the read function should be safe to be called from another thread.
+         */
+          inline KStats
+        scan( bool readahead=true )
+        {
+          KStats stats;
+          std::unique_ptr< ReadAhead_ > guard( readahead ? new ReadAhead_( *this ) : nullptr );
+          KStats::QualSink qual;
+          while ( true ) {
+            KSkipSink name;
+            KSkipSink comment;
+            KStats::SeqSink seq;
+            qual.clear();
+            if ( !this->parse( name, comment, seq, qual ) ) break;
+            stats.add( seq, qual );
+          }
+          return stats;
+        }
         /* Low-level methods */
           inline char_type
         getc( ) noexcept  // ks_getc
@@ -653,79 +3420,401 @@ namespace klibpp {
           // error
           if ( this->err() || this->eof() ) return 0;
           // fetch
-          if ( this->begin >= this->end ) {
-            this->begin = 0;
-            this->end = this->func( this->f, this->buf, this->bufsize );
-            if ( this->end <= 0 ) {  // err if end == -1 and eof if 0
+          if ( this->m_begin >= this->m_end ) {
+            this->fetch();
+            if ( this->m_end <= 0 ) {  // err if end == -1 and eof if 0
               this->is_eof = true;
               return 0;
             }
           }
           // ready
-          return this->buf[ this->begin++ ];
+          return this->buf[ this->m_begin++ ];
         }
 
           inline bool
         getuntil( char_type delimiter, std::string& str, char_type *dret, bool append=false )  // ks_getuntil
           noexcept
         {
-          char_type c;
-          bool gotany = false;
-          if ( dret ) *dret = 0;
           if ( !append ) str.clear();
-          size_type i = -1;
-          do {
-            if ( !( c = this->getc( ) ) ) break;
-            --this->begin;
-            if ( delimiter == KStream::SEP_LINE ) {
-              // Incorporate optimization from new seqtk (see : https://github.com/lh3/seqtk/pull/123)
-              // Fabian commmented on this here (https://twitter.com/kloetzl/status/1661679452479266818)
-              // and suggested that std::find() may be more idiomatic.  However, I'm a bit concerned
-              // that may be non-trivially slower than memchr (https://gms.tf/stdfind-and-memchr-optimizations.html).
-              char_type* sep = ( char_type* )std::memchr( this->buf + this->begin, '\n', this->end - this->begin );
-              i = ( sep != nullptr ) ? ( sep - this->buf ) : this->end;
-            }
-            else if ( delimiter > KStream::SEP_MAX ) {
-              for ( i = this->begin; i < this->end; ++i ) {
-                if ( this->buf[ i ] == delimiter ) break;
+          KFieldSink< std::string > sink( str );
+          return this->scanuntil( delimiter, sink, dret );
+        }
+
+        /**
+         *  @brief  Scan the stream until the delimiter and pass the bytes to the sink.
+         *
+         *  The scanned bytes are handed to the sink chunk by chunk directly from the
+         *  stream buffer. When the delimiter is `SEP_LINE`, the trailing '\r' of the
+         *  line, if any, is not passed to the sink.
+         */
+        template< typename TSink >
+            inline bool
+          scanuntil( char_type delimiter, TSink& sink, char_type *dret ) noexcept
+          {
+            char_type c;
+            bool gotany = false;
+            bool cr = false;  // a '\r' at the end of the last chunk is held back
+            if ( dret ) *dret = 0;
+            size_type i = -1;
+            do {
+              if ( !( c = this->getc( ) ) ) break;
+              --this->m_begin;
+              if ( delimiter == KStream::SEP_LINE ) {
+                // Incorporate optimization from new seqtk (see : https://github.com/lh3/seqtk/pull/123)
+                // Fabian commmented on this here (https://twitter.com/kloetzl/status/1661679452479266818)
+                // and suggested that std::find() may be more idiomatic.  However, I'm a bit concerned
+                // that may be non-trivially slower than memchr (https://gms.tf/stdfind-and-memchr-optimizations.html).
+                char_type* sep = ( char_type* )std::memchr( this->buf + this->m_begin, '\n', this->m_end - this->m_begin );
+                i = ( sep != nullptr ) ? ( sep - this->buf ) : this->m_end;
               }
+              else if ( delimiter > KStream::SEP_MAX ) {
+                for ( i = this->m_begin; i < this->m_end; ++i ) {
+                  if ( this->buf[ i ] == delimiter ) break;
+                }
+              }
+              else if ( delimiter == KStream::SEP_SPACE ) {
+                for ( i = this->m_begin; i < this->m_end; ++i ) {
+                  if ( std::isspace( this->buf[ i ] ) ) break;
+                }
+              }
+              else if ( delimiter == KStream::SEP_TAB ) {
+                for ( i = this->m_begin; i < this->m_end; ++i ) {
+                  if ( std::isspace( this->buf[ i ] ) && this->buf[ i ] != ' ' ) break;
+                }
+              }
+              else {
+                assert( false );  // it should not reach here
+                return false;  // when assert is replaced by NOOP
+              }
+
+              gotany = true;
+              size_type j = i;
+              if ( delimiter == KStream::SEP_LINE ) {
+                if ( cr && i != this->m_begin ) sink.append( "\r", 1 );
+                cr = ( i > this->m_begin && this->buf[ i - 1 ] == '\r' );
+                if ( cr ) --j;
+              }
+              sink.append( this->buf + this->m_begin, j - this->m_begin );
+              this->m_begin = i + 1;
+            } while ( i >= this->m_end );
+
+            if ( this->err() || ( this->eof() && !gotany ) ) return false;
+
+            assert( i != -1 );
+            if ( !this->eof() && dret ) *dret = this->buf[ i ];
+            return true;
+          }
+      protected:
+        /* Nested classes */
+        class ReadAhead_ {
+          public:
+            /* Lifecycle */
+            ReadAhead_( KStream& ks_ )
+              : ks( ks_ ), rbuf( ks_.allocate( ks_.bufcap ) ), rend( 0 ), roffset( -1 ),
+              ready( false ), stop( false )
+            {
+              this->ks.ra = this;
+              this->worker = std::thread( [this](){ this->reader(); } );
+              this->ks.affinity.apply( this->worker );
             }
-            else if ( delimiter == KStream::SEP_SPACE ) {
-              for ( i = this->begin; i < this->end; ++i ) {
-                if ( std::isspace( this->buf[ i ] ) ) break;
+
+            ~ReadAhead_( ) noexcept
+            {
+              {
+                std::unique_lock< std::mutex > lock( this->lock );
+                this->stop = true;
               }
+              this->cv.notify_one();
+              this->worker.join();
+              this->ks.ra = nullptr;
+              this->ks.deallocate( this->rbuf );
             }
-            else if ( delimiter == KStream::SEP_TAB ) {
-              for ( i = this->begin; i < this->end; ++i ) {
-                if ( std::isspace( this->buf[ i ] ) && this->buf[ i ] != ' ' ) break;
+            /* Methods */
+            /**
+             *  @brief  Swap the given buffer with the one read ahead.
+             *
+             *  @return the number of bytes in the swapped buffer as returned by the
+             *  read function.
+             */
+              inline size_type
+            take( char_type*& buf_ ) noexcept
+            {
+              size_type ret;
+              {
+                std::unique_lock< std::mutex > lock( this->lock );
+                this->cv.wait( lock, [this]{ return this->ready; } );
+                std::swap( buf_, this->rbuf );
+                ret = this->rend;
+                this->ks.foffset = this->roffset;
+                this->ready = false;
               }
+              this->cv.notify_one();
+              return ret;
             }
-            else {
-              assert( false );  // it should not reach here
-              return false;  // when assert is replaced by NOOP
+          private:
+            /* Data members */
+            KStream& ks;                  /**< @brief the stream */
+            char_type* rbuf;              /**< @brief read-ahead buffer */
+            size_type rend;               /**< @brief end of read-ahead buffer or error flag if -1 */
+            long long int roffset;        /**< @brief file offset after reading ahead (if reporting) */
+            bool ready;                   /**< @brief read-ahead buffer is filled */
+            bool stop;                    /**< @brief thread terminate flag */
+            std::mutex lock;              /**< @brief buffer mutex */
+            std::condition_variable cv;   /**< @brief consumer/producer condition variable */
+            std::thread worker;           /**< @brief worker thread */
+            /* Methods */
+              inline void
+            reader( ) noexcept
+            {
+              size_type n;
+              do {
+                {
+                  std::unique_lock< std::mutex > lock( this->lock );
+                  this->cv.wait( lock, [this]{ return !this->ready || this->stop; } );
+                  if ( this->stop ) break;
+                }
+                // `rbuf` is not touched by the consumer until `ready` is set
+                n = this->ks.func( this->ks.f, this->rbuf, this->ks.bufsize );
+                long long int off = this->ks.reporter ? KFileOffset< TFile >::of( this->ks.f ) : -1;
+                {
+                  std::unique_lock< std::mutex > lock( this->lock );
+                  this->rend = n;
+                  this->roffset = off;
+                  this->ready = true;
+                }
+                this->cv.notify_one();
+              } while ( n > 0 );
             }
+        };
+        /* Methods */
+          inline void
+        fetch( ) noexcept
+        {
+          if ( this->m_end > 0 ) this->nconsumed += this->m_end;
+          if ( this->capture != nullptr && this->m_end > this->cbegin ) {
+            this->capture->bytes.append( this->buf + this->cbegin, this->m_end - this->cbegin );
+          }
+          this->cbegin = 0;
+          this->m_begin = 0;
+          if ( this->ra != nullptr ) this->m_end = this->ra->take( this->buf );
+          else if ( this->tuner == nullptr ) this->m_end = this->func( this->f, this->buf, this->bufsize );
+          else {
+            this->resize( this->tuner->size() );
+            auto start = std::chrono::steady_clock::now();
+            this->m_end = this->func( this->f, this->buf, this->bufsize );
+            std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+            if ( this->m_end > 0 ) this->tuner->observe( this->m_end, elapsed.count() );
+          }
+          if ( this->reporter ) {
+            if ( this->ra == nullptr ) this->foffset = KFileOffset< TFile >::of( this->f );
+            this->report( this->m_end <= 0 );
+          }
+        }
 
-            gotany = true;
-            str.append( this->buf + this->begin, i - this->begin );
-            this->begin = i + 1;
-          } while ( i >= this->end );
+          inline KProgress
+        snapshot( long long int offset ) const
+        {
+          KProgress p;
+          p.records = this->counter;
+          p.bytes = offset >= 0 ? offset : this->tell();
+          p.total = this->total;
+          std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - this->started;
+          p.elapsed = elapsed.count();
+          return p;
+        }
 
-          if ( this->err() || ( this->eof() && !gotany ) ) return false;
+        /**
+         *  @brief  Call the progress callback if the report interval is passed or `force` is set.
+         */
+          inline void
+        report( bool force )
+        {
+          auto now = std::chrono::steady_clock::now();
+          std::chrono::duration< double > since = now - this->reported;
+          if ( !force && since.count() < this->interval ) return;
+          this->reported = now;
+          this->reporter( this->snapshot( this->foffset ) );
+        }
 
-          assert( i != -1 );
-          if ( !this->eof() && dret ) *dret = this->buf[ i ];
-          if ( delimiter == KStream::SEP_LINE && !str.empty() && str.back() == '\r' ) {
-            str.pop_back();
+        /**
+         *  @brief  Set the buffer size; the allocation is reused if it is large enough.
+         *
+         *  NOTE: The buffer content is discarded; so it should be called only when
+         *  the buffer is consumed.
+         */
+          inline void
+        resize( size_type n ) noexcept
+        {
+          if ( n == this->bufsize ) return;
+          if ( n > this->bufcap ) {
+            char_type* nbuf;
+            try {
+              nbuf = this->allocate( n );
+            }
+            catch ( ... ) {
+              return;  // keep the current buffer
+            }
+            this->deallocate( this->buf );
+            this->buf = nbuf;
+            this->bufcap = n;
           }
+          this->bufsize = n;
+        }
+
+        /**
+         *  @brief  Locate the ends of the four lines of a FASTQ record in the buffer.
+         *
+         *  @return `false` if the record is not entirely in the buffer or its
+         *  third line does not start with '+'.
+         */
+          inline bool
+        find_lines( const char_type* ( &lines )[ 4 ] ) const noexcept
+        {
+          const char_type* p = this->buf + this->m_begin;
+          const char_type* end = this->buf + ( this->m_end > 0 ? this->m_end : 0 );
+          for ( int k = 0; k < 4; ++k ) {
+            if ( p >= end ) return false;
+            lines[ k ] = static_cast< const char_type* >( std::memchr( p, '\n', end - p ) );
+            if ( lines[ k ] == nullptr ) return false;
+            p = lines[ k ] + 1;
+          }
+          return *( lines[ 1 ] + 1 ) == '+';
+        }
+
+        /**
+         *  @brief  End of the line [begin, end) excluding a trailing '\r'.
+         */
+          static inline const char_type*
+        chomp( const char_type* begin, const char_type* end ) noexcept
+        {
+          return ( end > begin && *( end - 1 ) == '\r' ) ? end - 1 : end;
+        }
+
+          inline char_type*
+        allocate( std::make_unsigned_t< size_type > n )
+        {
+          return alloc_traits::allocate( this->alloc, n );
+        }
+
+          inline void
+        deallocate( char_type* p ) noexcept
+        {
+          if ( p == nullptr ) return;
+          alloc_traits::deallocate( this->alloc, p, this->bufcap );
+        }
+
+        /**
+         *  @brief  Take the allocator of `other` on move assignment if it propagates.
+         *
+         *  @return `true` if the buffers of `other` can be taken over; i.e. they are
+         *  deallocatable by the allocator of this stream.
+         */
+          inline bool
+        take_alloc( KStream& other, std::true_type )
+        {
+          this->alloc = std::move( other.alloc );
           return true;
         }
+
+          inline bool
+        take_alloc( KStream& other, std::false_type ) const
+        {
+          return this->alloc == other.alloc;
+        }
+
+          inline void
+        start_capture( )
+        {
+          this->capture->clear();
+          if ( this->m_end <= 0 ) this->cbegin = 0;
+          else if ( this->is_ready ) {  // the header char has been read
+            this->cbegin = std::max< size_type >( this->m_begin - 1, 0 );
+          }
+          else this->cbegin = std::min( this->m_begin, this->m_end );
+        }
+
+        /**
+         *  @brief  Complete the raw bytes of the parsed record and locate its fields.
+         */
+        template< typename TFormat >
+            inline void
+          end_capture( TFormat )
+          {
+            KRaw& raw = *this->capture;
+            size_type end = std::min( this->m_begin, this->m_end );
+            if ( this->is_ready && !this->eof() ) --end;  // the next header char is read
+            if ( end > this->cbegin ) raw.bytes.append( this->buf + this->cbegin, end - this->cbegin );
+            this->cbegin = 0;
+            const char* headers = std::is_same< TFormat, format::Fasta_ >::value ? ">" :
+              std::is_same< TFormat, format::FastqStrict_ >::value ? "@" : ">@";
+            auto pos = raw.bytes.find_first_of( headers );
+            if ( pos != 0 && pos != std::string::npos ) raw.bytes.erase( 0, pos );  // skip leading junk
+            pos = raw.bytes.find( '\n' );
+            raw.seq = ( pos == std::string::npos ) ? raw.bytes.size() : pos + 1;
+            if ( std::is_same< TFormat, format::Fasta_ >::value || raw.seq == raw.bytes.size() ) return;
+            pos = raw.bytes.find( "\n+", raw.seq - 1 );
+            if ( pos == std::string::npos ) return;
+            pos = raw.bytes.find( '\n', pos + 1 );
+            raw.qual = ( pos == std::string::npos ) ? raw.bytes.size() : pos + 1;
+          }
+
+        /**
+         *  @brief  Parse the next record into the given sinks checking the filter (if any).
+         *
+         *  @return `false` if the record is rejected by the filter; `true` if it is
+         *  accepted or the stream fails.
+         */
+        template< typename TFormat, typename TNameSink, typename TCommentSink,
+                  typename TSeqSink, typename TQualSink >
+            inline bool
+          parse_record( TFormat tag, TNameSink& name, TCommentSink& comment, TSeqSink& seq,
+              TQualSink& qual )
+          {
+            if ( this->filter == nullptr ) {
+              this->parse( tag, name, comment, seq, qual );
+              return true;
+            }
+            KFilter::Tally tally;
+            KFilter::Sink< TNameSink, KFilter::name > fname( name, *this->filter, tally );
+            KFilter::Sink< TCommentSink, KFilter::comment > fcomment( comment, *this->filter, tally );
+            KFilter::Sink< TSeqSink, KFilter::seq > fseq( seq, *this->filter, tally );
+            KFilter::Sink< TQualSink, KFilter::qual > fqual( qual, *this->filter, tally, this->qmap.get() );
+            this->parse( tag, fname, fcomment, fseq, fqual );
+            if ( this->fail() ||
+                 this->filter->accepts( fname.size(), fseq.size(), fqual.size(), tally ) ) {
+              return true;
+            }
+            --this->counter;
+            ++this->nfiltered;
+            return false;
+          }
+
+        /**
+         *  @brief  Skip `n` units of `unit_` records by only scanning their boundaries.
+         *
+         *  @return `false` if the stream ends (or fails) before skipping them all.
+         */
+        template< typename TFormat=format::Mix_ >
+            inline bool
+          skip( unsigned long int n, unsigned int unit_, TFormat tag=TFormat() )
+          {
+            for ( ; n != 0; --n ) {
+              for ( unsigned int i = 0; i < unit_; ++i ) {
+                KSkipSink name, comment, seq, qual;
+                if ( !this->parse( tag, name, comment, seq, qual ) ) return false;
+                --this->counter;
+                ++this->nfiltered;
+              }
+            }
+            return true;
+          }
     };
 
-  template< typename TFile, typename TFunc >
-    using KStreamIn = KStream< TFile, TFunc, mode::In_ >;
+  template< typename TFile, typename TFunc, typename TAlloc = std::allocator< char > >
+    using KStreamIn = KStream< TFile, TFunc, mode::In_, TAlloc >;
 
-  template< typename TFile, typename TFunc >
-    using KStreamOut = KStream< TFile, TFunc, mode::Out_ >;
+  template< typename TFile, typename TFunc, typename TAlloc = std::allocator< char > >
+    using KStreamOut = KStream< TFile, TFunc, mode::Out_, TAlloc >;
 
   template< typename TFile, typename TFunc, typename TSpec, typename... Args >
       inline KStream< std::decay_t< TFile >, std::decay_t< TFunc >, TSpec >
@@ -0,0 +1,226 @@
+/**
+ *    @file  numa.hpp
+ *   @brief  Huge-page and NUMA-aware buffer allocation.
+ *
+ *  This header file defines `KPageAllocator` which backs the stream buffers
+ *  by page mappings (optionally transparent or explicit huge pages) bound to
+ *  a NUMA node, and `node_affinity` which gives the CPUs of a node to pin the
+ *  stream threads to; so the buffers are placed next to the threads touching
+ *  them.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:49
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_NUMA_HPP__
+#define  KSEQPP_NUMA_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined( __linux__ )
+#include <sys/syscall.h>
+#endif
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  namespace pages {
+    enum Policy {
+      normal = 0,   /**< @brief regular pages */
+      transparent,  /**< @brief transparent huge pages if the kernel grants them */
+      hugetlb       /**< @brief reserved huge pages; regular ones if none is available */
+    };
+  }  /* -----  end of namespace pages  ----- */
+
+  /**
+   *  @brief  Allocator mapping each allocation to its own pages.
+   *
+   *  The pages are bound to the given NUMA node (if not negative) before being
+   *  touched; the binding is a preference: the kernel falls back to other nodes
+   *  when the node is out of memory or NUMA is not supported. Explicit huge
+   *  pages (`pages::hugetlb`) are 2 MiB pages from the pool reserved by the
+   *  administrator (`vm.nr_hugepages`); if the pool is exhausted, regular pages
+   *  advised for transparent huge pages are used instead.
+   *
+   *  Allocations are rounded up to pages, or to huge pages for huge page
+   *  policies if they are at least one huge page large; so it is meant for
+   *  large buffers (see `bufsize` of the streams), not for small objects.
+   */
+  template< typename T >
+    class KPageAllocator {
+      public:
+        /* Typedefs */
+        using value_type = T;
+        using size_type = std::size_t;
+        /* Consts */
+        constexpr static size_type HUGE_PAGE_SIZE = 2097152;
+        /* Lifecycle */
+        KPageAllocator( pages::Policy policy_=pages::transparent, int node_=-1 ) noexcept
+          : policy( policy_ ), node( node_ )
+        { }
+
+        template< typename U >
+          KPageAllocator( KPageAllocator< U > const& other ) noexcept
+            : policy( other.get_policy() ), node( other.get_node() )
+          { }
+        /* Accessors */
+          inline pages::Policy
+        get_policy( ) const
+        {
+          return this->policy;
+        }
+
+          inline int
+        get_node( ) const
+        {
+          return this->node;
+        }
+        /* Methods */
+          inline T*
+        allocate( size_type n )
+        {
+          if ( n > static_cast< size_type >( -1 ) / sizeof( T ) ) throw std::bad_alloc();
+          size_type len = this->length( n * sizeof( T ) );
+          void* p = MAP_FAILED;
+#if defined( MAP_HUGETLB ) && defined( MAP_HUGE_SHIFT )
+          if ( this->policy == pages::hugetlb && len % HUGE_PAGE_SIZE == 0 ) {
+            p = ::mmap( nullptr, len, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | ( 21 << MAP_HUGE_SHIFT ), -1, 0 );
+          }
+#endif
+          if ( p == MAP_FAILED ) p = this->map_aligned( len );
+          if ( p == MAP_FAILED ) throw std::bad_alloc();
+#if defined( MADV_HUGEPAGE )
+          if ( this->policy != pages::normal ) ::madvise( p, len, MADV_HUGEPAGE );
+#endif
+          this->bind( p, len );
+          return static_cast< T* >( p );
+        }
+
+          inline void
+        deallocate( T* p, size_type n ) noexcept
+        {
+          if ( p == nullptr ) return;
+          ::munmap( p, this->length( n * sizeof( T ) ) );
+        }
+
+          inline bool
+        operator==( KPageAllocator const& other ) const noexcept
+        {
+          return this->policy == other.policy && this->node == other.node;
+        }
+
+          inline bool
+        operator!=( KPageAllocator const& other ) const noexcept
+        {
+          return !( *this == other );
+        }
+      private:
+        /* Data members */
+        pages::Policy policy;  /**< @brief page type */
+        int node;              /**< @brief NUMA node (none if negative) */
+        /* Methods */
+        /**
+         *  @brief  Mapped length of an allocation of `n` bytes.
+         *
+         *  It depends only on `n` and the policy; so the same length is unmapped
+         *  whether the huge page pool has served the allocation or not.
+         */
+          inline size_type
+        length( size_type n ) const
+        {
+          size_type unit = static_cast< size_type >( ::sysconf( _SC_PAGESIZE ) );
+          if ( this->policy != pages::normal && n >= HUGE_PAGE_SIZE ) unit = HUGE_PAGE_SIZE;
+          if ( n == 0 ) n = 1;
+          return ( n + unit - 1 ) / unit * unit;
+        }
+
+        /**
+         *  @brief  Map regular pages aligned to huge pages if the length is a multiple of them.
+         *
+         *  Transparent huge pages only back aligned ranges; a larger range is
+         *  mapped and the unaligned head and tail are unmapped.
+         */
+          inline void*
+        map_aligned( size_type len ) const
+        {
+          if ( this->policy == pages::normal || len % HUGE_PAGE_SIZE != 0 ) {
+            return ::mmap( nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+          }
+          void* q = ::mmap( nullptr, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+          if ( q == MAP_FAILED ) return q;
+          char* begin = static_cast< char* >( q );
+          std::uintptr_t addr = reinterpret_cast< std::uintptr_t >( begin );
+          size_type head = ( HUGE_PAGE_SIZE - addr % HUGE_PAGE_SIZE ) % HUGE_PAGE_SIZE;
+          if ( head != 0 ) ::munmap( begin, head );
+          ::munmap( begin + head + len, HUGE_PAGE_SIZE - head );
+          return begin + head;
+        }
+
+          inline void
+        bind( void* p, size_type len ) const noexcept
+        {
+#if defined( __linux__ ) && defined( SYS_mbind )
+          if ( this->node < 0 ) return;
+          constexpr int MPOL_PREFERRED_ = 1;
+          constexpr size_type BITS = 8 * sizeof( unsigned long int );
+          std::vector< unsigned long int > mask( this->node / BITS + 1, 0 );
+          mask[ this->node / BITS ] |= 1UL << ( this->node % BITS );
+          // best effort: the pages are placed by the default policy on failure
+          ::syscall( SYS_mbind, p, len, MPOL_PREFERRED_, mask.data(), mask.size() * BITS + 1, 0 );
+#else
+          (void)p;
+          (void)len;
+#endif
+        }
+    };
+
+  /**
+   *  @brief  CPUs of the given NUMA node.
+   *
+   *  @return an empty set (no pinning) if the node is unknown or the topology is
+   *  not available (it is read from Linux sysfs).
+   */
+    inline KAffinity
+  node_affinity( int node )
+  {
+    std::vector< int > cpus;
+    if ( node < 0 ) return KAffinity();
+    std::ifstream ifs( "/sys/devices/system/node/node" + std::to_string( node ) + "/cpulist" );
+    std::string list;
+    if ( !std::getline( ifs, list ) ) return KAffinity();
+    // e.g. "0-15,32-47"
+    std::size_t pos = 0;
+    while ( pos < list.size() ) {
+      std::size_t end = list.find( ',', pos );
+      if ( end == std::string::npos ) end = list.size();
+      std::string range = list.substr( pos, end - pos );
+      std::size_t dash = range.find( '-' );
+      try {
+        int first = std::stoi( range.substr( 0, dash ) );
+        int last = ( dash == std::string::npos ) ? first : std::stoi( range.substr( dash + 1 ) );
+        for ( int cpu = first; cpu <= last; ++cpu ) cpus.push_back( cpu );
+      }
+      catch ( std::exception const& ) {
+        return KAffinity();
+      }
+      pos = end + 1;
+    }
+    return KAffinity( std::move( cpus ) );
+  }
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_NUMA_HPP__  ----- */
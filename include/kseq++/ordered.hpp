@@ -0,0 +1,304 @@
+/**
+ *    @file  ordered.hpp
+ *   @brief  Multi-producer output front-end.
+ *
+ *  This header file defines `KChunk` class, a buffer in which a producer thread
+ *  formats records, and `KOrderedStreamOut` class which passes the submitted
+ *  chunks of several producers to a single output stream in their sequence
+ *  order (or in their arrival order).
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:32
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_ORDERED_HPP__
+#define  KSEQPP_ORDERED_HPP__
+
+#include <cstdint>
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  /**
+   *  @brief  Buffer of formatted records.
+   *
+   *  Records are formatted exactly as the output stream would do; the format,
+   *  line wrapping, and quality map are taken from the stream when the chunk is
+   *  made by `KOrderedStreamOut::chunk`. A chunk is owned by one producer.
+   */
+  class KChunk {
+    public:
+      /* Typedefs */
+      using size_type = std::string::size_type;
+      /* Lifecycle */
+      KChunk( format::Format fmt_=format::mix, unsigned int wraplen_=0,
+          KQualMap const* qmap_=nullptr )
+        : fmt( fmt_ ), wraplen( wraplen_ ), qmap( qmap_ ), counter( 0 )
+      { }
+      /* Accessors */
+      /**
+       *  @brief  Number of records in the chunk.
+       */
+        inline unsigned long int
+      counts( ) const
+      {
+        return this->counter;
+      }
+
+        inline size_type
+      size( ) const
+      {
+        return this->buf.size();
+      }
+
+        inline std::string const&
+      data( ) const
+      {
+        return this->buf;
+      }
+      /* Methods */
+      template< typename TString >
+          inline KChunk&
+        operator<<( BasicKSeq< TString > const& rec )
+        {
+          put_record_( *this, rec, this->fmt, this->qmap );
+          ++this->counter;
+          return *this;
+        }
+
+        inline void
+      clear( )
+      {
+        this->buf.clear();
+        this->counter = 0;
+      }
+
+      /**
+       *  @brief  Exchange the buffer with the given one (to recycle its capacity).
+       */
+        inline void
+      swap_buffer( std::string& other )
+      {
+        this->buf.swap( other );
+      }
+      /* Low-level methods */
+      template< typename TTraits, typename TStrAlloc >
+          inline void
+        puts( std::basic_string< char, TTraits, TStrAlloc > const& s, KQualMap const* map=nullptr )
+        {
+          using str_size_type = typename std::basic_string< char, TTraits, TStrAlloc >::size_type;
+          str_size_type cursor = 0;
+          while ( cursor != s.size() ) {
+            if ( this->wraplen && cursor != 0 ) this->buf += '\n';
+            str_size_type len = s.size() - cursor;
+            if ( this->wraplen ) len = std::min( len, static_cast< str_size_type >( this->wraplen ) );
+            size_type pos = this->buf.size();
+            this->buf.append( &s[ cursor ], len );
+            if ( map != nullptr ) map->apply( &this->buf[ pos ], &s[ cursor ], len );
+            cursor += len;
+          }
+        }
+
+        inline void
+      puts( char c )
+      {
+        this->buf += c;
+      }
+    private:
+      /* Data members */
+      std::string buf;           /**< @brief formatted records */
+      format::Format fmt;        /**< @brief format of the records */
+      unsigned int wraplen;      /**< @brief line wrap length */
+      KQualMap const* qmap;      /**< @brief quality transform (if any) */
+      unsigned long int counter; /**< @brief number of records */
+  };
+
+  /**
+   *  @brief  Thread-safe front-end of an output stream.
+   *
+   *  Producers format records into their own `KChunk`s in parallel and submit
+   *  them with consecutive sequence numbers starting from zero. Chunks are
+   *  written to the stream in the sequence order (or as they arrive if not
+   *  `ordered`): a chunk arriving early waits in the reorder buffer, and the
+   *  producer whose submission fills the gap writes all ready chunks. So the
+   *  stream is accessed by one thread at a time and only its buffer copy is
+   *  serialised; compression and I/O are still done by the stream's writer
+   *  thread.
+   *
+   *  At most `capacity` chunks wait in the reorder buffer; a producer which is
+   *  too far ahead blocks until the gap is filled. The stream should not be used
+   *  directly while the front-end is in use, and it should be flushed by the
+   *  caller after all chunks are submitted.
+   */
+  template< typename TStream >
+    class KOrderedStreamOut {
+      public:
+        /* Typedefs */
+        using stream_type = TStream;
+        using seq_type = std::uint64_t;
+        using size_type = std::vector< std::string >::size_type;
+        /* Consts */
+        constexpr static size_type DEFAULT_CAPACITY = 64;
+        /* Lifecycle */
+        explicit KOrderedStreamOut( stream_type& out_, bool ordered_=true,
+            size_type capacity_=DEFAULT_CAPACITY )
+          : out( out_ ), ordered( ordered_ ), capacity( std::max< size_type >( capacity_, 1 ) ),
+          next_seq( 0 ), nsubmitted( 0 ), writing( false ), counter( 0 ), failed( false )
+        { }
+
+        KOrderedStreamOut( KOrderedStreamOut const& ) = delete;
+        KOrderedStreamOut& operator=( KOrderedStreamOut const& ) = delete;
+        /* Accessors */
+        /**
+         *  @brief  Number of records written to the stream so far.
+         */
+          inline unsigned long int
+        counts( ) const
+        {
+          std::unique_lock< std::mutex > lock( this->mutex );
+          return this->counter;
+        }
+
+        /**
+         *  @brief  Number of submitted chunks waiting for a missing one.
+         */
+          inline size_type
+        pending( ) const
+        {
+          std::unique_lock< std::mutex > lock( this->mutex );
+          return this->ready.size();
+        }
+        /* Methods */
+        /**
+         *  @brief  Make an empty chunk formatting records as the stream does.
+         */
+          inline KChunk
+        chunk( ) const
+        {
+          return KChunk( this->out.get_format(), this->out.get_wraplen(), this->out.get_qualmap() );
+        }
+
+        /**
+         *  @brief  Submit the chunk with the given sequence number.
+         *
+         *  The chunk is cleared and can be reused by the producer. The sequence
+         *  number is ignored if the front-end is not `ordered`.
+         *
+         *  @return `false` if the stream has failed.
+         *
+         *  @throw  std::invalid_argument if the sequence number has been already
+         *  submitted; the chunk is left untouched.
+         */
+          inline bool
+        submit( seq_type seq, KChunk& chunk )
+        {
+          std::unique_lock< std::mutex > lock( this->mutex );
+          if ( this->ordered ) {
+            this->check_seq( seq );
+            this->cv.wait( lock, [this, seq]{
+                  return seq == this->next_seq || this->ready.size() < this->capacity || this->failed;
+                } );
+            this->check_seq( seq );  // submitted by another producer meanwhile
+          }
+          else {
+            this->cv.wait( lock, [this]{ return this->ready.size() < this->capacity || this->failed; } );
+            seq = this->nsubmitted++;
+          }
+          if ( this->failed ) {
+            chunk.clear();
+            return false;
+          }
+          Entry_& entry = this->ready[ seq ];
+          entry.counter = chunk.counts();
+          if ( !this->spare.empty() ) {
+            entry.buf.swap( this->spare.back() );
+            this->spare.pop_back();
+          }
+          chunk.swap_buffer( entry.buf );
+          chunk.clear();
+          if ( this->writing ) return true;  // the writing producer picks it up
+          this->drain( lock );
+          return !this->failed;
+        }
+
+        /**
+         *  @brief  Submit the chunk in the arrival order (only if not `ordered`).
+         */
+          inline bool
+        submit( KChunk& chunk )
+        {
+          return this->submit( 0, chunk );
+        }
+
+        operator bool( ) const
+        {
+          std::unique_lock< std::mutex > lock( this->mutex );
+          return !this->failed;
+        }
+      private:
+        /* Nested classes */
+        struct Entry_ {
+          std::string buf;            /**< @brief formatted records */
+          unsigned long int counter;  /**< @brief number of records */
+        };
+        /* Data members */
+        stream_type& out;                        /**< @brief output stream */
+        bool ordered;                            /**< @brief write in the sequence order */
+        size_type capacity;                      /**< @brief maximum number of waiting chunks */
+        seq_type next_seq;                       /**< @brief sequence number of the next chunk to write */
+        seq_type nsubmitted;                     /**< @brief number of submitted chunks (if not `ordered`) */
+        bool writing;                            /**< @brief a producer is writing to the stream */
+        unsigned long int counter;               /**< @brief number of written records */
+        bool failed;                             /**< @brief the stream has failed */
+        std::map< seq_type, Entry_ > ready;      /**< @brief reorder buffer */
+        std::vector< std::string > spare;        /**< @brief written buffers to be recycled */
+        mutable std::mutex mutex;                /**< @brief state mutex */
+        std::condition_variable cv;              /**< @brief waiting producers */
+        /* Methods */
+          inline void
+        check_seq( seq_type seq ) const
+        {
+          if ( seq < this->next_seq || this->ready.count( seq ) ) {
+            throw std::invalid_argument( "chunk " + std::to_string( seq ) + " is already submitted" );
+          }
+        }
+
+        /**
+         *  @brief  Write the ready chunks in order; the lock is released while writing.
+         */
+          inline void
+        drain( std::unique_lock< std::mutex >& lock )
+        {
+          this->writing = true;
+          while ( !this->ready.empty() && this->ready.begin()->first == this->next_seq && !this->failed ) {
+            Entry_ entry = std::move( this->ready.begin()->second );
+            this->ready.erase( this->ready.begin() );
+            ++this->next_seq;
+            lock.unlock();
+            bool ok = this->out.write( entry.buf.data(), entry.buf.size() );
+            lock.lock();
+            if ( ok ) this->counter += entry.counter;
+            else this->failed = true;
+            entry.buf.clear();
+            if ( this->spare.size() < this->capacity ) this->spare.push_back( std::move( entry.buf ) );
+            this->cv.notify_all();
+          }
+          this->writing = false;
+        }
+    };
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_ORDERED_HPP__  ----- */
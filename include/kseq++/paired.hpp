@@ -0,0 +1,474 @@
+/**
+ *    @file  paired.hpp
+ *   @brief  Paired-end input stream.
+ *
+ *  This header file defines `KPairedStreamIn` class which reads paired-end records
+ *  from two input streams (or one interleaved stream) in lockstep while each stream
+ *  is read and parsed in its own thread.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  09:45
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_PAIRED_HPP__
+#define  KSEQPP_PAIRED_HPP__
+
+#include <deque>
+#include <utility>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  struct KSeqPair {
+    KSeq first;
+    KSeq second;
+    inline void clear( ) {
+      first.clear();
+      second.clear();
+    }
+  };
+
+  /**
+   *  @brief  Read batches of records from an input stream in a separate thread.
+   *
+   *  The batches are recycled: the records of a batch which is given back by the
+   *  consumer are parsed into again, so their strings keep their capacity.
+   */
+  template< typename TStream >
+    class KBatchReader_ {
+      public:
+        /* Typedefs */
+        using stream_type = TStream;
+        using size_type = std::vector< KSeq >::size_type;
+        /* Consts */
+        constexpr static size_type DEPTH = 2;  /**< @brief number of batches in flight */
+        /* Nested classes */
+        struct Batch {
+          std::vector< KSeq > records;          /**< @brief record buffer */
+          std::vector< std::uint64_t > hashes;  /**< @brief sequence hashes (if the stream is hashing) */
+          size_type size;                       /**< @brief number of valid records */
+        };
+        /* Lifecycle */
+        KBatchReader_( stream_type&& ks_, size_type bs_ )
+          : ks( std::move( ks_ ) ), batchsize( bs_ ), done( false ), stop( false )
+        {
+          for ( size_type i = 0; i < DEPTH; ++i ) {
+            this->free.emplace_back();
+            this->free.back().records.resize( this->batchsize );
+            this->free.back().size = 0;
+          }
+          this->worker = std::thread( [this](){ this->reader(); } );
+        }
+
+        KBatchReader_( KBatchReader_ const& ) = delete;
+        KBatchReader_& operator=( KBatchReader_ const& ) = delete;
+
+        ~KBatchReader_( ) noexcept
+        {
+          {
+            std::unique_lock< std::mutex > lock( this->lock );
+            this->stop = true;
+          }
+          this->cv.notify_all();
+          if ( this->worker.joinable() ) this->worker.join();
+        }
+        /* Accessors */
+        /**
+         *  @brief  Whether the reader thread is done with the stream.
+         */
+          inline bool
+        finished( ) const
+        {
+          std::unique_lock< std::mutex > lock( this->lock );
+          return this->done;
+        }
+
+        /**
+         *  @brief  The underlying stream.
+         *
+         *  NOTE: It should not be accessed until the reader is `finished`.
+         */
+          inline stream_type const&
+        stream( ) const
+        {
+          return this->ks;
+        }
+        /* Mutators */
+        /**
+         *  @brief  Pin the reader thread to the given CPUs.
+         *
+         *  @return `false` if the thread could not be pinned (see `KAffinity`).
+         */
+          inline bool
+        set_affinity( KAffinity const& aff )
+        {
+          return aff.apply( this->worker );
+        }
+        /* Methods */
+        /**
+         *  @brief  Swap the given batch with the next parsed one.
+         *
+         *  The given batch is recycled by the reader thread.
+         *
+         *  @return `false` if there is no more batch; otherwise `true`.
+         */
+          inline bool
+        next( Batch& batch )
+        {
+          {
+            std::unique_lock< std::mutex > lock( this->lock );
+            this->cv.wait( lock, [this]{ return !this->full.empty() || this->done; } );
+            if ( this->full.empty() ) return false;
+            std::swap( batch, this->full.front() );
+            this->free.push_back( std::move( this->full.front() ) );
+            this->full.pop_front();
+          }
+          this->cv.notify_all();
+          if ( batch.records.size() < this->batchsize ) batch.records.resize( this->batchsize );
+          return true;
+        }
+      private:
+        /* Data members */
+        stream_type ks;              /**< @brief input stream */
+        size_type batchsize;         /**< @brief number of records in each batch */
+        std::deque< Batch > free;    /**< @brief batches to be filled */
+        std::deque< Batch > full;    /**< @brief filled batches */
+        bool done;                   /**< @brief no more batches will be produced */
+        bool stop;                   /**< @brief thread terminate flag */
+        mutable std::mutex lock;     /**< @brief queues mutex */
+        std::condition_variable cv;  /**< @brief consumer/producer condition variable */
+        std::thread worker;          /**< @brief reader thread */
+        /* Methods */
+          inline void
+        reader( ) noexcept
+        {
+          Batch batch;
+          bool last = false;
+          while ( !last ) {
+            {
+              std::unique_lock< std::mutex > lock( this->lock );
+              this->cv.wait( lock, [this]{ return !this->free.empty() || this->stop; } );
+              if ( this->stop ) break;
+              batch = std::move( this->free.front() );
+              this->free.pop_front();
+            }
+            if ( batch.records.size() < this->batchsize ) batch.records.resize( this->batchsize );
+            batch.size = 0;
+            if ( batch.hashes.size() < this->batchsize ) batch.hashes.resize( this->batchsize );
+            while ( batch.size < this->batchsize && this->ks >> batch.records[ batch.size ] ) {
+              batch.hashes[ batch.size ] = this->ks.hash();
+              ++batch.size;
+            }
+            last = ( batch.size < this->batchsize );
+            {
+              std::unique_lock< std::mutex > lock( this->lock );
+              if ( batch.size != 0 ) this->full.push_back( std::move( batch ) );
+              else this->free.push_back( std::move( batch ) );
+              if ( last ) this->done = true;
+            }
+            this->cv.notify_all();
+          }
+        }
+    };
+
+  /**
+   *  @brief  Paired-end input stream.
+   *
+   *  It reads the mates from two streams (or consecutive records from one
+   *  interleaved stream) in lockstep. Each stream is read and parsed by its own
+   *  thread ahead of the consumer; so decompressing the two files overlaps.
+   *
+   *  If name checking is enabled, the names of the mates should be identical
+   *  ignoring a "/1" or "/2" suffix; otherwise, the stream fails and `unpaired()`
+   *  is set.
+   */
+  template< typename TStream >
+    class KPairedStreamIn {
+      public:
+        /* Typedefs */
+        using stream_type = TStream;
+        using reader_type = KBatchReader_< stream_type >;
+        using size_type = typename reader_type::size_type;
+        /* Consts */
+        constexpr static size_type DEFAULT_BATCHSIZE = 1024;
+        /* Lifecycle */
+        KPairedStreamIn( stream_type&& ks1, stream_type&& ks2, bool check_=true,
+            size_type bs_=DEFAULT_BATCHSIZE )
+          : r1( new reader_type( std::move( ks1 ), bs_ ) ),
+          r2( new reader_type( std::move( ks2 ), bs_ ) ),
+          check( check_ )
+        {
+          this->init();
+        }
+
+        KPairedStreamIn( stream_type&& ks, bool check_=true,
+            size_type bs_=DEFAULT_BATCHSIZE )
+          : r1( new reader_type( std::move( ks ), 2 * bs_ ) ), r2( nullptr ),
+          check( check_ )
+        {
+          this->init();
+        }
+        /* Accessors */
+          inline unsigned long int
+        counts( ) const
+        {
+          return this->counter;
+        }
+
+          inline bool
+        is_interleaved( ) const
+        {
+          return this->r2 == nullptr;
+        }
+
+        /**
+         *  @brief  Hash of the last pair combining the sequence hashes of its mates.
+         *
+         *  The input streams should be set to hash the sequences (`set_hashing`)
+         *  before being passed to the constructor.
+         */
+          inline std::uint64_t
+        hash( ) const
+        {
+          return this->pairhash;
+        }
+
+          inline bool
+        is_hashing( ) const
+        {
+          return this->r1->stream().is_hashing() && ( !this->r2 || this->r2->stream().is_hashing() );
+        }
+        /* Mutators */
+        /**
+         *  @brief  Pin the reader threads of the first and the second mates to the given CPUs.
+         */
+          inline bool
+        set_affinity( KAffinity const& aff1, KAffinity const& aff2 )
+        {
+          bool ret = this->r1->set_affinity( aff1 );
+          if ( this->r2 ) ret = this->r2->set_affinity( aff2 ) && ret;
+          return ret;
+        }
+
+          inline bool
+        set_affinity( KAffinity const& aff )
+        {
+          return this->set_affinity( aff, aff );
+        }
+        /* Methods */
+        /**
+         *  @brief  Whether the mates are out of sync.
+         *
+         *  It is set when mate names do not match (if checking is enabled) or
+         *  when one of the files has fewer records than the other.
+         */
+          inline bool
+        unpaired( ) const
+        {
+          return this->is_unpaired;
+        }
+
+          inline bool
+        err( ) const
+        {
+          return ( this->r1->finished() && this->r1->stream().err() ) ||
+            ( this->r2 && this->r2->finished() && this->r2->stream().err() );
+        }
+
+          inline bool
+        tqs( ) const
+        {
+          return ( this->r1->finished() && this->r1->stream().tqs() ) ||
+            ( this->r2 && this->r2->finished() && this->r2->stream().tqs() );
+        }
+
+          inline bool
+        eof( ) const
+        {
+          return this->is_done;
+        }
+
+          inline bool
+        fail( ) const
+        {
+          return this->unpaired() || this->err() || this->tqs() || ( this->eof() && !this->last );
+        }
+
+        operator bool( ) const
+        {
+          return !this->fail();
+        }
+
+          inline KPairedStreamIn&
+        operator>>( KSeqPair& pair )
+        {
+          this->last = false;
+          if ( this->fail() ) return *this;
+          // the records are swapped out right away: fetching the next one may recycle the batch
+          std::uint64_t h1 = 0;
+          std::uint64_t h2 = 0;
+          KSeq* m1 = this->fetch( this->r1, this->b1, this->i1, h1 );
+          if ( m1 != nullptr ) std::swap( pair.first, *m1 );
+          KSeq* m2 = this->is_interleaved() ? this->fetch( this->r1, this->b1, this->i1, h2 )
+                                            : this->fetch( this->r2, this->b2, this->i2, h2 );
+          if ( m2 != nullptr ) std::swap( pair.second, *m2 );
+          this->pairhash = KHash64::combine( h1, h2 );
+          if ( m1 == nullptr && m2 == nullptr ) {
+            this->is_done = true;
+            return *this;
+          }
+          if ( m1 == nullptr || m2 == nullptr ) {  // one file ended before the other
+            this->is_done = true;
+            this->is_unpaired = true;
+            return *this;
+          }
+          if ( this->check && !KPairedStreamIn::is_mate( pair.first.name, pair.second.name ) ) {
+            this->is_unpaired = true;
+            return *this;
+          }
+          this->last = true;
+          ++this->counter;
+          return *this;
+        }
+
+          inline std::vector< KSeqPair >
+        read( typename std::vector< KSeqPair >::size_type const size )
+        {
+          std::vector< KSeqPair > ret;
+          ret.reserve( size );
+          for ( typename std::vector< KSeqPair >::size_type i = 0; i < size; ++i ) {
+            ret.emplace_back();
+            *this >> ret.back();
+            if ( !( *this ) ) {
+              ret.pop_back();
+              break;
+            }
+          }
+          return ret;
+        }
+
+          inline std::vector< KSeqPair >
+        read( )
+        {
+          std::vector< KSeqPair > ret;
+          while ( ( ret.emplace_back(), true ) && *this >> ret.back() );
+          ret.pop_back();
+          return ret;
+        }
+
+        /**
+         *  @brief  Check if two read names belong to the mates of a pair.
+         *
+         *  The names should be equal ignoring "/1" and "/2" suffixes.
+         */
+          static inline bool
+        is_mate( std::string const& name1, std::string const& name2 )
+        {
+          auto len1 = KPairedStreamIn::strip_len( name1 );
+          auto len2 = KPairedStreamIn::strip_len( name2 );
+          return len1 == len2 && name1.compare( 0, len1, name2, 0, len2 ) == 0;
+        }
+      private:
+        /* Typedefs */
+        using batch_type = typename reader_type::Batch;
+        /* Data members */
+        std::unique_ptr< reader_type > r1;  /**< @brief first mates reader */
+        std::unique_ptr< reader_type > r2;  /**< @brief second mates reader (null if interleaved) */
+        batch_type b1;                      /**< @brief current batch of the first mates */
+        batch_type b2;                      /**< @brief current batch of the second mates */
+        size_type i1;                       /**< @brief next record index in `b1` */
+        size_type i2;                       /**< @brief next record index in `b2` */
+        bool check;                         /**< @brief check mate names */
+        bool is_done;                       /**< @brief no more records */
+        bool is_unpaired;                   /**< @brief mates are out of sync */
+        bool last;                          /**< @brief last read was successful */
+        unsigned long int counter;          /**< @brief number of pairs read so far */
+        std::uint64_t pairhash;             /**< @brief hash of the last pair */
+        /* Methods */
+          inline void
+        init( )
+        {
+          this->b1.size = 0;
+          this->b2.size = 0;
+          this->i1 = 0;
+          this->i2 = 0;
+          this->is_done = false;
+          this->is_unpaired = false;
+          this->last = false;
+          this->counter = 0;
+          this->pairhash = 0;
+        }
+
+          static inline KSeq*
+        fetch( std::unique_ptr< reader_type >& reader, batch_type& batch, size_type& idx,
+            std::uint64_t& hash )
+        {
+          if ( idx >= batch.size ) {
+            if ( !reader->next( batch ) ) return nullptr;
+            idx = 0;
+          }
+          hash = batch.hashes[ idx ];
+          return &batch.records[ idx++ ];
+        }
+
+          static inline std::string::size_type
+        strip_len( std::string const& name )
+        {
+          auto len = name.size();
+          if ( len >= 2 && name[ len - 2 ] == '/' &&
+               ( name[ len - 1 ] == '1' || name[ len - 1 ] == '2' ) ) {
+            return len - 2;
+          }
+          return len;
+        }
+    };
+
+  /**
+   *  @brief  Draw a uniform random sample of `k` pairs from two mate streams.
+   *
+   *  Both streams are reservoir sampled with the same seed; so the mates are
+   *  selected at the same positions. The streams should have the same number
+   *  of records; otherwise, the samples are truncated to the shorter one and
+   *  may not be paired.
+   *
+   *  To subsample a fraction of the pairs, call `set_sampling` with the same
+   *  seed on both streams before passing them to `KPairedStreamIn`.
+   */
+  template< typename TStream >
+      inline std::vector< KSeqPair >
+    sample_pairs( TStream& ks1, TStream& ks2, std::vector< KSeqPair >::size_type k,
+        std::uint64_t seed )
+    {
+      auto mates1 = ks1.sample( k, seed );
+      auto mates2 = ks2.sample( k, seed );
+      std::vector< KSeqPair > ret( std::min( mates1.size(), mates2.size() ) );
+      for ( std::vector< KSeqPair >::size_type i = 0; i < ret.size(); ++i ) {
+        ret[ i ].first = std::move( mates1[ i ] );
+        ret[ i ].second = std::move( mates2[ i ] );
+      }
+      return ret;
+    }
+
+  /**
+   *  @brief  Draw a uniform random sample of `k` pairs from an interleaved stream.
+   */
+  template< typename TStream >
+      inline std::vector< KSeqPair >
+    sample_pairs( TStream& ks, std::vector< KSeqPair >::size_type k, std::uint64_t seed )
+    {
+      auto mates = ks.sample( k, seed, 2 );
+      std::vector< KSeqPair > ret( mates.size() / 2 );
+      for ( std::vector< KSeqPair >::size_type i = 0; i < ret.size(); ++i ) {
+        ret[ i ].first = std::move( mates[ 2 * i ] );
+        ret[ i ].second = std::move( mates[ 2 * i + 1 ] );
+      }
+      return ret;
+    }
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_PAIRED_HPP__  ----- */
@@ -0,0 +1,206 @@
+/**
+ *    @file  pipeio.hpp
+ *   @brief  Pipe-aware input and output streams.
+ *
+ *  This header file defines `PipeStreamIn` and `PipeStreamOut` classes which read
+ *  from and write to file descriptors (by default, standard input and output).
+ *  When a descriptor is a pipe, its capacity is enlarged, and the rest of an
+ *  input can be passed through to an output by `splice` without being copied to
+ *  the user space (Linux only; otherwise, it falls back to `read`/`write`).
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:19
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_PIPEIO_HPP__
+#define  KSEQPP_PIPEIO_HPP__
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  namespace pipeio {
+    /* Consts */
+    constexpr long int PIPE_SIZE = 1048576;      /**< @brief requested pipe capacity (default maximum for unprivileged users) */
+    constexpr long int SPLICE_CHUNK = 1048576;   /**< @brief maximum bytes moved by one `splice` call */
+    constexpr long int COPY_BUFSIZE = 131072;    /**< @brief buffer size of the `read`/`write` fallback */
+
+      inline bool
+    is_pipe( int fd )
+    {
+      struct stat st;
+      return ::fstat( fd, &st ) == 0 && S_ISFIFO( st.st_mode );
+    }
+
+    /**
+     *  @brief  Set the capacity of the pipe (if supported).
+     *
+     *  @return the resulting capacity or -1 if it cannot be set; e.g. the
+     *  descriptor is not a pipe or the size exceeds the system limit.
+     */
+      inline long int
+    set_pipe_size( int fd, long int size=PIPE_SIZE )
+    {
+#ifdef F_SETPIPE_SZ
+      if ( !is_pipe( fd ) ) return -1;
+      return ::fcntl( fd, F_SETPIPE_SZ, static_cast< int >( size ) );
+#else
+      (void)fd;
+      (void)size;
+      return -1;
+#endif
+    }
+
+    /**
+     *  @brief  Read function of the input stream: `read(2)` retried on interrupts.
+     */
+      inline long int
+    read( int fd, char* buf, long int size )
+    {
+      ssize_t n;
+      while ( ( n = ::read( fd, buf, size ) ) < 0 && errno == EINTR );
+      return n;
+    }
+
+    /**
+     *  @brief  Write function of the output stream: write all `size` bytes.
+     *
+     *  @return `size` on success or 0 on error.
+     */
+      inline long int
+    write( int fd, const char* buf, long int size )
+    {
+      long int total = 0;
+      while ( total < size ) {
+        ssize_t n = ::write( fd, buf + total, size - total );
+        if ( n < 0 && errno == EINTR ) continue;
+        if ( n <= 0 ) return 0;
+        total += n;
+      }
+      return size;
+    }
+
+    /**
+     *  @brief  Copy all remaining bytes from one descriptor to another.
+     *
+     *  If either is a pipe, the bytes are moved by `splice` within the kernel;
+     *  otherwise (or if `splice` is not supported for them), they are copied by
+     *  `read` and `write`.
+     *
+     *  @return the number of copied bytes or -1 on error.
+     */
+      inline long long int
+    copy( int in, int out )
+    {
+      long long int total = 0;
+#if defined( __linux__ ) && defined( SPLICE_F_MOVE )
+      if ( is_pipe( in ) || is_pipe( out ) ) {
+        while ( true ) {
+          ssize_t n = ::splice( in, nullptr, out, nullptr, SPLICE_CHUNK,
+                                SPLICE_F_MOVE | SPLICE_F_MORE );
+          if ( n > 0 ) total += n;
+          else if ( n == 0 ) return total;
+          else if ( errno == EINTR ) continue;
+          else if ( errno == EINVAL && total == 0 ) break;  // then fall back
+          else return -1;
+        }
+      }
+#endif
+      std::unique_ptr< char[] > buf( new char[ COPY_BUFSIZE ] );
+      long int n;
+      while ( ( n = pipeio::read( in, buf.get(), COPY_BUFSIZE ) ) > 0 ) {
+        if ( pipeio::write( out, buf.get(), n ) != n ) return -1;
+        total += n;
+      }
+      return n < 0 ? -1 : total;
+    }
+  }  /* -----  end of namespace pipeio  ----- */
+
+  class PipeStreamIn
+    : public KStreamIn< int, long int(*)( int, char*, long int ) > {
+    public:
+      /* Typedefs */
+      typedef KStreamIn< int, long int(*)( int, char*, long int ) > base_type;
+      /* Lifecycle */
+      /**
+       *  @brief  Input stream reading from the given descriptor.
+       *
+       *  If it is a pipe, its capacity is enlarged and the stream buffer is as
+       *  large as the pipe; so each refill drains the pipe.
+       */
+      PipeStreamIn( int fd=STDIN_FILENO, bool close_fd=false )
+        : base_type( fd, pipeio::read, PipeStreamIn::bufsize_of( fd ),
+            close_fd ? ::close : nullptr )
+      { }
+      /* Methods */
+      /**
+       *  @brief  Pass the rest of the input through to the given descriptor.
+       *
+       *  The unparsed bytes in the stream buffer are written first (starting from
+       *  the header of the next record), and then the remaining input is copied
+       *  by `pipeio::copy`. The stream is at its end afterwards. Any buffered
+       *  output to the descriptor should be flushed before.
+       *
+       *  @return the number of bytes written or -1 on error.
+       */
+        inline long long int
+      passthrough( int out )
+      {
+        if ( this->err() ) return -1;
+        long long int total = 0;
+        if ( this->m_end > 0 ) {
+          size_type begin = std::min( this->m_begin, this->m_end );
+          if ( this->is_ready && begin > 0 ) --begin;  // the header char has been read
+          long int len = this->m_end - begin;
+          if ( pipeio::write( out, this->buf + begin, len ) != len ) return -1;
+          total += len;
+        }
+        this->m_begin = this->m_end = 0;
+        this->is_eof = true;
+        long long int n = pipeio::copy( this->f, out );
+        return n < 0 ? -1 : total + n;
+      }
+    private:
+      /* Methods */
+        static inline std::make_unsigned_t< size_type >
+      bufsize_of( int fd )
+      {
+        long int size = pipeio::set_pipe_size( fd );
+        return size > static_cast< long int >( base_type::DEFAULT_BUFSIZE ) ? size : base_type::DEFAULT_BUFSIZE;
+      }
+  };
+
+  /**
+   *  @brief  Output stream writing to the given descriptor.
+   *
+   *  If it is a pipe, its capacity is enlarged so that the writer thread is
+   *  blocked less often by a slower reader.
+   *
+   *  NOTE: The output buffers are written by `write(2)` rather than `vmsplice`:
+   *  the stream reuses its buffers as soon as they are written, while pages
+   *  passed by `vmsplice` must not be modified until the reader consumes them.
+   */
+  class PipeStreamOut
+    : public KStreamOut< int, long int(*)( int, const char*, long int ) > {
+    public:
+      /* Typedefs */
+      typedef KStreamOut< int, long int(*)( int, const char*, long int ) > base_type;
+      /* Lifecycle */
+      PipeStreamOut( int fd=STDOUT_FILENO, format::Format fmt=base_type::DEFAULT_FORMAT,
+                     bool close_fd=false )
+        : base_type( ( pipeio::set_pipe_size( fd ), fd ), pipeio::write, fmt,
+            close_fd ? ::close : nullptr )
+      { }
+  };
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_PIPEIO_HPP__  ----- */
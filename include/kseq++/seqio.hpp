@@ -19,11 +19,29 @@
 #ifndef  KSEQPP_SEQIO_HPP__
 #define  KSEQPP_SEQIO_HPP__
 
+#include <cerrno>
+#include <stdexcept>
 #include <zlib.h>
 
 #include "kseq++.hpp"
+#include "paired.hpp"
+#include "sharded.hpp"
+
+#if KSEQPP_HAS_UNISTD
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
 
 namespace klibpp {
+  template< >
+    struct KFileOffset< gzFile > {
+        static inline long long int
+      of( gzFile const& f )
+      {
+        return gzoffset( f );  // compressed bytes read so far
+      }
+    };
+
   class SeqStreamIn
     : public KStreamIn< gzFile, int(*)(gzFile_s*, void*, unsigned int) > {
     public:
@@ -32,15 +50,150 @@ namespace klibpp {
       /* Lifecycle */
       SeqStreamIn( const char* filename )
         : base_type( gzopen( filename, "r" ), gzread, gzclose )
-      { }
+      {
+#if KSEQPP_HAS_UNISTD
+        struct stat st;
+        if ( ::stat( filename, &st ) == 0 && S_ISREG( st.st_mode ) ) this->set_total( st.st_size );
+#endif
+      }
 
       SeqStreamIn( int fd )
         : base_type( gzdopen( fd, "r" ), gzread, gzclose )
-      { }
+      {
+#if KSEQPP_HAS_UNISTD
+        struct stat st;
+        if ( ::fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) ) this->set_total( st.st_size );
+#endif
+      }
+  };
+
+#if KSEQPP_HAS_UNISTD
+  /**
+   *  @brief  Copy the bytes written to a pipe into a file while checksumming them.
+   *
+   *  A thread drains the pipe; so the bytes written by a library to a file
+   *  descriptor (e.g. compressed by zlib) are checksummed on their way to the
+   *  file without reading the file back.
+   */
+  class KChecksumTee_ {
+    public:
+      /* Consts */
+      constexpr static std::size_t BUFSIZE = 131072;
+      /* Lifecycle */
+      KChecksumTee_( const char* filename, unsigned int algorithms )
+        : in( -1 ), src( -1 ), sum( algorithms ), failed( false )
+      {
+        this->out = ::open( filename, O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+        int fds[ 2 ];
+        if ( this->out < 0 || ::pipe( fds ) != 0 ) {
+          if ( this->out >= 0 ) ::close( this->out );
+          this->out = -1;
+          this->failed = true;
+          return;
+        }
+        this->src = fds[ 0 ];
+        this->in = fds[ 1 ];
+        this->worker = std::thread( [this](){ this->run(); } );
+      }
+
+      KChecksumTee_( KChecksumTee_ const& ) = delete;
+      KChecksumTee_& operator=( KChecksumTee_ const& ) = delete;
+
+      ~KChecksumTee_( ) noexcept
+      {
+        this->finish();
+      }
+      /* Accessors */
+      /**
+       *  @brief  The write end of the pipe; it should be closed by its new owner.
+       */
+        inline int
+      input( ) const
+      {
+        return this->in;
+      }
+
+        inline KChecksum
+      checksums( ) const
+      {
+        std::unique_lock< std::mutex > lock( this->lock );
+        return this->sum;
+      }
+      /* Methods */
+      /**
+       *  @brief  Wait for the pipe to be drained; the write end should be closed.
+       *
+       *  @return `false` if the file could not be written.
+       */
+        inline bool
+      finish( )
+      {
+        if ( this->worker.joinable() ) this->worker.join();
+        return !this->failed;
+      }
+    private:
+      /* Data members */
+      int in;                      /**< @brief write end of the pipe */
+      int src;                     /**< @brief read end of the pipe */
+      int out;                     /**< @brief output file */
+      KChecksum sum;               /**< @brief checksums of the bytes passed through */
+      bool failed;                 /**< @brief writing the file failed */
+      mutable std::mutex lock;     /**< @brief checksums mutex */
+      std::thread worker;          /**< @brief draining thread */
+      /* Methods */
+        inline void
+      run( ) noexcept
+      {
+        std::vector< char > buf( BUFSIZE );
+        while ( true ) {
+          ssize_t n = ::read( this->src, buf.data(), buf.size() );
+          if ( n < 0 && errno == EINTR ) continue;
+          if ( n <= 0 ) {
+            if ( n < 0 ) this->failed = true;
+            break;
+          }
+          {
+            std::unique_lock< std::mutex > lock( this->lock );
+            this->sum.update( buf.data(), n );
+          }
+          // keep draining on failure; otherwise the writer blocks forever
+          for ( ssize_t done = 0; done < n && !this->failed; ) {
+            ssize_t w = ::write( this->out, buf.data() + done, n - done );
+            if ( w < 0 && errno == EINTR ) continue;
+            if ( w < 0 ) this->failed = true;
+            else done += w;
+          }
+        }
+        ::close( this->src );
+        if ( ::close( this->out ) != 0 ) this->failed = true;
+      }
   };
 
+  struct KChecksumTeeHolder_ {
+    KChecksumTeeHolder_( KChecksumTee_* tee_=nullptr ) : tee( tee_ ), fp( nullptr ) { }
+
+    KChecksumTeeHolder_( KChecksumTeeHolder_&& other ) noexcept
+      : tee( std::move( other.tee ) ), fp( other.fp )
+    {
+      other.fp = nullptr;
+    }
+
+    ~KChecksumTeeHolder_( ) noexcept
+    {
+      // the stream was not constructed; close the pipe or the tee never finishes
+      if ( this->fp != nullptr ) gzclose( this->fp );
+    }
+
+    std::unique_ptr< KChecksumTee_ > tee;  /**< @brief file checksummer of compressed output (if any) */
+    gzFile fp;                             /**< @brief file writing to the tee until the stream owns it */
+  };
+#else
+  struct KChecksumTeeHolder_ { };  // no checksums of compressed files without pipes
+#endif
+
   class SeqStreamOut
-    : public KStreamOut< gzFile, int(*)(gzFile_s*, const void*, unsigned int) > {
+    : private KChecksumTeeHolder_,
+      public KStreamOut< gzFile, int(*)(gzFile_s*, const void*, unsigned int) > {
     public:
       /* Typedefs */
       typedef KStreamOut< gzFile, int(*)(gzFile_s*, const void*, unsigned int) > base_type;
@@ -62,6 +215,117 @@ namespace klibpp {
       SeqStreamOut( int fd, format::Format fmt )
         : base_type( gzdopen( fd, "wT" ), gzwrite, fmt, gzclose )
       { }
+
+      /**
+       *  @brief  Write to an open file which is closed by the stream.
+       */
+      SeqStreamOut( gzFile fp, format::Format fmt=base_type::DEFAULT_FORMAT )
+        : base_type( fp, gzwrite, fmt, gzclose )
+      { }
+
+#if KSEQPP_HAS_UNISTD
+      /**
+       *  @brief  Compute the given checksums of the output and the file as it is written.
+       *
+       *  Both are computed by the writer threads; the compressed bytes are
+       *  checksummed by a thread moving them from zlib to the file (see
+       *  `KChecksumTee_`).
+       */
+      SeqStreamOut( const char* filename, bool compressed, unsigned int checksums,
+                    format::Format fmt=base_type::DEFAULT_FORMAT )
+        : KChecksumTeeHolder_( compressed ? new KChecksumTee_( filename, checksums ) : nullptr ),
+          base_type( SeqStreamOut::open_file( filename, *this ), gzwrite, fmt, gzclose )
+      {
+        this->fp = nullptr;  // closed by the stream from now on
+        this->set_checksums( checksums );
+      }
+#endif
+
+      SeqStreamOut( SeqStreamOut&& ) = default;
+
+      SeqStreamOut& operator=( SeqStreamOut&& other ) noexcept
+      {
+        // the file should be closed before its tee is waited for
+        base_type::operator=( std::move( other ) );
+#if KSEQPP_HAS_UNISTD
+        this->tee = std::move( other.tee );
+#endif
+        return *this;
+      }
+      /* Accessors */
+      /**
+       *  @brief  Checksums of the bytes written to the file (compressed or not).
+       *
+       *  They are complete after `finish`.
+       */
+        inline KChecksum
+      file_checksums( ) const
+      {
+#if KSEQPP_HAS_UNISTD
+        if ( this->tee != nullptr ) return this->tee->checksums();
+#endif
+        return this->checksums();
+      }
+      /* Methods */
+        inline bool
+      finish( )
+      {
+        bool ok = base_type::finish();
+#if KSEQPP_HAS_UNISTD
+        if ( this->tee != nullptr ) ok = this->tee->finish() && ok;
+#endif
+        return ok;
+      }
+#if KSEQPP_HAS_UNISTD
+    private:
+      /* Methods */
+      /**
+       *  @brief  Open the file (or the tee) which is held until the stream is constructed.
+       */
+        static inline gzFile
+      open_file( const char* filename, KChecksumTeeHolder_& holder )
+      {
+        KChecksumTee_* tee = holder.tee.get();
+        if ( tee == nullptr ) return gzopen( filename, "wT" );
+        if ( tee->input() < 0 ) return nullptr;
+        holder.fp = gzdopen( tee->input(), "w" );
+        if ( holder.fp == nullptr ) ::close( tee->input() );  // let the tee finish
+        return holder.fp;
+      }
+#endif
+  };
+
+  class PairedSeqStreamIn
+    : public KPairedStreamIn< SeqStreamIn > {
+    public:
+      /* Typedefs */
+      typedef KPairedStreamIn< SeqStreamIn > base_type;
+      /* Lifecycle */
+      PairedSeqStreamIn( const char* filename1, const char* filename2, bool check=true )
+        : base_type( SeqStreamIn( filename1 ), SeqStreamIn( filename2 ), check )
+      { }
+
+      PairedSeqStreamIn( const char* filename, bool check=true )  // interleaved
+        : base_type( SeqStreamIn( filename ), check )
+      { }
+  };
+
+  class ShardedSeqStreamOut
+    : public KShardedStreamOut< SeqStreamOut > {
+    public:
+      /* Typedefs */
+      typedef KShardedStreamOut< SeqStreamOut > base_type;
+      /* Lifecycle */
+      ShardedSeqStreamOut( std::string pattern, shard::Policy policy, unsigned long int n,
+                           bool compressed=false,
+                           format::Format fmt=format::mix )
+        : base_type( std::move( pattern ), policy, n,
+            [compressed, fmt]( std::string const& name ) -> SeqStreamOut* {
+              gzFile fp = gzopen( name.c_str(), ( compressed ? "w" : "wT" ) );
+              if ( fp == nullptr ) return nullptr;
+              return new SeqStreamOut( fp, fmt );
+            } )
+      { }
   };
 }  /* -----  end of namespace klibpp  ----- */
 #endif  /* ----- #ifndef KSEQPP_SEQIO_HPP__  ----- */
@@ -0,0 +1,292 @@
+/**
+ *    @file  sharded.hpp
+ *   @brief  Sharded output stream.
+ *
+ *  This header file defines `KShardedStreamOut` class which splits one logical
+ *  output stream into several files (shards).
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  09:46
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_SHARDED_HPP__
+#define  KSEQPP_SHARDED_HPP__
+
+#include <cctype>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  namespace shard {
+    /**
+     *  @brief  Sharding policy.
+     *
+     *  - `records`: rotate to a new shard after every N records.
+     *  - `bytes`: rotate to a new shard after N (uncompressed) bytes; records are
+     *    never split, so a shard can be slightly larger.
+     *  - `roundrobin`: distribute records over N shards which are kept open.
+     */
+    enum Policy { records, bytes, roundrobin };
+  }  /* -----  end of namespace shard  ----- */
+
+  /**
+   *  @brief  Output stream splitting the records into several files.
+   *
+   *  The name of each shard is generated by the given pattern which should
+   *  contain exactly one `printf`-like `%d` conversion with an optional width
+   *  (e.g. "out.%03d.fq.gz") replaced by the shard index starting from zero; a
+   *  literal '%' is written as "%%". Shards are opened by the given opener
+   *  function which returns `nullptr` if the shard cannot be opened.
+   *
+   *  Each shard is an output `KStream` with its own writer thread; so open shards
+   *  are compressed in parallel. In rotating policies, a filled shard is flushed
+   *  and closed by a background thread while the next one is being written; a
+   *  failure in closing it fails the stream at the next rotation or `finish`.
+   */
+  template< typename TStream >
+    class KShardedStreamOut {
+      public:
+        /* Typedefs */
+        using stream_type = TStream;
+        using opener_type = std::function< stream_type*( std::string const& ) >;
+        /* Lifecycle */
+        KShardedStreamOut( std::string pattern_, shard::Policy policy_,
+            unsigned long int n_, opener_type open_ )
+          : pattern( std::move( pattern_ ) ), conv_pos( 0 ), conv_len( 0 ), width( 0 ),
+          zero_pad( false ), policy( policy_ ), n( n_ ), open( std::move( open_ ) ),
+          closed( true ), counter( 0 ), shard_counter( 0 ), has_failed( false )
+        {
+          if ( this->n == 0 ) throw std::invalid_argument( "shard size should be positive" );
+          this->parse_pattern();
+          unsigned long int nshards = ( this->policy == shard::roundrobin ) ? this->n : 1;
+          for ( unsigned long int i = 0; i < nshards; ++i ) this->add_shard();
+        }
+
+        KShardedStreamOut( KShardedStreamOut const& ) = delete;
+        KShardedStreamOut& operator=( KShardedStreamOut const& ) = delete;
+
+        ~KShardedStreamOut( ) noexcept
+        {
+          this->finish();
+        }
+        /* Accessors */
+          inline unsigned long int
+        counts( ) const
+        {
+          return this->counter;
+        }
+
+        /**
+         *  @brief  Names of the shards opened so far.
+         */
+          inline std::vector< std::string > const&
+        files( ) const
+        {
+          return this->names;
+        }
+        /* Methods */
+          inline bool
+        fail( ) const
+        {
+          if ( this->has_failed ) return true;
+          for ( auto const& s : this->shards ) if ( s->fail() ) return true;
+          return false;
+        }
+
+        operator bool( ) const
+        {
+          return !this->fail();
+        }
+
+        /**
+         *  @brief  Flush and close all shards.
+         *
+         *  Nothing can be written afterwards.
+         *
+         *  @return `false` if writing or closing any shard failed.
+         */
+          inline bool
+        finish( )
+        {
+          for ( auto& s : this->shards ) {
+            if ( !s->finish() ) this->has_failed = true;
+          }
+          this->shards.clear();
+          this->join_closer();
+          return !this->has_failed;
+        }
+
+          inline KShardedStreamOut&
+        operator<<( const KSeq& rec )
+        {
+          stream_type* out = this->next();
+          if ( out == nullptr ) {
+            this->has_failed = true;
+            return *this;
+          }
+          *out << rec;
+          if ( *out ) ++this->counter;
+          else this->has_failed = true;
+          return *this;
+        }
+
+          inline KShardedStreamOut&
+        operator<<( format::Format fmt_ )
+        {
+          for ( auto& s : this->shards ) *s << fmt_;
+          return *this;
+        }
+
+          inline KShardedStreamOut&
+        operator<<( KEnd_ )
+        {
+          for ( auto& s : this->shards ) *s << kend;
+          return *this;
+        }
+      private:
+        /* Data members */
+        std::string pattern;                                /**< @brief shard file name pattern */
+        std::string::size_type conv_pos;                    /**< @brief position of the conversion in the pattern */
+        std::string::size_type conv_len;                    /**< @brief length of the conversion */
+        std::string::size_type width;                       /**< @brief minimum width of the shard index */
+        bool zero_pad;                                      /**< @brief pad the shard index by zeros */
+        shard::Policy policy;                               /**< @brief sharding policy */
+        unsigned long int n;                                /**< @brief policy parameter */
+        opener_type open;                                   /**< @brief shard opener */
+        std::vector< std::unique_ptr< stream_type > > shards;  /**< @brief open shards */
+        std::vector< std::string > names;                   /**< @brief shard file names */
+        std::thread closer;                                 /**< @brief background closing thread */
+        bool closed;                                        /**< @brief last shard closed by `closer` successfully */
+        unsigned long int counter;                          /**< @brief number of records written so far */
+        unsigned long int shard_counter;                    /**< @brief number of records in the current shard */
+        bool has_failed;                                    /**< @brief error flag */
+        /* Methods */
+        /**
+         *  @brief  Locate the only `%[0-9]*d` conversion in the pattern.
+         *
+         *  @throw  std::invalid_argument if there is not exactly one such conversion
+         *          or there is any other conversion.
+         */
+          inline void
+        parse_pattern( )
+        {
+          bool found = false;
+          for ( std::string::size_type i = 0; i < this->pattern.size(); ++i ) {
+            if ( this->pattern[ i ] != '%' ) continue;
+            if ( i + 1 < this->pattern.size() && this->pattern[ i + 1 ] == '%' ) {
+              ++i;
+              continue;
+            }
+            std::string::size_type j = i + 1;
+            while ( j < this->pattern.size() && std::isdigit( static_cast< unsigned char >( this->pattern[ j ] ) ) ) ++j;
+            if ( found || j == this->pattern.size() || this->pattern[ j ] != 'd' ) {
+              throw std::invalid_argument( "shard name pattern should have exactly one '%d' conversion" );
+            }
+            found = true;
+            this->conv_pos = i;
+            this->conv_len = j + 1 - i;
+            this->zero_pad = ( j > i + 1 && this->pattern[ i + 1 ] == '0' );
+            this->width = ( j > i + 1 ) ? std::stoul( this->pattern.substr( i + 1, j - i - 1 ) ) : 0;
+            i = j;
+          }
+          if ( !found ) {
+            throw std::invalid_argument( "shard name pattern should have exactly one '%d' conversion" );
+          }
+        }
+
+        /**
+         *  @brief  Unescape a part of the pattern without conversion.
+         */
+          inline static void
+        append_literal( std::string& name, std::string const& part )
+        {
+          for ( std::string::size_type i = 0; i < part.size(); ++i ) {
+            name += part[ i ];
+            if ( part[ i ] == '%' ) ++i;  // "%%"
+          }
+        }
+
+          inline std::string
+        shard_name( std::size_t idx ) const
+        {
+          std::string num = std::to_string( idx );
+          if ( num.size() < this->width ) {
+            num.insert( 0, this->width - num.size(), this->zero_pad ? '0' : ' ' );
+          }
+          std::string name;
+          append_literal( name, this->pattern.substr( 0, this->conv_pos ) );
+          name += num;
+          append_literal( name, this->pattern.substr( this->conv_pos + this->conv_len ) );
+          return name;
+        }
+
+          inline void
+        add_shard( )
+        {
+          std::string name = this->shard_name( this->names.size() );
+          std::unique_ptr< stream_type > s( this->open( name ) );
+          if ( !s ) throw std::runtime_error( "cannot open shard '" + name + "'" );
+          this->shards.push_back( std::move( s ) );
+          this->names.push_back( std::move( name ) );
+          this->shard_counter = 0;
+        }
+
+          inline void
+        rotate( )
+        {
+          stream_type* old = this->shards.back().release();
+          auto fmt = old->get_format();
+          this->shards.pop_back();
+          // flush and close the filled shard while writing the next one
+          this->join_closer();
+          this->closer = std::thread( [this, old](){
+                this->closed = old->finish();
+                delete old;
+              } );
+          try {
+            this->add_shard();
+            *this->shards.back() << fmt;
+          }
+          catch ( ... ) {
+            this->has_failed = true;
+          }
+        }
+
+          inline void
+        join_closer( )
+        {
+          if ( !this->closer.joinable() ) return;
+          this->closer.join();
+          if ( !this->closed ) this->has_failed = true;
+        }
+
+          inline stream_type*
+        next( )
+        {
+          if ( this->has_failed || this->shards.empty() ) return nullptr;
+          switch ( this->policy ) {
+            case shard::records:
+              if ( this->shard_counter == this->n ) this->rotate();
+              break;
+            case shard::bytes:
+              if ( this->shard_counter != 0 && this->shards.back()->bytes() >= this->n ) this->rotate();
+              break;
+            case shard::roundrobin:
+              return this->shards[ this->counter % this->shards.size() ].get();
+          }
+          if ( this->has_failed ) return nullptr;
+          ++this->shard_counter;
+          return this->shards.back().get();
+        }
+    };
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_SHARDED_HPP__  ----- */
@@ -0,0 +1,230 @@
+/**
+ *    @file  shared.hpp
+ *   @brief  Multi-consumer input stream.
+ *
+ *  This header file defines `KSharedStreamIn` class which lets several worker
+ *  threads read batches of records from one input stream concurrently.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:34
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_SHARED_HPP__
+#define  KSEQPP_SHARED_HPP__
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kseq++.hpp"
+
+namespace klibpp {
+  /* In-memory input of a chunk */
+  struct KChunkSource_ {
+    const char* data;
+    std::string::size_type size;
+    std::string::size_type pos;
+  };
+
+    inline int
+  read_chunk_( KChunkSource_* src, char* buf, unsigned int size )
+  {
+    std::string::size_type n = std::min< std::string::size_type >( size, src->size - src->pos );
+    std::memcpy( buf, src->data + src->pos, n );
+    src->pos += n;
+    return static_cast< int >( n );
+  }
+
+  /**
+   *  @brief  Input stream shared by several consumer threads.
+   *
+   *  A splitter thread reads the input and cuts it into chunks of `batchsize`
+   *  whole records: it only scans the record boundaries and copies the raw bytes
+   *  (see `KStreamIn::read_raw`). Worker threads call `next_batch` concurrently;
+   *  each one takes a chunk and parses it into its own batch, so parsing and
+   *  allocation are done in parallel and the workers contend only on handing out
+   *  the chunks. At most `depth` chunks are read ahead.
+   *
+   *  Batches are numbered in the input order (see `Batch::index`); e.g. to write
+   *  the results in order by `KOrderedStreamOut`.
+   */
+  template< typename TStream >
+    class KSharedStreamIn {
+      public:
+        /* Typedefs */
+        using stream_type = TStream;
+        using size_type = std::vector< KSeq >::size_type;
+        using parser_type = KStreamIn< KChunkSource_*, int(*)( KChunkSource_*, char*, unsigned int ) >;
+        /* Consts */
+        constexpr static size_type DEFAULT_BATCHSIZE = 1024;
+        constexpr static size_type DEFAULT_DEPTH = 8;
+        constexpr static unsigned int CHUNK_BUFSIZE = 65536;  /**< @brief buffer size of the chunk parsers */
+        /* Nested classes */
+        /**
+         *  @brief  Batch of records owned by a worker; it should be reused.
+         */
+        struct Batch {
+          std::vector< KSeq > records;  /**< @brief record buffer */
+          size_type size = 0;           /**< @brief number of valid records */
+          std::uint64_t index = 0;      /**< @brief batch number in the input order */
+          std::string chunk;            /**< @brief raw bytes of the records */
+        };
+        /* Lifecycle */
+        explicit KSharedStreamIn( stream_type&& ks_, size_type bs_=DEFAULT_BATCHSIZE,
+            size_type depth_=DEFAULT_DEPTH )
+          : ks( std::move( ks_ ) ), batchsize( std::max< size_type >( bs_, 1 ) ), nbatches( 0 ),
+          done( false ), stop( false )
+        {
+          this->free.resize( std::max< size_type >( depth_, 1 ) );
+          this->splitter = std::thread( [this](){ this->split(); } );
+        }
+
+        KSharedStreamIn( KSharedStreamIn const& ) = delete;
+        KSharedStreamIn& operator=( KSharedStreamIn const& ) = delete;
+
+        ~KSharedStreamIn( ) noexcept
+        {
+          {
+            std::unique_lock< std::mutex > lock( this->lock );
+            this->stop = true;
+          }
+          this->cv.notify_all();
+          if ( this->splitter.joinable() ) this->splitter.join();
+        }
+        /* Accessors */
+        /**
+         *  @brief  Whether the whole input has been split into chunks.
+         */
+          inline bool
+        finished( ) const
+        {
+          std::unique_lock< std::mutex > lock( this->lock );
+          return this->done;
+        }
+
+        /**
+         *  @brief  The underlying stream.
+         *
+         *  NOTE: It should not be accessed until the reader is `finished`.
+         */
+          inline stream_type const&
+        stream( ) const
+        {
+          return this->ks;
+        }
+
+          inline bool
+        err( ) const
+        {
+          return this->finished() && this->ks.err();
+        }
+
+          inline bool
+        tqs( ) const
+        {
+          return this->finished() && this->ks.tqs();
+        }
+        /* Mutators */
+        /**
+         *  @brief  Pin the splitter thread (reading and decompressing) to the given CPUs.
+         *
+         *  @return `false` if the thread could not be pinned (see `KAffinity`).
+         */
+          inline bool
+        set_affinity( KAffinity const& aff )
+        {
+          return aff.apply( this->splitter );
+        }
+        /* Methods */
+        /**
+         *  @brief  Parse the next chunk into the given batch (thread-safe).
+         *
+         *  @return `false` if there is no more record; otherwise `true`.
+         */
+          inline bool
+        next_batch( Batch& batch )
+        {
+          {
+            std::unique_lock< std::mutex > lock( this->lock );
+            this->cv.wait( lock, [this]{ return !this->full.empty() || this->done; } );
+            if ( this->full.empty() ) {
+              batch.size = 0;
+              return false;
+            }
+            batch.chunk.swap( this->full.front().bytes );
+            batch.index = this->full.front().index;
+            this->free.push_back( std::move( this->full.front() ) );  // recycle the old chunk
+            this->full.pop_front();
+          }
+          this->cv.notify_all();
+          KChunkSource_ src = { batch.chunk.data(), batch.chunk.size(), 0 };
+          parser_type parser( &src, read_chunk_, mode::in, CHUNK_BUFSIZE );
+          batch.size = 0;
+          while ( true ) {
+            if ( batch.records.size() <= batch.size ) batch.records.resize( batch.size + 1 );
+            if ( !( parser >> batch.records[ batch.size ] ) ) break;
+            ++batch.size;
+          }
+          return true;
+        }
+      private:
+        /* Nested classes */
+        struct Chunk_ {
+          std::string bytes;        /**< @brief raw bytes of the records */
+          std::uint64_t index = 0;  /**< @brief chunk number */
+        };
+        /* Data members */
+        stream_type ks;               /**< @brief input stream */
+        size_type batchsize;          /**< @brief number of records in each chunk */
+        std::uint64_t nbatches;       /**< @brief number of chunks produced so far */
+        std::deque< Chunk_ > free;    /**< @brief chunks to be filled */
+        std::deque< Chunk_ > full;    /**< @brief filled chunks */
+        bool done;                    /**< @brief no more chunks will be produced */
+        bool stop;                    /**< @brief thread terminate flag */
+        mutable std::mutex lock;      /**< @brief queues mutex */
+        std::condition_variable cv;   /**< @brief consumers/producer condition variable */
+        std::thread splitter;         /**< @brief splitter thread */
+        /* Methods */
+          inline void
+        split( ) noexcept
+        {
+          Chunk_ chunk;
+          bool last = false;
+          while ( !last ) {
+            {
+              std::unique_lock< std::mutex > lock( this->lock );
+              this->cv.wait( lock, [this]{ return !this->free.empty() || this->stop; } );
+              if ( this->stop ) break;
+              chunk = std::move( this->free.front() );
+              this->free.pop_front();
+            }
+            chunk.bytes.clear();
+            auto n = this->ks.read_raw( chunk.bytes, this->batchsize );
+            last = ( n < this->batchsize );
+            {
+              std::unique_lock< std::mutex > lock( this->lock );
+              if ( n != 0 ) {
+                chunk.index = this->nbatches++;
+                this->full.push_back( std::move( chunk ) );
+              }
+              else this->free.push_back( std::move( chunk ) );
+              if ( last ) this->done = true;
+            }
+            this->cv.notify_all();
+          }
+        }
+    };
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_SHARED_HPP__  ----- */
@@ -0,0 +1,345 @@
+/**
+ *    @file  sort.hpp
+ *   @brief  External-memory sort of sequence records.
+ *
+ *  This header file defines `sort_records` which sorts the records of an input
+ *  stream by name, sequence or minimizer into an output stream using a bounded
+ *  amount of memory: sorted runs are spilled to temporary files and merged.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:27
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_SORT_HPP__
+#define  KSEQPP_SORT_HPP__
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+#include "seqio.hpp"
+#include "kmer.hpp"
+
+namespace klibpp {
+  namespace sorting {
+    /**
+     *  @brief  Sort order.
+     *
+     *  - `name`: lexicographic order of the names (e.g. to pair mates).
+     *  - `seq`: lexicographic order of the sequences.
+     *  - `minimizer`: the smallest k-mer hash of the sequences; similar reads end
+     *    up next to each other, which improves the compression ratio.
+     */
+    enum Order { name, seq, minimizer };
+  }  /* -----  end of namespace sorting  ----- */
+
+  /**
+   *  @brief  Options of the external sort.
+   */
+  struct KSortOptions {
+    /* Consts */
+    constexpr static std::size_t DEFAULT_MEMORY = 1UL << 30;  /**< @brief 1 GiB */
+    /* Data members */
+    sorting::Order order = sorting::name;   /**< @brief sort order */
+    std::size_t memory = DEFAULT_MEMORY;    /**< @brief memory budget of the records in bytes */
+    unsigned int threads = 1;               /**< @brief number of runs sorted in parallel */
+    std::string tmpdir = "/tmp";            /**< @brief directory of the temporary run files */
+    unsigned int k = 21;                    /**< @brief k-mer length of `sorting::minimizer` order */
+    int level = 1;                          /**< @brief compression level of the run files (0: none) */
+    unsigned int fanin = 64;                /**< @brief maximum number of runs merged at once */
+  };
+
+  /* Internal classes */
+  class KSortRun_ {
+    public:
+      /* Typedefs */
+      using size_type = std::vector< KSeq >::size_type;
+      using out_type = KStreamOut< gzFile, int(*)(gzFile_s*, const void*, unsigned int) >;
+      using reader_type = KBatchReader_< SeqStreamIn >;
+      /* Consts */
+      constexpr static size_type MERGE_BATCHSIZE = 256;  /**< @brief records read ahead at once from a run */
+      /* Nested classes */
+      struct Entry {
+        std::uint64_t key;  /**< @brief minimizer key (if sorted by minimizer) */
+        KSeq rec;           /**< @brief the record */
+      };
+      /* Lifecycle */
+      KSortRun_( KSortOptions const& opts_ ) : opts( opts_ ) { }
+      /* Methods */
+        inline bool
+      less( Entry const& a, Entry const& b ) const
+      {
+        switch ( this->opts.order ) {
+          case sorting::name:
+            return a.rec.name < b.rec.name;
+          case sorting::seq:
+            return a.rec.seq < b.rec.seq;
+          case sorting::minimizer:
+            if ( a.key != b.key ) return a.key < b.key;
+            return a.rec.seq < b.rec.seq;
+        }
+        return false;
+      }
+
+        inline void
+      set_key( Entry& e ) const
+      {
+        if ( this->opts.order != sorting::minimizer ) return;
+        std::uint64_t min = std::numeric_limits< std::uint64_t >::max();
+        auto kmers = make_kmer_sink( this->opts.k, [&min]( std::uint64_t km, std::string::size_type ) {
+              min = std::min( min, kmer::hash( km ) );
+            } );
+        kmers.append( e.rec.seq.data(), e.rec.seq.size() );
+        e.key = min;
+      }
+
+      /**
+       *  @brief  Sort the entries and write them to a new temporary file.
+       *
+       *  @return `false` on an I/O error.
+       */
+        inline bool
+      spill( std::vector< Entry >& entries, std::string const& filename ) const
+      {
+        this->sort( entries );
+        std::unique_ptr< out_type > out( this->open_run( filename ) );
+        if ( out == nullptr ) return false;
+        for ( auto const& e : entries ) *out << e.rec;
+        std::vector< Entry >().swap( entries );  // release the memory
+        return out->finish();
+      }
+
+      /**
+       *  @brief  Open a temporary run file for writing.
+       *
+       *  @return `nullptr` if the file cannot be opened.
+       */
+        inline out_type*
+      open_run( std::string const& filename ) const
+      {
+        std::string mode = "w" + std::to_string( this->opts.level );
+        if ( this->opts.level == 0 ) mode = "wT";
+        gzFile fp = gzopen( filename.c_str(), mode.c_str() );
+        if ( fp == nullptr ) return nullptr;
+        out_type* out = new out_type( fp, gzwrite, format::mix, gzclose );
+        out->set_nowrapping();
+        return out;
+      }
+
+      /**
+       *  @brief  Merge the given sorted runs into the output stream by a k-way merge.
+       *
+       *  Each run is read ahead in its own thread. Records with equal keys are
+       *  written in the order of the runs; so merging consecutive runs is stable.
+       *
+       *  @throw  std::runtime_error if a run cannot be read or the output fails.
+       *
+       *  @return the number of written records.
+       */
+      template< typename TOutStream >
+          inline unsigned long int
+        merge( std::string const* first, std::string const* last, TOutStream& out ) const
+        {
+          struct Cursor {
+            std::unique_ptr< reader_type > reader;
+            reader_type::Batch batch;
+            reader_type::size_type idx;
+            Entry current;
+          };
+          std::vector< Cursor > cursors( last - first );
+          auto advance = [this]( Cursor& c ) {
+            if ( c.idx >= c.batch.size ) {
+              if ( !c.reader->next( c.batch ) ) return false;
+              c.idx = 0;
+            }
+            std::swap( c.current.rec, c.batch.records[ c.idx++ ] );
+            this->set_key( c.current );
+            return true;
+          };
+          auto greater = [this, &cursors]( std::size_t a, std::size_t b ) {
+            if ( this->less( cursors[ b ].current, cursors[ a ].current ) ) return true;
+            if ( this->less( cursors[ a ].current, cursors[ b ].current ) ) return false;
+            return a > b;  // earlier runs first: stable
+          };
+          std::priority_queue< std::size_t, std::vector< std::size_t >, decltype( greater ) > heap( greater );
+          for ( std::size_t i = 0; i < cursors.size(); ++i ) {
+            cursors[ i ].reader.reset( new reader_type( SeqStreamIn( first[ i ].c_str() ),
+                                                        MERGE_BATCHSIZE ) );
+            cursors[ i ].batch.size = 0;
+            cursors[ i ].idx = 0;
+            if ( advance( cursors[ i ] ) ) heap.push( i );
+          }
+          unsigned long int count = 0;
+          while ( !heap.empty() ) {
+            std::size_t i = heap.top();
+            heap.pop();
+            out << cursors[ i ].current.rec;
+            if ( !out ) throw std::runtime_error( "cannot write the sorted records" );
+            ++count;
+            if ( advance( cursors[ i ] ) ) heap.push( i );
+          }
+          for ( auto const& c : cursors ) {
+            if ( c.reader->stream().err() ) {
+              throw std::runtime_error( "cannot read a temporary run file" );
+            }
+          }
+          return count;
+        }
+
+        inline void
+      sort( std::vector< Entry >& entries ) const
+      {
+        std::stable_sort( entries.begin(), entries.end(),
+            [this]( Entry const& a, Entry const& b ) { return this->less( a, b ); } );
+      }
+    private:
+      KSortOptions const& opts;
+  };
+
+  /**
+   *  @brief  Sort the remaining records of the input stream into the output stream.
+   *
+   *  Records are read into memory up to the memory budget (divided among the
+   *  runs in flight); each full run is sorted and spilled to a compressed
+   *  temporary file by a separate thread while the next run is being read. The
+   *  runs are then merged by a k-way merge where each run is read ahead in its
+   *  own thread. If all records fit in one run, nothing is spilled. The sort is
+   *  stable: records with equal keys keep their input order.
+   *
+   *  At most `fanin` runs are merged at once, fewer if their read-ahead batches
+   *  would exceed the memory budget; more runs are first merged in groups of
+   *  consecutive runs into larger ones, in as many passes as needed. So the
+   *  number of threads and open files of the merge is bounded too.
+   *
+   *  An `std::runtime_error` is thrown if a temporary file cannot be written or
+   *  read, or writing to the output stream fails. The state of the input stream
+   *  should be checked afterwards as usual.
+   *
+   *  @return the number of written records.
+   */
+  template< typename TInStream, typename TOutStream >
+      inline unsigned long int
+    sort_records( TInStream& in, TOutStream& out, KSortOptions const& opts=KSortOptions() )
+    {
+      using run_type = KSortRun_;
+      using entry_type = run_type::Entry;
+      constexpr static std::size_t ENTRY_OVERHEAD = sizeof( entry_type );
+
+      run_type run( opts );
+      unsigned int threads = std::max( opts.threads, 1u );
+      std::size_t budget = std::max< std::size_t >( opts.memory / ( threads + 1 ), 1 );
+
+      // remove temporary files on exit
+      struct Files {
+        std::vector< std::string > names;
+        ~Files( ) { for ( auto const& n : names ) std::remove( n.c_str() ); }
+      } files;
+      auto make_file = [&opts, &files]( ) {
+        std::string tmpl = opts.tmpdir + "/kseqpp-run-XXXXXX";
+        int fd = ::mkstemp( &tmpl[ 0 ] );
+        if ( fd == -1 ) {
+          throw std::runtime_error( "cannot create a temporary file in '" + opts.tmpdir + "'" );
+        }
+        ::close( fd );
+        files.names.push_back( tmpl );
+        return tmpl;
+      };
+      std::deque< char > results;  // whether each spilled run is written successfully
+      std::vector< std::string > runs;
+      // join the spilling threads on exit (before their results and files are released)
+      struct Workers {
+        std::deque< std::thread > list;
+        void join( ) { for ( auto& w : list ) if ( w.joinable() ) w.join(); }
+        ~Workers( ) { this->join(); }
+      } workers;
+
+      std::vector< entry_type > entries;
+      std::size_t nbytes = 0;      // total size of the records read
+      unsigned long int nrecs = 0;  // total number of records read
+      bool more = true;
+      while ( more ) {
+        std::size_t used = 0;
+        entries.clear();
+        while ( used < budget ) {
+          entries.emplace_back();
+          if ( !( in >> entries.back().rec ) ) {
+            entries.pop_back();
+            more = false;
+            break;
+          }
+          run.set_key( entries.back() );
+          KSeq const& r = entries.back().rec;
+          used += ENTRY_OVERHEAD + r.name.size() + r.comment.size() + r.seq.size() + r.qual.size();
+        }
+        nbytes += used;
+        nrecs += entries.size();
+        if ( !more && runs.empty() ) {  // fits in memory
+          run.sort( entries );
+          for ( auto const& e : entries ) out << e.rec;
+          out << kend;
+          if ( !out ) throw std::runtime_error( "cannot write the sorted records" );
+          return entries.size();
+        }
+        if ( entries.empty() ) break;
+        // spill the run by a worker thread
+        std::string tmpl = make_file();
+        runs.push_back( tmpl );
+        results.push_back( 0 );
+        if ( workers.list.size() == threads ) {
+          workers.list.front().join();
+          workers.list.pop_front();
+        }
+        char* result = &results.back();
+        workers.list.emplace_back( [&run, result, tmpl]( std::vector< entry_type > run_entries ) {
+              *result = run.spill( run_entries, tmpl );
+            }, std::move( entries ) );
+        entries = std::vector< entry_type >();
+      }
+      workers.join();
+      for ( char ok : results ) {
+        if ( !ok ) throw std::runtime_error( "cannot write a temporary run file" );
+      }
+
+      // each merged run holds up to `DEPTH + 1` batches of records in memory
+      std::size_t batch = ( run_type::reader_type::DEPTH + 1 ) * run_type::MERGE_BATCHSIZE *
+          ( nbytes / std::max< unsigned long int >( nrecs, 1 ) + 1 );
+      std::size_t fanin = std::min< std::size_t >( opts.fanin, opts.memory / batch );
+      fanin = std::max< std::size_t >( fanin, 2 );
+      while ( runs.size() > fanin ) {
+        std::vector< std::string > merged;
+        for ( std::size_t i = 0; i < runs.size(); i += fanin ) {
+          std::size_t end = std::min( i + fanin, runs.size() );
+          if ( end - i == 1 ) {
+            merged.push_back( runs[ i ] );
+            continue;
+          }
+          std::string name = make_file();
+          std::unique_ptr< run_type::out_type > rout( run.open_run( name ) );
+          if ( rout == nullptr ) throw std::runtime_error( "cannot write a temporary run file" );
+          run.merge( &runs[ i ], &runs[ 0 ] + end, *rout );
+          if ( !rout->finish() ) throw std::runtime_error( "cannot write a temporary run file" );
+          for ( std::size_t j = i; j < end; ++j ) std::remove( runs[ j ].c_str() );
+          merged.push_back( name );
+        }
+        runs.swap( merged );
+      }
+      unsigned long int count = run.merge( &runs[ 0 ], &runs[ 0 ] + runs.size(), out );
+      out << kend;
+      if ( !out ) throw std::runtime_error( "cannot write the sorted records" );
+      return count;
+    }
+}  /* -----  end of namespace klibpp  ----- */
+#endif  /* ----- #ifndef KSEQPP_SORT_HPP__  ----- */
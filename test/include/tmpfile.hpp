@@ -0,0 +1,83 @@
+/**
+ *    @file  tmpfile.hpp
+ *   @brief  Temporary files for the test cases.
+ *
+ *  Helper functions creating temporary files and directories in `TMPDIR` (or
+ *  `/tmp` if it is not set) shared by the test cases.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  11:13
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#ifndef  KSEQPP_TEST_TMPFILE_HPP__
+#define  KSEQPP_TEST_TMPFILE_HPP__
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#define DEFAULT_TMPDIR "/tmp"
+#define TMPFILE_TEMPLATE "/kseqpp-XXXXXX"
+
+
+  inline std::string
+get_env( const std::string& var )
+{
+  const char* val = ::getenv( var.c_str() );
+  if ( val == 0 ) {
+    return "";
+  }
+  else {
+    return val;
+  }
+}
+
+  inline std::string
+get_tmpdir_env( )
+{
+  return get_env( "TMPDIR" );
+}
+
+  inline std::string
+get_tmpdir( )
+{
+  std::string tmpdir = get_tmpdir_env();
+  if ( tmpdir.size() == 0 ) tmpdir = DEFAULT_TMPDIR;
+  return tmpdir;
+}
+
+/* Create an empty temporary file and return its path. */
+  inline std::string
+get_tmpfile( )
+{
+  std::string tmpfile_templ = get_tmpdir() + TMPFILE_TEMPLATE;
+  char* tmpl = new char [ tmpfile_templ.size() + 1 ];
+  std::strcpy( tmpl, tmpfile_templ.c_str() );
+  int fd = mkstemp( tmpl );
+  tmpfile_templ = tmpl;
+
+  ::close( fd );
+  delete[] tmpl;
+  return tmpfile_templ;
+}
+
+/* Create an empty temporary directory and return its path. */
+  inline std::string
+get_tmpsubdir( )
+{
+  std::string tmpdir_templ = get_tmpdir() + TMPFILE_TEMPLATE;
+  char* tmpl = new char [ tmpdir_templ.size() + 1 ];
+  std::strcpy( tmpl, tmpdir_templ.c_str() );
+  tmpdir_templ = mkdtemp( tmpl );
+  delete[] tmpl;
+  return tmpdir_templ;
+}
+
+#endif  /* ----- #ifndef KSEQPP_TEST_TMPFILE_HPP__  ----- */
@@ -0,0 +1,201 @@
+/**
+ *    @file  async_test.cpp
+ *   @brief  Test for async.hpp header file
+ *
+ *  Test cases for `async.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  09:51
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <kseq++/async.hpp>
+#include <kseq++/seqio.hpp>
+
+#define NOF_STREAMS 4
+#define WRITE_CHUNK 5
+
+
+using namespace klibpp;
+
+/**
+ *  @brief  Minimal poll-based event loop resuming coroutines waiting on pipes.
+ */
+class Reactor {
+  public:
+      inline void
+    wait( int fd, std::coroutine_handle<> h )
+    {
+      this->waiting.push_back( { fd, h } );
+    }
+
+      inline bool
+    run_once( )
+    {
+      if ( this->waiting.empty() ) return false;
+      std::vector< pollfd > fds;
+      for ( auto const& w : this->waiting ) fds.push_back( { w.first, POLLIN, 0 } );
+      ::poll( fds.data(), fds.size(), -1 );
+      std::vector< std::coroutine_handle<> > ready;
+      std::vector< std::pair< int, std::coroutine_handle<> > > rest;
+      for ( std::size_t i = 0; i < fds.size(); ++i ) {
+        if ( fds[ i ].revents != 0 ) ready.push_back( this->waiting[ i ].second );
+        else rest.push_back( this->waiting[ i ] );
+      }
+      this->waiting.swap( rest );
+      for ( auto h : ready ) h.resume();
+      return true;
+    }
+  private:
+    std::vector< std::pair< int, std::coroutine_handle<> > > waiting;
+};
+
+/**
+ *  @brief  Asynchronous byte source reading from a non-blocking pipe.
+ */
+class PipeSource {
+  public:
+    struct Awaiter {
+      PipeSource& src;
+      char* buf;
+      std::size_t size;
+      long int res;
+
+        inline bool
+      await_ready( )
+      {
+        this->res = ::read( this->src.fd, this->buf, this->size );
+        return !( this->res < 0 && errno == EAGAIN );
+      }
+
+        inline void
+      await_suspend( std::coroutine_handle<> h )
+      {
+        ++this->src.suspended;
+        this->src.reactor.wait( this->src.fd, h );
+      }
+
+        inline long int
+      await_resume( )
+      {
+        if ( this->res < 0 && errno == EAGAIN ) this->res = ::read( this->src.fd, this->buf, this->size );
+        return this->res;
+      }
+    };
+
+    PipeSource( int fd_, Reactor& reactor_ ) : fd( fd_ ), reactor( reactor_ ), suspended( 0 )
+    {
+      ::fcntl( this->fd, F_SETFL, ::fcntl( this->fd, F_GETFL ) | O_NONBLOCK );
+    }
+
+      inline Awaiter
+    read( char* buf, std::size_t size )
+    {
+      return { *this, buf, size, 0 };
+    }
+
+    int fd;
+    Reactor& reactor;
+    unsigned int suspended;
+};
+
+  void
+slow_writer( int fd, std::string const& content )
+{
+  for ( std::size_t i = 0; i < content.size(); i += WRITE_CHUNK ) {
+    auto len = std::min< std::size_t >( WRITE_CHUNK, content.size() - i );
+    if ( ::write( fd, content.data() + i, len ) != static_cast< ssize_t >( len ) ) break;
+    std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+  }
+  ::close( fd );
+}
+
+  KTask< std::vector< KSeq > >
+consume( KAsyncStreamIn< PipeSource >& ks )
+{
+  std::vector< KSeq > ret;
+  KSeq record;
+  while ( co_await ks.next( record ) ) ret.push_back( record );
+  co_return ret;
+}
+
+  KTask< std::vector< KSeq > >
+consume_batches( KAsyncStreamIn< PipeSource >& ks )
+{
+  std::vector< KSeq > ret;
+  std::vector< KSeq > batch;
+  while ( co_await ks.read( batch, 2 ) ) ret.insert( ret.end(), batch.begin(), batch.end() );
+  co_return ret;
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ifstream ifs( argv[1] );
+  std::stringstream content;
+  content << ifs.rdbuf();
+  std::vector< KSeq > expected = SeqStreamIn( argv[1] ).read();
+
+  std::cout << "Verifying " << NOF_STREAMS << " concurrent streams on one thread..." << std::endl;
+  Reactor reactor;
+  std::vector< std::thread > writers;
+  std::vector< std::unique_ptr< PipeSource > > sources;
+  std::vector< std::unique_ptr< KAsyncStreamIn< PipeSource > > > streams;
+  std::vector< KTask< std::vector< KSeq > > > tasks;
+  std::vector< int > wfds;
+  for ( int i = 0; i < NOF_STREAMS; ++i ) {
+    int fds[ 2 ];
+    if ( ::pipe( fds ) != 0 ) return EXIT_FAILURE;
+    wfds.push_back( fds[ 1 ] );
+    sources.emplace_back( new PipeSource( fds[ 0 ], reactor ) );
+    streams.emplace_back( new KAsyncStreamIn< PipeSource >( *sources.back(), 8 ) );
+    if ( i % 2 ) tasks.push_back( consume( *streams.back() ) );
+    else tasks.push_back( consume_batches( *streams.back() ) );
+    tasks.back().resume();
+  }
+  // the writers start after all the streams are suspended on the empty pipes
+  for ( int fd : wfds ) writers.emplace_back( slow_writer, fd, content.str() );
+  while ( reactor.run_once() );
+  for ( int i = 0; i < NOF_STREAMS; ++i ) {
+    assert( tasks[ i ].done() );
+    auto records = tasks[ i ].get();
+    assert( records.size() == expected.size() );
+    for ( std::size_t j = 0; j < records.size(); ++j ) {
+      assert( records[ j ].name == expected[ j ].name );
+      assert( records[ j ].comment == expected[ j ].comment );
+      assert( records[ j ].seq == expected[ j ].seq );
+      assert( records[ j ].qual == expected[ j ].qual );
+    }
+    assert( streams[ i ]->counts() == expected.size() );
+    assert( !streams[ i ]->err() && !streams[ i ]->tqs() );
+    assert( sources[ i ]->suspended > 0 );
+    ::close( sources[ i ]->fd );
+  }
+  for ( auto& w : writers ) w.join();
+  std::cout << "PASSED" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/**
+ *    @file  cache_test.cpp
+ *   @brief  Test for cache.hpp header file
+ *
+ *  Test cases for `cache.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:29
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <kseq++/seqio.hpp>
+#include <kseq++/cache.hpp>
+#include "tmpfile.hpp"
+
+
+using namespace klibpp;
+
+  inline bool
+equal( KSeq const& a, KSeq const& b )
+{
+  return a.name == b.name && a.comment == b.comment && a.seq == b.seq && a.qual == b.qual;
+}
+
+  inline void
+check( std::vector< KSeq > const& records, bool packed, KCacheWriter::size_type blocksize )
+{
+  std::string filename = get_tmpfile();
+  {
+    KCacheWriter writer( filename.c_str(), packed, blocksize );
+    for ( auto const& r : records ) writer << r;
+    assert( writer.counts() == records.size() );
+  }
+  KCacheReader reader( filename.c_str() );
+  assert( reader.size() == records.size() );
+  KCacheRecord view;
+  for ( std::size_t i = 0; i < records.size(); ++i ) {
+    assert( reader.next( view ) );
+    assert( std::string( view.name, view.name_len ) == records[ i ].name );
+    assert( std::string( view.seq, view.seq_len ) == records[ i ].seq );
+    assert( std::string( view.qual, view.qual_len ) == records[ i ].qual );
+  }
+  assert( !reader.next( view ) && reader.eof() );
+  // random access
+  KSeq rec;
+  for ( std::size_t idx : { std::size_t( 0 ), records.size() / 2, records.size() - 1, records.size() / 3 } ) {
+    reader.seek( idx );
+    assert( reader.tell() == idx );
+    assert( reader >> rec );
+    assert( equal( rec, records[ idx ] ) );
+  }
+  reader.seek( records.size() );
+  assert( !( reader >> rec ) );
+  ::unlink( filename.c_str() );
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector< KSeq > records = SeqStreamIn( argv[1] ).read();
+  std::mt19937 rng( 11 );
+  for ( int i = 0; i < 300; ++i ) {
+    records.emplace_back();
+    records.back().name = "r" + std::to_string( i );
+    if ( i % 3 == 0 ) records.back().comment = "length=" + std::to_string( i );
+    std::size_t len = rng() % 90;
+    // the sequences of the second half are ACGT only
+    for ( std::size_t j = 0; j < len; ++j ) records.back().seq += ( i < 150 ? "ACGTN" : "ACGT" )[ rng() % ( i < 150 ? 5 : 4 ) ];
+    if ( i % 2 ) records.back().qual = std::string( len, 'F' );
+  }
+
+  std::cout << "Verifying cache round trip..." << std::endl;
+  check( records, false, KCacheWriter::DEFAULT_BLOCKSIZE );
+  check( records, true, KCacheWriter::DEFAULT_BLOCKSIZE );
+  check( records, true, 7 );
+  check( records, false, 1 );
+  {
+    // conversion through the existing streams
+    std::string cached = get_tmpfile();
+    std::string output = get_tmpfile();
+    {
+      SeqStreamIn iss( argv[1] );
+      KCacheWriter writer( cached.c_str() );
+      to_cache( iss, writer );
+    }
+    {
+      KCacheReader reader( cached.c_str() );
+      SeqStreamOut oss( output.c_str() );
+      assert( from_cache( reader, oss ) == reader.size() );
+    }
+    auto expected = SeqStreamIn( argv[1] ).read();
+    auto converted = SeqStreamIn( output.c_str() ).read();
+    assert( expected.size() == converted.size() );
+    for ( std::size_t i = 0; i < expected.size(); ++i ) assert( equal( expected[ i ], converted[ i ] ) );
+    ::unlink( cached.c_str() );
+    ::unlink( output.c_str() );
+  }
+  {
+    // an empty cache
+    std::string cached = get_tmpfile();
+    { KCacheWriter writer( cached.c_str() ); }
+    KCacheReader reader( cached.c_str() );
+    KSeq rec;
+    assert( reader.size() == 0 && !( reader >> rec ) );
+    ::unlink( cached.c_str() );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying invalid cache files..." << std::endl;
+  {
+    std::string filename = get_tmpfile();
+    {
+      KCacheWriter writer( filename.c_str() );
+      for ( auto const& r : records ) writer << r;
+    }
+    std::FILE* fp = std::fopen( filename.c_str(), "r+b" );
+    std::fseek( fp, 20, SEEK_SET );
+    std::fputc( 0x7f, fp );  // corrupt the header
+    std::fclose( fp );
+    bool thrown = false;
+    try {
+      KCacheReader reader( filename.c_str() );
+    }
+    catch ( std::runtime_error const& ) {
+      thrown = true;
+    }
+    assert( thrown );
+    thrown = false;
+    try {
+      KCacheReader reader( argv[1] );  // a text file
+    }
+    catch ( std::runtime_error const& ) {
+      thrown = true;
+    }
+    assert( thrown );
+    ::unlink( filename.c_str() );
+  }
+  {
+    std::string filename = get_tmpfile();
+    {
+      KCacheWriter writer( filename.c_str() );
+      for ( auto const& r : records ) writer << r;
+    }
+    std::FILE* fp = std::fopen( filename.c_str(), "r+b" );
+    std::fseek( fp, sizeof( cache::Header ) + sizeof( cache::Block ) + 2, SEEK_SET );
+    std::fputc( 0x7f, fp );  // corrupt the length of the first name
+    std::fclose( fp );
+    KCacheReader reader( filename.c_str() );
+    KSeq rec;
+    assert( !( reader >> rec ) && reader.eof() );
+    ::unlink( filename.c_str() );
+  }
+  {
+    // a corrupted block after the first one
+    std::string filename = get_tmpfile();
+    {
+      KCacheWriter writer( filename.c_str(), false, 1 );
+      for ( std::size_t i = 0; i < 3; ++i ) writer << records[ i ];
+    }
+    std::FILE* fp = std::fopen( filename.c_str(), "r+b" );
+    cache::Header header;
+    cache::IndexEntry entry;
+    assert( std::fread( &header, sizeof( header ), 1, fp ) == 1 );
+    std::fseek( fp, header.index + sizeof( entry ), SEEK_SET );
+    assert( std::fread( &entry, sizeof( entry ), 1, fp ) == 1 );
+    std::uint64_t size = 1000;
+    std::fseek( fp, entry.offset + offsetof( cache::Block, sizes ), SEEK_SET );
+    std::fwrite( &size, sizeof( size ), 1, fp );  // corrupt the name column size of block 1
+    std::fclose( fp );
+    KCacheReader reader( filename.c_str() );
+    KSeq rec;
+    assert( ( reader >> rec ) && equal( rec, records[ 0 ] ) );
+    assert( !( reader >> rec ) && reader.eof() && reader.tell() == reader.size() );
+    reader.seek( 1 );
+    assert( !reader && reader.eof() );
+    reader.seek( 2 );  // the block after it is intact
+    assert( reader && ( reader >> rec ) && equal( rec, records[ 2 ] ) );
+    reader.seek( 0 );
+    assert( reader && ( reader >> rec ) && equal( rec, records[ 0 ] ) );
+    ::unlink( filename.c_str() );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  return EXIT_SUCCESS;
+}
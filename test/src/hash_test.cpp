@@ -0,0 +1,151 @@
+/**
+ *    @file  hash_test.cpp
+ *   @brief  Test for hash.hpp header file
+ *
+ *  Test cases for `hash.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:24
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include <kseq++/seqio.hpp>
+#include <kseq++/hash.hpp>
+#include "tmpfile.hpp"
+
+
+using namespace klibpp;
+
+/* Names of the records returned by `read_unique`. */
+  inline std::vector< std::string >
+unique_names( std::string const& filename, KDedup& seen )
+{
+  SeqStreamIn iss( filename.c_str() );
+  std::vector< std::string > names;
+  KSeq rec;
+  while ( read_unique( iss, rec, seen ) ) names.push_back( rec.name );
+  assert( iss.eof() && !iss.err() && iss.is_hashing() );
+  return names;
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // each record is written three times with different names; every third record is new
+  std::vector< KSeq > records = SeqStreamIn( argv[1] ).read();
+  for ( int i = 0; i < 32; ++i ) {
+    records.emplace_back();
+    records.back().name = "s";
+    for ( int j = 0; j < 40; ++j ) records.back().seq += "ACGT"[ ( i * 7 + j * j + ( i >> j % 5 ) ) % 4 ];
+    records.back().qual = std::string( 40, 'I' );
+  }
+  std::vector< std::string > expected;
+  std::set< std::string > seqs;
+  std::string file1 = get_tmpfile();
+  std::string file2 = get_tmpfile();
+  {
+    SeqStreamOut oss1( file1.c_str() );
+    SeqStreamOut oss2( file2.c_str() );
+    for ( int round = 0; round < 3; ++round ) {
+      for ( std::size_t i = 0; i < records.size(); ++i ) {
+        KSeq rec = records[ i ];
+        rec.name = std::to_string( round ) + "_" + std::to_string( i );
+        if ( seqs.insert( rec.seq ).second ) expected.push_back( rec.name );
+        oss1 << rec;
+        KSeq mate = records[ ( i + round ) % records.size() ];  // the second mates vary
+        mate.name = rec.name;
+        oss2 << mate;
+      }
+    }
+  }
+
+  std::cout << "Verifying exact duplicate detection..." << std::endl;
+  {
+    KDedup seen( 1 << 16 );
+    assert( unique_names( file1, seen ) == expected );
+    assert( seen.size() == expected.size() && !seen.saturated() );
+  }
+  {
+    // a table of 8 slots remembers only 6 hashes; duplicates of the others pass
+    KDedup seen( 64 );
+    auto names = unique_names( file1, seen );
+    assert( seen.saturated() && seen.size() == 6 );
+    assert( seen.missed() > 0 && names.size() >= expected.size() );
+    for ( std::size_t i = 0; i < expected.size(); ++i ) {
+      assert( std::find( names.begin(), names.end(), expected[ i ] ) != names.end() );
+    }
+  }
+  bool thrown = false;
+  try {
+    KDedup seen( 4 );
+  }
+  catch ( std::invalid_argument const& ) {
+    thrown = true;
+  }
+  assert( thrown );
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying Bloom filter duplicate detection..." << std::endl;
+  {
+    KDedup seen( 1 << 16, dedup::bloom );
+    assert( unique_names( file1, seen ) == expected );
+    assert( seen.size() == expected.size() );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying paired duplicate detection..." << std::endl;
+  {
+    SeqStreamIn iss1( file1.c_str() );
+    SeqStreamIn iss2( file2.c_str() );
+    iss1.set_hashing();
+    iss2.set_hashing();
+    KPairedStreamIn< SeqStreamIn > piss( std::move( iss1 ), std::move( iss2 ), false );
+    KDedup seen( 1 << 16 );
+    std::set< std::pair< std::string, std::string > > pairs;
+    KSeqPair pair;
+    std::size_t n = 0;
+    while ( read_unique( piss, pair, seen ) ) {
+      assert( pairs.insert( std::make_pair( pair.first.seq, pair.second.seq ) ).second );
+      ++n;
+    }
+    assert( n == pairs.size() && n > expected.size() && piss.counts() == 3 * records.size() );
+  }
+  {
+    KPairedStreamIn< SeqStreamIn > piss( SeqStreamIn( file1.c_str() ), SeqStreamIn( file2.c_str() ) );
+    KDedup seen( 1 << 16 );
+    KSeqPair pair;
+    thrown = false;
+    try {
+      read_unique( piss, pair, seen );
+    }
+    catch ( std::invalid_argument const& ) {
+      thrown = true;
+    }
+    assert( thrown );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  ::unlink( file1.c_str() );
+  ::unlink( file2.c_str() );
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/**
+ *    @file  header_test.cpp
+ *   @brief  Test for header.hpp header file
+ *
+ *  Test cases for `header.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:36
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <kseq++/header.hpp>
+
+
+using namespace klibpp;
+
+/* Parse a FASTA/Q text from memory through a buffer of the given size. */
+struct MemSource {
+  std::string text;
+  std::size_t pos;
+};
+
+  inline long int
+mem_read( MemSource* src, char* buf, long int size )
+{
+  long int n = std::min( static_cast< std::size_t >( size ), src->text.size() - src->pos );
+  std::memcpy( buf, src->text.data() + src->pos, n );
+  src->pos += n;
+  return n;
+}
+
+  inline void
+check_illumina( KHeader const& hdr )
+{
+  assert( hdr.layout() == header::illumina );
+  assert( hdr.instrument() == "A00123" );
+  assert( hdr.run().to_ulong() == 45 );
+  assert( hdr.flowcell() == "HABCDEFXX" );
+  assert( hdr.lane().to_ulong() == 2 );
+  assert( hdr.tile().to_ulong() == 1101 );
+  assert( hdr.x().to_ulong() == 10004 );
+  assert( hdr.y().to_ulong() == 1000 );
+  assert( hdr.umi() == "ACGTACGT" );
+  assert( hdr.read().to_ulong() == 1 );
+  assert( hdr.filter() == "Y" && hdr.is_filtered() );
+  assert( hdr.control() == "0" );
+  assert( hdr.index() == "ATCACG+GCTAGC" );
+  assert( hdr.zmw().empty() && hdr.value( "ch" ).empty() );
+}
+
+  inline void
+check_ont( KHeader const& hdr )
+{
+  assert( hdr.layout() == header::ont );
+  assert( hdr.ntokens() == 5 );
+  assert( hdr.token( 1 ) == "read=280" );
+  assert( hdr.value( "runid" ) == "f53ee40429765e7817081d4bcdee6c1199c2f91d" );
+  assert( hdr.value( "read" ).to_ulong() == 280 );
+  assert( hdr.value( "ch" ).to_ulong() == 212 );
+  assert( hdr.value( "start_time" ) == "2018-01-25T15:20:39Z" );
+  assert( hdr.value( "barcode" ) == "" );
+  assert( hdr.value( "start" ).empty() && hdr.value( "runi" ).empty() );
+  assert( hdr.instrument() == "0b3c2f1e-6a7f-4bba-8d0a-2f0e5c2d7a11" && hdr.run().empty() );
+}
+
+  inline void
+check_pacbio( KHeader const& hdr, bool ccs )
+{
+  assert( hdr.layout() == header::pacbio );
+  assert( hdr.movie() == "m64011_190830_220126" );
+  assert( hdr.zmw().to_ulong() == 12 );
+  assert( hdr.is_ccs() == ccs );
+  if ( ccs ) {
+    assert( hdr.range_start().empty() && hdr.range_end().empty() );
+  }
+  else {
+    assert( hdr.range_start().to_ulong() == 100 && hdr.range_end().to_ulong() == 2345 );
+  }
+  assert( hdr.ntokens() == 0 && hdr.read().empty() );
+}
+
+  int
+main( )
+{
+  MemSource src;
+  src.text =
+    "@A00123:45:HABCDEFXX:2:1101:10004:1000:ACGTACGT 1:Y:0:ATCACG+GCTAGC\nACGT\n+\nFFFF\n"
+    "@0b3c2f1e-6a7f-4bba-8d0a-2f0e5c2d7a11 runid=f53ee40429765e7817081d4bcdee6c1199c2f91d read=280 ch=212 "
+    "start_time=2018-01-25T15:20:39Z barcode=\nACGT\n+\nFFFF\n"
+    ">m64011_190830_220126/12/100_2345\nACGT\n"
+    ">m64011_190830_220126/12/ccs\nACGT\n"
+    ">plain\nACGT\n";
+
+  std::cout << "Verifying header fields..." << std::endl;
+  for ( unsigned int bufsize : { 1, 3, 16, 4096 } ) {
+    src.pos = 0;
+    auto ks = make_ikstream( &src, mem_read, bufsize );
+    KSeq rec;
+    KHeader hdr;
+    assert( read_header( ks, rec, hdr ) );
+    check_illumina( hdr );
+    assert( read_header( ks, rec, hdr ) );
+    check_ont( hdr );
+    assert( read_header( ks, rec, hdr ) );
+    check_pacbio( hdr, false );
+    assert( read_header( ks, rec, hdr ) );
+    check_pacbio( hdr, true );
+    assert( read_header( ks, rec, hdr ) );
+    assert( hdr.layout() == header::unknown && hdr.instrument() == "plain" && hdr.ntokens() == 0 );
+    assert( rec.seq == "ACGT" );
+    assert( !read_header( ks, rec, hdr ) );
+  }
+  {
+    // records parsed otherwise
+    src.pos = 0;
+    auto ks = make_ikstream( &src, mem_read );
+    KSeq rec;
+    KHeader hdr;
+    ks >> rec;
+    hdr.assign( rec );
+    check_illumina( hdr );
+    ks >> rec;
+    hdr.assign( rec );
+    check_ont( hdr );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  return EXIT_SUCCESS;
+}
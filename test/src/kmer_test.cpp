@@ -0,0 +1,181 @@
+/**
+ *    @file  kmer_test.cpp
+ *   @brief  Test for kmer.hpp header file
+ *
+ *  Test cases for `kmer.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:21
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <kseq++/kmer.hpp>
+
+
+using namespace klibpp;
+
+template< typename TKmer >
+  using Hits = std::vector< std::pair< TKmer, std::size_t > >;
+
+/* Canonical k-mers of the sequence computed independently of the sink. */
+template< typename TKmer >
+    inline Hits< TKmer >
+  naive_kmers( std::string const& seq, unsigned int k )
+  {
+    static const std::string acgt = "ACGT";
+    Hits< TKmer > hits;
+    for ( std::size_t i = 0; i + k <= seq.size(); ++i ) {
+      TKmer fwd = 0;
+      TKmer rev = 0;
+      bool valid = true;
+      for ( std::size_t j = 0; j < k && valid; ++j ) {
+        auto c = acgt.find( std::toupper( seq[ i + j ] ) == 'U' ? 'T' : std::toupper( seq[ i + j ] ) );
+        auto r = acgt.find( std::toupper( seq[ i + k - 1 - j ] ) == 'U' ? 'T' : std::toupper( seq[ i + k - 1 - j ] ) );
+        valid = ( c != std::string::npos && r != std::string::npos );
+        fwd = ( fwd << 2 ) | static_cast< TKmer >( c );
+        rev = ( rev << 2 ) | static_cast< TKmer >( 3 - r );
+      }
+      if ( valid ) hits.emplace_back( fwd < rev ? fwd : rev, i );
+    }
+    return hits;
+  }
+
+/* Leftmost minimum of each window of `w` consecutive k-mers, reported once. */
+template< typename TKmer >
+    inline Hits< TKmer >
+  naive_minimizers( std::string const& seq, unsigned int k, unsigned int w )
+  {
+    auto kmers = naive_kmers< TKmer >( seq, k );
+    Hits< TKmer > hits;
+    for ( std::size_t i = 0; i + w <= kmers.size(); ++i ) {
+      if ( kmers[ i + w - 1 ].second - kmers[ i ].second != w - 1 ) continue;  // not consecutive
+      std::size_t m = i;
+      for ( std::size_t j = i + 1; j < i + w; ++j ) {
+        if ( kmer::hash( kmers[ j ].first ) < kmer::hash( kmers[ m ].first ) ) m = j;
+      }
+      if ( hits.empty() || hits.back().second != kmers[ m ].second ) hits.push_back( kmers[ m ] );
+    }
+    return hits;
+  }
+
+  inline std::string
+random_seq( std::mt19937& rng, std::size_t len )
+{
+  static const char bases[] = "ACGTacgtNU";
+  std::string seq;
+  for ( std::size_t i = 0; i < len; ++i ) {
+    auto r = rng() % 100;
+    seq += bases[ r < 96 ? r % 8 : ( r < 98 ? 8 : 9 ) ];
+  }
+  return seq;
+}
+
+/* Parse a FASTA/Q text from memory through a buffer of the given size. */
+struct MemSource {
+  std::string text;
+  std::size_t pos;
+};
+
+  inline long int
+mem_read( MemSource* src, char* buf, long int size )
+{
+  long int n = std::min( static_cast< std::size_t >( size ), src->text.size() - src->pos );
+  std::memcpy( buf, src->text.data() + src->pos, n );
+  src->pos += n;
+  return n;
+}
+
+template< typename TKmer >
+    inline void
+  check( std::vector< std::string > const& seqs, unsigned int k, unsigned int w )
+  {
+    MemSource src;
+    for ( std::size_t i = 0; i < seqs.size(); ++i ) {
+      if ( i % 2 ) {  // FASTQ
+        src.text += "@r" + std::to_string( i ) + "\n" + seqs[ i ] + "\n+\n" +
+          std::string( seqs[ i ].size(), 'I' ) + "\n";
+      }
+      else {  // FASTA wrapped at 7 bases per line
+        src.text += ">r" + std::to_string( i ) + " comment\n";
+        for ( std::size_t j = 0; j < seqs[ i ].size(); j += 7 ) {
+          src.text += seqs[ i ].substr( j, 7 ) + "\r\n";
+        }
+      }
+    }
+    for ( unsigned int bufsize : { 1, 5, 64, 4096 } ) {
+      src.pos = 0;
+      auto ks = make_ikstream( &src, mem_read, bufsize );
+      Hits< TKmer > kmers;
+      Hits< TKmer > minimizers;
+      auto ksink = make_kmer_sink< std::function< void( TKmer, std::size_t ) >, TKmer >( k,
+          [&kmers]( TKmer km, std::size_t pos ) { kmers.emplace_back( km, pos ); } );
+      KMinimizerSink< std::function< void( TKmer, std::size_t ) >, TKmer > msink( k, w,
+          [&minimizers]( TKmer km, std::size_t pos ) { minimizers.emplace_back( km, pos ); } );
+      std::string name;
+      for ( std::size_t i = 0; i < seqs.size(); ++i ) {
+        kmers.clear();
+        assert( parse_kmers( ks, name, ksink ) );
+        assert( name == "r" + std::to_string( i ) );
+        assert( ksink.size() == seqs[ i ].size() );
+        assert( kmers == naive_kmers< TKmer >( seqs[ i ], k ) );
+      }
+      assert( !parse_kmers( ks, ksink ) );
+
+      src.pos = 0;
+      auto ks2 = make_ikstream( &src, mem_read, bufsize );
+      for ( std::size_t i = 0; i < seqs.size(); ++i ) {
+        minimizers.clear();
+        assert( parse_kmers( ks2, msink ) );
+        assert( minimizers == naive_minimizers< TKmer >( seqs[ i ], k, w ) );
+      }
+    }
+  }
+
+  int
+main( )
+{
+  std::mt19937 rng( 42 );
+  std::vector< std::string > seqs = { "", "ACGTN", "acgtacgtnnACGUTTTGCA" };
+  for ( int i = 0; i < 20; ++i ) seqs.push_back( random_seq( rng, rng() % 300 ) );
+
+  std::cout << "Verifying k-mers and minimizers (k <= 32)..." << std::endl;
+  check< std::uint64_t >( seqs, 1, 1 );
+  check< std::uint64_t >( seqs, 5, 4 );
+  check< std::uint64_t >( seqs, 15, 10 );
+  check< std::uint64_t >( seqs, 32, 5 );
+  std::cout << "PASSED" << std::endl;
+
+#ifdef __SIZEOF_INT128__
+  std::cout << "Verifying k-mers and minimizers (k <= 64)..." << std::endl;
+  check< kmer::uint128_t >( seqs, 33, 3 );
+  check< kmer::uint128_t >( seqs, 64, 7 );
+  std::cout << "PASSED" << std::endl;
+#endif
+
+  bool thrown = false;
+  try {
+    make_kmer_sink( 33, []( std::uint64_t, std::size_t ) { } );
+  }
+  catch ( std::invalid_argument const& ) {
+    thrown = true;
+  }
+  assert( thrown );
+
+  return EXIT_SUCCESS;
+}
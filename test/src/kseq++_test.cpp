@@ -16,65 +16,27 @@
  */
 
 #include <zlib.h>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <random>
+#include <cstdio>
 #include <fcntl.h>
 
 #include <kseq++/kseq++.hpp>
 #include "kseq.h"
+#include "tmpfile.hpp"
 
 #define SEQ_TRUNC_LEN 20
 #define MAX_SHOWN_REC 10
 #define SEQ_WRAPLEN 100
-#define DEFAULT_TMPDIR "/tmp"
-#define TMPFILE_TEMPLATE "/kseqpp-XXXXXX"
 
 
 using namespace klibpp;
 
 KSEQ_INIT(gzFile, gzread)
 
-  inline std::string
-get_env( const std::string& var )
-{
-  const char* val = ::getenv( var.c_str() );
-  if ( val == 0 ) {
-    return "";
-  }
-  else {
-    return val;
-  }
-}
-
-  inline std::string
-get_tmpdir_env( )
-{
-  return get_env( "TMPDIR" );
-}
-
-  inline std::string
-get_tmpdir( )
-{
-  std::string tmpdir = get_tmpdir_env();
-  if ( tmpdir.size() == 0 ) tmpdir = DEFAULT_TMPDIR;
-  return tmpdir;
-}
-
-  inline std::string
-get_tmpfile( )
-{
-  std::string tmpfile_templ = get_tmpdir() + TMPFILE_TEMPLATE;
-  char* tmpl = new char [ tmpfile_templ.size() + 1 ];
-  std::strcpy( tmpl, tmpfile_templ.c_str() );
-  int fd = mkstemp( tmpl );
-  tmpfile_templ = tmpl;
-
-  ::close( fd );
-  delete[] tmpl;
-  return tmpfile_templ;
-}
-
   void
 print_trunc( std::string prefix, const std::string& seq )
 {
@@ -113,6 +75,787 @@ check( const char* filename, size_t nrec, size_t tot, size_t min, size_t max )
   gzclose(fp);
 }
 
+  void
+check_fields( const char* filename, size_t nrec, size_t tot )
+{
+  gzFile fp = gzopen( filename, "r" );
+  auto iks = make_ikstream( fp, gzread );
+  iks.set_fields( field::seq );
+  KSeq record;
+  size_t count = 0;
+  size_t total_len = 0;
+  while ( iks >> record ) {
+    assert( record.name.empty() && record.comment.empty() && record.qual.empty() );
+    total_len += record.seq.size();
+    ++count;
+  }
+  assert( !iks.tqs() );
+  assert( count == nrec );
+  assert( total_len == tot );
+  gzclose( fp );
+}
+
+  void
+check_scan( const char* filename, size_t nrec, size_t tot, size_t min, size_t max )
+{
+  for ( bool readahead : { false, true } ) {
+    gzFile fp = gzopen( filename, "r" );
+    auto iks = make_ikstream( fp, gzread, 4 );
+    KStats stats = iks.scan( readahead );
+    assert( !iks.err() && !iks.tqs() );
+    assert( stats.count == nrec );
+    assert( stats.total == tot );
+    assert( stats.min_len == min );
+    assert( stats.max_len == max );
+    assert( stats.n50() >= min && stats.n50() <= max );
+    assert( stats.gc + stats.n <= tot );
+    gzclose( fp );
+  }
+  // The qualities of a truncated final record are not counted
+  std::string tmpfile = get_tmpfile();
+  {
+    std::string content = "@r1\nACGT\n+\nIIII\n@r2\nACGT\n+\n##\n";
+    int fd = open( tmpfile.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    assert( write( fd, content.c_str(), content.size() ) == static_cast< ssize_t >( content.size() ) );
+    close( fd );
+  }
+  {
+    gzFile fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks = make_ikstream( fp, gzread );
+    KStats stats = iks.scan( false );
+    assert( iks.tqs() );
+    assert( stats.count == 1 && stats.fastq == 1 );
+    assert( stats.quals[ 'I' ] == 4 && stats.quals[ '#' ] == 0 );
+    gzclose( fp );
+  }
+  std::remove( tmpfile.c_str() );
+}
+
+  void
+check_iterators( const char* filename, size_t nrec, size_t tot )
+{
+  {
+    gzFile fp = gzopen( filename, "r" );
+    auto iks = make_ikstream( fp, gzread );
+    size_t count = 0;
+    size_t total_len = 0;
+    for ( KSeq const& record : iks ) {
+      total_len += record.seq.size();
+      ++count;
+    }
+    assert( count == nrec );
+    assert( total_len == tot );
+    gzclose( fp );
+  }
+  {
+    gzFile fp = gzopen( filename, "r" );
+    auto iks = make_ikstream( fp, gzread );
+    auto nfastq = std::count_if( iks.begin(), iks.end(),
+                                 []( KSeq const& r ) { return !r.qual.empty(); } );
+    assert( nfastq <= static_cast< long int >( nrec ) );
+    gzclose( fp );
+  }
+  {
+    gzFile fp = gzopen( filename, "r" );
+    auto iks = make_ikstream( fp, gzread );
+    size_t count = 0;
+    size_t total_len = 0;
+    for ( auto const& batch : iks.records( 2 ) ) {
+      assert( !batch.empty() && batch.size() <= 2 );
+      for ( auto const& record : batch ) total_len += record.seq.size();
+      count += batch.size();
+    }
+    assert( count == nrec );
+    assert( total_len == tot );
+    gzclose( fp );
+  }
+}
+
+  std::vector< std::string >
+read_names( const char* filename, KFilter const& filter, field::Field fields=field::all )
+{
+  gzFile fp = gzopen( filename, "r" );
+  auto iks = make_ikstream( fp, gzread );
+  iks.set_fields( fields );
+  iks.set_filter( filter );
+  std::vector< std::string > names;
+  KSeq record;
+  while ( iks >> record ) names.push_back( record.name );
+  assert( !iks.tqs() );
+  assert( iks.counts() == names.size() );
+  gzclose( fp );
+  return names;
+}
+
+  void
+check_filter( const char* filename )
+{
+  std::vector< KSeq > records;
+  {
+    gzFile fp = gzopen( filename, "r" );
+    records = make_ikstream( fp, gzread ).read();
+    gzclose( fp );
+  }
+  KFilter filter;
+  assert( read_names( filename, filter ).size() == records.size() );
+  for ( auto const& record : records ) {
+    // each record passes its own length range and name prefix
+    filter = KFilter();
+    filter.min_len = filter.max_len = record.seq.size();
+    filter.prefix = record.name;
+    auto names = read_names( filename, filter );
+    assert( names.size() == 1 && names[ 0 ] == record.name );
+    names = read_names( filename, filter, field::seq );
+    assert( names.size() == 1 && names[ 0 ].empty() );
+  }
+  filter = KFilter();
+  filter.min_qual = 94;  // rejects any FASTQ record
+  auto names = read_names( filename, filter );
+  for ( auto const& record : records ) {
+    assert( std::count( names.begin(), names.end(), record.name ) == record.qual.empty() );
+  }
+  filter = KFilter();
+  filter.max_n = 0;
+  filter.prefix = "no such name";
+  assert( read_names( filename, filter ).empty() );
+}
+
+  void
+check_qualmap( const char* filename )
+{
+  auto bin = KQualMap::bin_illumina();
+  assert( bin[ '!' + 1 ] == '!' + 1 && bin[ '!' + 2 ] == '!' + 6 && bin[ '!' + 19 ] == '!' + 15 );
+  assert( bin[ '!' + 30 ] == '!' + 33 && bin[ '!' + 45 ] == '!' + 40 );
+  auto cap = KQualMap::cap( 38 );
+  assert( cap[ '!' + 37 ] == '!' + 37 && cap[ '!' + 41 ] == '!' + 38 );
+  auto to64 = KQualMap::shift( 33, 64 );
+  auto to33 = KQualMap::shift( 64, 33 );
+  assert( to64[ '!' ] == '@' && to33[ to64[ 'I' ] ] == 'I' );
+  auto map = to33.then( bin );
+  assert( map[ '@' + 12 ] == '!' + 15 );
+
+  std::vector< KSeq > records;
+  {
+    gzFile fp = gzopen( filename, "r" );
+    records = make_ikstream( fp, gzread ).read();
+    gzclose( fp );
+  }
+  // Writing Phred+64 qualities and reading them back as Phred+33
+  std::string tmpfile = get_tmpfile();
+  {
+    int fd = open( tmpfile.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    auto oks = make_okstream( fd, write );
+    oks.set_qualmap( to64 );
+    for ( auto const& record : records ) oks << record;
+    oks << kend;
+    close( fd );
+  }
+  {
+    gzFile fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks = make_ikstream( fp, gzread );
+    KSeq record;
+    std::size_t i = 0;
+    while ( iks >> record ) {
+      std::string qual = records[ i ].qual;
+      to64.apply( qual );
+      assert( record.qual == qual );
+      ++i;
+    }
+    assert( i == records.size() );
+    gzclose( fp );
+  }
+  {
+    gzFile fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks = make_ikstream( fp, gzread );
+    iks.set_qualmap( map );
+    KSeq record;
+    std::size_t i = 0;
+    while ( iks >> record ) {
+      std::string qual = records[ i ].qual;
+      bin.apply( qual );
+      assert( record.seq == records[ i ].seq && record.qual == qual );
+      ++i;
+    }
+    assert( i == records.size() );
+    gzclose( fp );
+  }
+  // Mean qualities are filtered as they are returned; i.e. after the map
+  double max_mean = 0;
+  std::size_t nfastq = 0;
+  for ( auto const& record : records ) {
+    if ( record.qual.empty() ) continue;
+    double sum = 0;
+    for ( char c : record.qual ) sum += c - KQualMap::PHRED33;
+    max_mean = std::max( max_mean, sum / record.qual.size() );
+    ++nfastq;
+  }
+  for ( double min_qual : { 0.0, max_mean + 1 } ) {
+    gzFile fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks = make_ikstream( fp, gzread );
+    iks.set_qualmap( to33 );
+    KFilter filter;
+    filter.min_qual = min_qual;
+    iks.set_filter( filter );
+    KSeq record;
+    std::size_t n = 0;
+    while ( iks >> record ) n += !record.qual.empty();
+    assert( n == ( min_qual == 0 ? nfastq : 0 ) );
+    gzclose( fp );
+  }
+  std::remove( tmpfile.c_str() );
+}
+
+  std::vector< std::string >
+sample_names( std::string const& filename, double fraction, std::uint64_t seed )
+{
+  gzFile fp = gzopen( filename.c_str(), "r" );
+  auto iks = make_ikstream( fp, gzread );
+  iks.set_sampling( fraction, seed );
+  std::vector< std::string > names;
+  for ( KSeq const& record : iks ) names.push_back( record.name );
+  assert( iks.counts() + iks.filtered() == 1000 || fraction == 0 );
+  gzclose( fp );
+  return names;
+}
+
+  void
+check_sampling( )
+{
+  std::string tmpfile = get_tmpfile();
+  {
+    int fd = open( tmpfile.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    auto oks = make_okstream( fd, write );
+    KSeq record;
+    for ( int i = 0; i < 1000; ++i ) {
+      record.name = std::to_string( 100000 + i );  // sorted as strings
+      record.seq = "ACGT";
+      record.qual = ( i % 2 ) ? "" : "IIII";
+      oks << record;
+    }
+    oks << kend;
+    close( fd );
+  }
+  auto names = sample_names( tmpfile, 0.1, 42 );
+  assert( names.size() > 50 && names.size() < 150 );
+  assert( std::is_sorted( names.begin(), names.end() ) );
+  assert( sample_names( tmpfile, 0.1, 42 ) == names );
+  assert( sample_names( tmpfile, 0.1, 43 ) != names );
+  assert( sample_names( tmpfile, 1, 42 ).size() == 1000 );
+  assert( sample_names( tmpfile, 0, 42 ).empty() );
+
+  for ( std::size_t k : { 0, 1, 10, 999, 1000, 2000 } ) {
+    gzFile fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks = make_ikstream( fp, gzread );
+    auto sample = iks.sample( k, 7 );
+    assert( sample.size() == std::min< std::size_t >( k, 1000 ) );
+    for ( std::size_t i = 1; i < sample.size(); ++i ) assert( sample[ i - 1 ].name < sample[ i ].name );
+    for ( auto const& record : sample ) assert( record.seq == "ACGT" );
+    assert( k == 0 || iks.counts() + iks.filtered() == 1000 );
+    gzclose( fp );
+  }
+  std::remove( tmpfile.c_str() );
+}
+
+template< typename T >
+  struct CountingAllocator {
+    using value_type = T;
+
+    explicit CountingAllocator( long int* live_ ) : live( live_ ) { }
+
+    template< typename U >
+      CountingAllocator( CountingAllocator< U > const& other ) : live( other.live ) { }
+
+      inline T*
+    allocate( std::size_t n )
+    {
+      *this->live += n;
+      return static_cast< T* >( ::operator new( n * sizeof( T ) ) );
+    }
+
+      inline void
+    deallocate( T* p, std::size_t n )
+    {
+      *this->live -= n;
+      ::operator delete( p );
+    }
+
+    long int* live;
+  };
+
+template< typename T, typename U >
+    inline bool
+  operator==( CountingAllocator< T > const& a, CountingAllocator< U > const& b )
+  {
+    return a.live == b.live;
+  }
+
+template< typename T, typename U >
+    inline bool
+  operator!=( CountingAllocator< T > const& a, CountingAllocator< U > const& b )
+  {
+    return !( a == b );
+  }
+
+  void
+check_allocator( const char* filename, size_t nrec, size_t tot )
+{
+  using alloc_type = CountingAllocator< char >;
+  using istream_type = KStreamIn< gzFile, int(*)( gzFile_s*, void*, unsigned int ), alloc_type >;
+  using ostream_type = KStreamOut< int, ssize_t(*)( int, const void*, size_t ), alloc_type >;
+  long int live = 0;
+  std::string tmpfile = get_tmpfile();
+  {
+    gzFile fp = gzopen( filename, "r" );
+    istream_type iks( fp, gzread, mode::in, 4096, nullptr, alloc_type( &live ) );
+    int fd = open( tmpfile.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    ostream_type oks( fd, write, mode::out, format::mix, 4096, nullptr, alloc_type( &live ) );
+    assert( live == 3 * 4096 );
+    KSeq record;
+    size_t count = 0;
+    size_t total_len = 0;
+    while ( iks >> record ) {
+      oks << record;
+      total_len += record.seq.size();
+      ++count;
+    }
+    assert( count == nrec );
+    assert( total_len == tot );
+    oks << kend;
+    gzclose( fp );
+    close( fd );
+  }
+  assert( live == 0 );
+#if KSEQPP_HAS_PMR
+  {
+    std::pmr::monotonic_buffer_resource arena;
+    gzFile fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks = make_ikstream( fp, gzread );
+    std::pmr::vector< pmr::KSeq > records( &arena );
+    assert( iks.read( records, nrec + 1 ) == nrec );
+    size_t total_len = 0;
+    for ( auto const& record : records ) {
+      assert( record.seq.get_allocator().resource() == &arena );
+      total_len += record.seq.size();
+    }
+    assert( total_len == tot );
+    gzclose( fp );
+  }
+  {
+    // Buffers are reallocated when moving to a stream of another memory resource
+    using pmr_alloc = std::pmr::polymorphic_allocator< char >;
+    using pmr_istream = KStreamIn< gzFile, int(*)( gzFile_s*, void*, unsigned int ), pmr_alloc >;
+    using pmr_ostream = KStreamOut< int, ssize_t(*)( int, const void*, size_t ), pmr_alloc >;
+    std::pmr::monotonic_buffer_resource arena1;
+    std::pmr::monotonic_buffer_resource arena2;
+    std::string copy = get_tmpfile();
+    int fd = open( copy.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    pmr_istream iks( gzopen( tmpfile.c_str(), "r" ), gzread, mode::in, 4096, gzclose, &arena1 );
+    pmr_istream other_iks( gzopen( tmpfile.c_str(), "r" ), gzread, mode::in, 4096, gzclose, &arena2 );
+    pmr_ostream oks( fd, write, mode::out, format::mix, 4096, nullptr, &arena1 );
+    pmr_ostream other_oks( -1, write, mode::out, format::mix, 4096, nullptr, &arena2 );
+    KSeq record;
+    size_t count = 0;
+    size_t total_len = 0;
+    while ( count < nrec / 2 && iks >> record ) {
+      oks << record;
+      total_len += record.seq.size();
+      ++count;
+    }
+    other_iks = std::move( iks );
+    other_oks = std::move( oks );
+    while ( other_iks >> record ) {
+      other_oks << record;
+      total_len += record.seq.size();
+      ++count;
+    }
+    assert( count == nrec && total_len == tot );
+    other_oks << kend;
+    close( fd );
+    gzFile fp = gzopen( copy.c_str(), "r" );
+    auto cks = make_ikstream( fp, gzread );
+    assert( cks.read().size() == nrec );
+    gzclose( fp );
+    std::remove( copy.c_str() );
+  }
+#endif
+  std::remove( tmpfile.c_str() );
+}
+
+template< typename TFormat >
+    std::vector< KSeq >
+  read_as( std::string const& filename, TFormat tag, unsigned int bufsize )
+  {
+    gzFile fp = gzopen( filename.c_str(), "r" );
+    auto iks = make_ikstream( fp, gzread, bufsize );
+    std::vector< KSeq > records;
+    KSeq record;
+    while ( iks.read( record, tag ) ) records.push_back( record );
+    assert( !iks.tqs() );
+    assert( iks.counts() == records.size() );
+    gzclose( fp );
+    return records;
+  }
+
+  void
+check_formats( )
+{
+  std::string fastq = get_tmpfile();
+  std::string fasta = get_tmpfile();
+  {
+    int fd = open( fastq.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    const char* text = "@r1 c1\nACGT\n+\nIIII\n@r2\r\n\r\n+r2\r\n\r\n@r3\tc 3\nA\n+\n#\n";
+    assert( write( fd, text, std::strlen( text ) ) == static_cast< ssize_t >( std::strlen( text ) ) );
+    close( fd );
+    fd = open( fasta.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    text = ">s1 @c\nAC\n@GT\n\n+A\n>s2\n>s3\nACGT";
+    assert( write( fd, text, std::strlen( text ) ) == static_cast< ssize_t >( std::strlen( text ) ) );
+    close( fd );
+  }
+  for ( unsigned int bufsize : { 1, 3, 8, 4096 } ) {
+    auto expected = read_as( fastq, format::Mix_(), bufsize );
+    auto records = read_as( fastq, format::fastq_strict, bufsize );
+    assert( records.size() == 3 && expected.size() == 3 );
+    for ( std::size_t i = 0; i < records.size(); ++i ) {
+      assert( records[ i ].name == expected[ i ].name );
+      assert( records[ i ].comment == expected[ i ].comment );
+      assert( records[ i ].seq == expected[ i ].seq );
+      assert( records[ i ].qual == expected[ i ].qual );
+    }
+    assert( records[ 2 ].comment == "c 3" && records[ 1 ].seq.empty() );
+
+    records = read_as( fasta, format::fasta_only, bufsize );
+    assert( records.size() == 3 );
+    assert( records[ 0 ].comment == "@c" && records[ 0 ].seq == "AC@GT+A" );
+    assert( records[ 1 ].name == "s2" && records[ 1 ].seq.empty() );
+    assert( records[ 2 ].seq == "ACGT" );
+  }
+  std::remove( fastq.c_str() );
+  std::remove( fasta.c_str() );
+}
+
+  void
+check_validation( const char* filename, size_t nrec )
+{
+  {
+    gzFile fp = gzopen( filename, "r" );
+    auto iks = make_ikstream( fp, gzread );
+    iks.set_validation();
+    auto records = iks.read();
+    assert( records.size() == nrec );
+    assert( !iks.invalid() && !iks.error().found );
+    gzclose( fp );
+  }
+  std::string tmpfile = get_tmpfile();
+  {
+    int fd = open( tmpfile.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    const char* text = ">r1\nACGTN-\nrykm\n@r2\nACGU\n+\nIIII\n@r3\nACGT\n+\nII I\n>r4\nAC\n";
+    assert( write( fd, text, std::strlen( text ) ) == static_cast< ssize_t >( std::strlen( text ) ) );
+    close( fd );
+  }
+  for ( unsigned int bufsize : { 1, 5, 4096 } ) {
+    gzFile fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks = make_ikstream( fp, gzread, bufsize );
+    iks.set_validation();
+    auto records = iks.read();
+    assert( records.size() == 2 );
+    assert( iks.invalid() && iks.fail() );
+    assert( iks.error().record == 2 && iks.error().offset == 45 && iks.error().byte == ' ' );
+    gzclose( fp );
+
+    fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks2 = make_ikstream( fp, gzread, bufsize );
+    KValidator validator;
+    validator.iupac = false;
+    validator.qual_min = ' ';
+    iks2.set_validation( validator );
+    assert( iks2.read().size() == 4 );
+    assert( !iks2.invalid() && iks2.tell() == std::strlen( ">r1\nACGTN-\nrykm\n@r2\nACGU\n+\nIIII\n@r3\nACGT\n+\nII I\n>r4\nAC\n" ) );
+    gzclose( fp );
+
+    fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks3 = make_ikstream( fp, gzread, bufsize );
+    validator = KValidator();
+    validator.qual_min = 'J';
+    iks3.set_validation( validator );
+    assert( iks3.read().size() == 1 );
+    assert( iks3.error().record == 1 && iks3.error().offset == 27 && iks3.error().byte == 'I' );
+    gzclose( fp );
+  }
+  std::remove( tmpfile.c_str() );
+}
+
+  void
+check_hashing( const char* filename, size_t nrec )
+{
+  assert( KHash64::of( "", 0 ) == 0xEF46DB3751D8E999ULL );
+  assert( KHash64::of( "a", 1 ) == 0xD24EC4F1A98C6E5BULL );
+  assert( KHash64::of( "abc", 3 ) == 0x44BC2CF5AD770999ULL );
+  assert( KHash64::of( "abc", 3, 1 ) == 0xBEA9CA8199328908ULL );
+  std::string acgt;
+  for ( int i = 0; i < 25; ++i ) acgt += "ACGT";
+  assert( KHash64::of( acgt.data(), acgt.size() ) == 0x06E3CFC703745B64ULL );
+  for ( std::size_t chunk : { 1, 3, 7, 31, 32, 33 } ) {
+    KHash64 h;
+    for ( std::size_t i = 0; i < acgt.size(); i += chunk ) {
+      h.update( acgt.data() + i, std::min( chunk, acgt.size() - i ) );
+    }
+    assert( h.digest() == KHash64::of( acgt.data(), acgt.size() ) );
+  }
+  assert( KHash64::combine( 1, 2 ) != KHash64::combine( 2, 1 ) );
+
+  for ( field::Field fields : { field::all, field::name } ) {
+    gzFile fp = gzopen( filename, "r" );
+    auto iks = make_ikstream( fp, gzread, 5 );
+    auto ref = make_ikstream( gzopen( filename, "r" ), gzread, gzclose );
+    iks.set_fields( fields );
+    iks.set_hashing();
+    assert( iks.is_hashing() );
+    KSeq record;
+    KSeq expected;
+    size_t n = 0;
+    while ( iks >> record ) {
+      assert( ref >> expected );
+      assert( iks.hash() == KHash64::of( expected.seq.data(), expected.seq.size() ) );
+      ++n;
+    }
+    assert( n == nrec );
+    gzclose( fp );
+  }
+}
+
+  inline void
+write_file( std::string const& filename, std::string const& text )
+{
+  int fd = open( filename.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+  assert( write( fd, text.data(), text.size() ) == static_cast< ssize_t >( text.size() ) );
+  close( fd );
+}
+
+  inline std::string
+read_file( std::string const& filename )
+{
+  std::string text;
+  char buf[ 256 ];
+  int fd = open( filename.c_str(), O_RDONLY );
+  ssize_t n;
+  while ( ( n = read( fd, buf, sizeof( buf ) ) ) > 0 ) text.append( buf, n );
+  close( fd );
+  return text;
+}
+
+/* Copy the records passing `min_len` by their raw bytes and check their fields. */
+template< typename TFormat >
+    inline std::string
+  copy_raw( std::string const& input, std::string const& output, TFormat tag,
+      unsigned int bufsize, std::size_t min_len=0 )
+  {
+    gzFile fp = gzopen( input.c_str(), "r" );
+    int fd = open( output.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    {
+      auto iks = make_ikstream( fp, gzread, bufsize );
+      auto oks = make_okstream( fd, write, 5ul );
+      KFilter filter;
+      filter.min_len = min_len;
+      iks.set_filter( filter );
+      KSeq record;
+      KRaw raw;
+      while ( iks.read( record, raw, tag ) ) {
+        assert( raw.bytes.compare( 1, record.name.size(), record.name ) == 0 );
+        assert( record.seq.empty() || raw.bytes[ raw.seq ] == record.seq[ 0 ] );
+        if ( raw.qual != KRaw::npos ) {
+          assert( raw.bytes.compare( raw.qual, record.qual.size(), record.qual ) == 0 );
+        }
+        else assert( record.qual.empty() );
+        oks << raw;
+      }
+      assert( !iks.fail() || !iks.tqs() );
+    }
+    close( fd );
+    gzclose( fp );
+    return read_file( output );
+  }
+
+  void
+check_raw( )
+{
+  std::string input = get_tmpfile();
+  std::string output = get_tmpfile();
+  for ( unsigned int bufsize : { 1, 3, 8, 4096 } ) {
+    write_file( input, "\n>s1 c1\nAC\r\nGT\n\n@r1\nACG\n+r1\nII#\n\n>s2\n>s3\nA" );
+    assert( copy_raw( input, output, format::Mix_(), bufsize ) ==
+            ">s1 c1\nAC\r\nGT\n\n@r1\nACG\n+r1\nII#\n>s2\n>s3\nA\n" );
+    assert( copy_raw( input, output, format::Mix_(), bufsize, 3 ) ==
+            ">s1 c1\nAC\r\nGT\n\n@r1\nACG\n+r1\nII#\n" );
+
+    write_file( input, ">s1 @c\nAC\n@GT\n+A\n>s2\nA\n" );
+    assert( copy_raw( input, output, format::fasta_only, bufsize, 2 ) == ">s1 @c\nAC\n@GT\n+A\n" );
+
+    write_file( input, "@r1 c1\r\nACGT\r\n+\r\nIIII\r\n@r2\nA\n+\n#\n@r3\nAC\n+\n##\n" );
+    assert( copy_raw( input, output, format::fastq_strict, bufsize, 2 ) ==
+            "@r1 c1\r\nACGT\r\n+\r\nIIII\r\n@r3\nAC\n+\n##\n" );
+  }
+  std::remove( input.c_str() );
+  std::remove( output.c_str() );
+}
+
+  void
+check_adaptive( const char* filename, size_t nrec, size_t tot )
+{
+  {
+    // the throughput grows with the size up to 64 KiB
+    KBufferTuner tuner( 4096, 1048576, 4096 );
+    for ( unsigned int i = 0; i < 100 * KBufferTuner::WINDOW; ++i ) {
+      double rate = std::min( tuner.size(), 65536UL ) * 1000.0;
+      tuner.observe( tuner.size(), tuner.size() / rate );
+    }
+    assert( tuner.size() == 65536 );
+    // short transfers
+    for ( unsigned int i = 0; i < 10 * KBufferTuner::WINDOW; ++i ) tuner.observe( 100, 1e-6 );
+    assert( tuner.size() == 4096 );
+  }
+  {
+    bool thrown = false;
+    try {
+      KBufferTuner( 8192, 4096, 4096 );
+    }
+    catch ( const std::invalid_argument& ) {
+      thrown = true;
+    }
+    assert( thrown );
+  }
+  std::string tmpfile = get_tmpfile();
+  for ( unsigned int bufsize : { 1, 2, 3, 5, 8 } ) {
+    // line breaks falling on the buffer boundaries
+    int fd = open( tmpfile.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    auto oks = make_okstream( fd, write, format::mix, bufsize );
+    oks.set_wraplen( 2 );
+    KSeq record;
+    record.name = "r";
+    record.seq = "ACGTAC";
+    oks << record << kend;
+    close( fd );
+    assert( read_file( tmpfile ) == ">r\nAC\nGT\nAC\n" );
+  }
+  {
+    gzFile fp = gzopen( filename, "r" );
+    auto iks = make_ikstream( fp, gzread, 4096 );
+    iks.set_adaptive( 1024, 65536 );
+    assert( iks.is_adaptive() );
+    int fd = open( tmpfile.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    auto oks = make_okstream( fd, write, format::mix, 4096 );
+    oks.set_adaptive( 1024, 65536 );
+    assert( oks.is_adaptive() );
+    KSeq record;
+    size_t count = 0;
+    while ( iks >> record ) {
+      for ( int i = 0; i < 16; ++i ) oks << record;
+      ++count;
+    }
+    assert( count == nrec );
+    assert( iks.get_bufsize() >= 1024 && iks.get_bufsize() <= 65536 );
+    oks << kend;
+    assert( oks.get_bufsize() >= 1024 && oks.get_bufsize() <= 65536 );
+    oks.reset_adaptive();
+    assert( !oks.is_adaptive() );
+    gzclose( fp );
+    close( fd );
+  }
+  {
+    gzFile fp = gzopen( tmpfile.c_str(), "r" );
+    auto iks = make_ikstream( fp, gzread, 1024 );
+    iks.set_adaptive( 1024, 8192 );
+    KSeq record;
+    size_t count = 0;
+    size_t total_len = 0;
+    while ( iks >> record ) {
+      total_len += record.seq.size();
+      ++count;
+    }
+    assert( count == 16 * nrec );
+    assert( total_len == 16 * tot );
+    gzclose( fp );
+  }
+  std::remove( tmpfile.c_str() );
+}
+
+/* Bitwise CRC-32C as a reference. */
+  inline std::uint32_t
+crc32c_ref( std::string const& s )
+{
+  std::uint32_t c = 0xFFFFFFFF;
+  for ( unsigned char b : s ) {
+    c ^= b;
+    for ( int k = 0; k < 8; ++k ) c = ( c >> 1 ) ^ ( 0x82F63B78 & ( 0 - ( c & 1 ) ) );
+  }
+  return c ^ 0xFFFFFFFF;
+}
+
+  void
+check_checksums( const char* filename )
+{
+  assert( KCrc32c::of( "", 0 ) == 0 );
+  assert( KCrc32c::of( "123456789", 9 ) == 0xE3069283 );
+  KMd5 md5;
+  assert( md5.hexdigest() == "d41d8cd98f00b204e9800998ecf8427e" );
+  md5.update( "abc", 3 );
+  assert( md5.hexdigest() == "900150983cd24fb0d6963f7d28e17f72" );
+  std::string digits;
+  for ( int i = 0; i < 8; ++i ) digits += "1234567890";
+  md5.reset();
+  md5.update( digits.data(), digits.size() );
+  assert( md5.hexdigest() == "57edf4a22be3c955ac49da2e2107b67a" );
+
+  std::string text;
+  std::mt19937 rng( 7 );
+  for ( int i = 0; i < 5000; ++i ) text += static_cast< char >( rng() );
+  for ( std::size_t len : { 0, 1, 7, 8, 55, 56, 63, 64, 65, 1000, 5000 } ) {
+    std::string part = text.substr( 0, len );
+    assert( KCrc32c::of( part.data(), part.size() ) == crc32c_ref( part ) );
+    KChecksum whole;
+    whole.update( part.data(), part.size() );
+    for ( std::size_t chunk : { 1, 3, 64, 100 } ) {
+      KChecksum sum;
+      for ( std::size_t i = 0; i < part.size(); i += chunk ) {
+        sum.update( part.data() + i, std::min( chunk, part.size() - i ) );
+      }
+      assert( sum.size() == len );
+      assert( sum.get_crc32c() == whole.get_crc32c() );
+      assert( sum.get_md5() == whole.get_md5() );
+      assert( sum.get_xxh64() == KHash64::of( part.data(), part.size() ) );
+    }
+  }
+  {
+    KChecksum sum( checksum::crc32c );
+    sum.update( "abc", 3 );
+    assert( sum.get_crc32c() != 0 && sum.get_md5().empty() && sum.get_xxh64() == 0 );
+  }
+
+  std::string tmpfile = get_tmpfile();
+  for ( unsigned int bufsize : { 7, 4096 } ) {
+    int fd = open( tmpfile.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644 );
+    auto oks = make_okstream( fd, write, format::mix, bufsize, close );
+    oks.set_checksums();
+    assert( oks.is_checksumming() );
+    auto iks = make_ikstream( gzopen( filename, "r" ), gzread, gzclose );
+    KSeq record;
+    while ( iks >> record ) oks << record;
+    oks << kend;
+    KChecksum sum = oks.checksums();
+    std::string written = read_file( tmpfile );
+    assert( sum.size() == written.size() && sum.size() == oks.bytes() );
+    assert( sum.get_crc32c() == crc32c_ref( written ) );
+    assert( sum.get_xxh64() == KHash64::of( written.data(), written.size() ) );
+    oks << record;
+    assert( oks.finish() );
+    assert( !oks && oks.checksums().size() == oks.bytes() );
+    assert( read_file( tmpfile ).size() == oks.bytes() );
+    oks << record;  // no effect
+    auto moved = std::move( oks );  // a finished stream can be moved
+    assert( !moved );
+  }
+  std::remove( tmpfile.c_str() );
+}
+
   int
 main( int argc, char* argv[] )
 {
@@ -165,6 +908,19 @@ main( int argc, char* argv[] )
   gzclose(ifp);
   std::cout << "Verifying..." << std::endl;
   check( argv[1], count, total_len, min_len, max_len );
+  check_fields( argv[1], count, total_len );
+  check_scan( argv[1], count, total_len, min_len, max_len );
+  check_iterators( argv[1], count, total_len );
+  check_qualmap( argv[1] );
+  check_filter( argv[1] );
+  check_sampling( );
+  check_allocator( argv[1], count, total_len );
+  check_formats( );
+  check_validation( argv[1], count );
+  check_raw( );
+  check_hashing( argv[1], count );
+  check_adaptive( argv[1], count, total_len );
+  check_checksums( argv[1] );
   std::cout << "PASSED" << std::endl;
 
   return EXIT_SUCCESS;
@@ -0,0 +1,151 @@
+/**
+ *    @file  numa_test.cpp
+ *   @brief  Test for numa.hpp header file
+ *
+ *  Test cases for `numa.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:49
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <kseq++/seqio.hpp>
+#include <kseq++/numa.hpp>
+#include "tmpfile.hpp"
+
+
+using namespace klibpp;
+
+using alloc_type = KPageAllocator< char >;
+using istream_type = KStreamIn< gzFile, int(*)( gzFile_s*, void*, unsigned int ), alloc_type >;
+using ostream_type = KStreamOut< gzFile, int(*)( gzFile_s*, const void*, unsigned int ), alloc_type >;
+
+
+  inline bool
+equal( KSeq const& a, KSeq const& b )
+{
+  return a.name == b.name && a.comment == b.comment && a.seq == b.seq && a.qual == b.qual;
+}
+
+/* A CPU which the calling thread is allowed to run on (if known). */
+  inline KAffinity
+allowed_cpu( )
+{
+#if KSEQPP_HAS_AFFINITY
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  if ( sched_getaffinity( 0, sizeof( set ), &set ) == 0 ) {
+    for ( int cpu = 0; cpu < CPU_SETSIZE; ++cpu ) {
+      if ( CPU_ISSET( cpu, &set ) ) return KAffinity( { cpu } );
+    }
+  }
+#endif
+  return KAffinity();
+}
+
+  inline void
+check_allocation( pages::Policy policy, int node )
+{
+  alloc_type alloc( policy, node );
+  for ( std::size_t n : { 1UL, 4096UL, 65537UL, 2097152UL, 5000000UL } ) {
+    char* p = alloc.allocate( n );
+    assert( p != nullptr );
+    if ( n >= alloc_type::HUGE_PAGE_SIZE && policy != pages::normal ) {
+      assert( reinterpret_cast< std::uintptr_t >( p ) % alloc_type::HUGE_PAGE_SIZE == 0 );
+    }
+    for ( std::size_t i = 0; i < n; ++i ) p[ i ] = static_cast< char >( i );
+    for ( std::size_t i = 0; i < n; i += 997 ) assert( p[ i ] == static_cast< char >( i ) );
+    alloc.deallocate( p, n );
+  }
+  KPageAllocator< int > other( alloc );
+  assert( other.get_policy() == policy && other.get_node() == node );
+  assert( alloc_type( other ) == alloc && alloc != alloc_type( policy, node + 1 ) );
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Verifying page allocation..." << std::endl;
+  for ( auto policy : { pages::normal, pages::transparent, pages::hugetlb } ) {
+    check_allocation( policy, -1 );
+    check_allocation( policy, 0 );
+  }
+  {
+    assert( node_affinity( -1 ).empty() );
+    assert( node_affinity( 1 << 20 ).empty() );
+    KAffinity aff = node_affinity( 0 );
+    for ( int cpu : aff.get_cpus() ) assert( cpu >= 0 );
+  }
+
+  std::cout << "Verifying streams on pages with pinned threads..." << std::endl;
+  {
+    auto expected = SeqStreamIn( argv[1] ).read();
+    std::string filename = get_tmpfile();
+    KAffinity aff = allowed_cpu();
+    for ( auto policy : { pages::normal, pages::transparent, pages::hugetlb } ) {
+      for ( unsigned long int bufsize : { 4096UL, 3000000UL } ) {
+        {
+          ostream_type oks( gzopen( filename.c_str(), "wT" ), gzwrite, mode::out, format::mix,
+              bufsize, gzclose, alloc_type( policy, 0 ) );
+          assert( oks.set_affinity( KAffinity() ) );
+          assert( oks.set_affinity( aff ) || !KSEQPP_HAS_AFFINITY );
+          for ( auto const& rec : expected ) oks << rec;
+          // moving restarts the writer thread with the same affinity
+          ostream_type moved( std::move( oks ) );
+          assert( moved.get_affinity().get_cpus() == aff.get_cpus() );
+          for ( auto const& rec : expected ) moved << rec;
+        }
+        {
+          istream_type iks( gzopen( filename.c_str(), "r" ), gzread, mode::in, bufsize, gzclose,
+              alloc_type( policy ) );
+          std::vector< KSeq > records;
+          KSeq rec;
+          while ( iks >> rec ) records.push_back( rec );
+          assert( !iks.err() );
+          assert( records.size() == 2 * expected.size() );
+          for ( std::size_t i = 0; i < records.size(); ++i ) {
+            assert( equal( records[ i ], expected[ i % expected.size() ] ) );
+          }
+        }
+        {
+          istream_type iks( gzopen( filename.c_str(), "r" ), gzread, mode::in, bufsize, gzclose,
+              alloc_type( policy, 0 ) );
+          iks.set_affinity( aff );
+          KStats stats = iks.scan();  // reads ahead in a pinned thread
+          assert( stats.count == 2 * expected.size() );
+        }
+      }
+    }
+    {
+      PairedSeqStreamIn piks( argv[1], argv[1] );
+      assert( piks.set_affinity( aff ) || !KSEQPP_HAS_AFFINITY );
+      KSeqPair pair;
+      std::size_t count = 0;
+      while ( piks >> pair ) ++count;
+      assert( count == expected.size() );
+    }
+    ::unlink( filename.c_str() );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+/**
+ *    @file  ordered_test.cpp
+ *   @brief  Test for ordered.hpp header file
+ *
+ *  Test cases for `ordered.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:32
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include <kseq++/seqio.hpp>
+#include <kseq++/ordered.hpp>
+#include "tmpfile.hpp"
+
+
+using namespace klibpp;
+
+constexpr std::size_t BATCHSIZE = 5;
+constexpr unsigned int NTHREADS = 6;
+
+
+  inline std::string
+slurp( std::string const& filename )
+{
+  std::ifstream ifs( filename );
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  return ss.str();
+}
+
+/* Write the records by one thread. */
+  inline std::string
+write_serial( std::vector< KSeq > const& records, format::Format fmt, unsigned int wraplen )
+{
+  std::string filename = get_tmpfile();
+  {
+    SeqStreamOut oss( filename.c_str(), fmt );
+    oss.set_wraplen( wraplen );
+    oss.set_qualmap( KQualMap::shift( 33, 64 ) );
+    for ( auto const& r : records ) oss << r;
+  }
+  std::string text = slurp( filename );
+  ::unlink( filename.c_str() );
+  return text;
+}
+
+/* Write batches of records by several threads; batches are taken in a scrambled order. */
+  inline std::string
+write_parallel( std::vector< KSeq > const& records, format::Format fmt, unsigned int wraplen,
+    bool ordered, unsigned long int capacity )
+{
+  std::string filename = get_tmpfile();
+  std::size_t nbatches = ( records.size() + BATCHSIZE - 1 ) / BATCHSIZE;
+  {
+    SeqStreamOut oss( filename.c_str(), fmt );
+    oss.set_wraplen( wraplen );
+    oss.set_qualmap( KQualMap::shift( 33, 64 ) );
+    KOrderedStreamOut< SeqStreamOut > ooss( oss, ordered, capacity );
+    std::atomic< std::size_t > next( 0 );
+    std::vector< std::thread > workers;
+    for ( unsigned int t = 0; t < NTHREADS; ++t ) {
+      workers.emplace_back( [&, t]() {
+            KChunk chunk = ooss.chunk();
+            for ( std::size_t b = next++; b < nbatches; b = next++ ) {
+              for ( std::size_t i = b * BATCHSIZE; i < std::min( records.size(), ( b + 1 ) * BATCHSIZE ); ++i ) {
+                chunk << records[ i ];
+              }
+              if ( ( b + t ) % 3 == 0 ) std::this_thread::yield();
+              assert( ooss.submit( b, chunk ) );
+              assert( chunk.size() == 0 && chunk.counts() == 0 );
+            }
+          } );
+    }
+    for ( auto& w : workers ) w.join();
+    assert( ooss.counts() == records.size() && ooss.pending() == 0 );
+    oss << kend;
+  }
+  std::string text = slurp( filename );
+  ::unlink( filename.c_str() );
+  return text;
+}
+
+/* Split a text into records (for FASTQ without wrapping, four lines each). */
+  inline std::vector< std::string >
+split_records( std::string const& text )
+{
+  std::vector< std::string > ret;
+  std::istringstream iss( text );
+  std::string line;
+  std::string rec;
+  int n = 0;
+  while ( std::getline( iss, line ) ) {
+    rec += line + "\n";
+    if ( ++n % 4 == 0 ) {
+      ret.push_back( rec );
+      rec.clear();
+    }
+  }
+  std::sort( ret.begin(), ret.end() );
+  return ret;
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector< KSeq > records;
+  for ( int round = 0; round < 40; ++round ) {
+    for ( auto rec : SeqStreamIn( argv[1] ).read() ) {
+      rec.name += "_" + std::to_string( round );
+      if ( rec.qual.empty() ) rec.qual = std::string( rec.seq.size(), 'A' );
+      records.push_back( std::move( rec ) );
+    }
+  }
+
+  std::cout << "Verifying ordered multi-producer writing..." << std::endl;
+  assert( write_parallel( records, format::fastq, 0, true, 64 ) ==
+          write_serial( records, format::fastq, 0 ) );
+  assert( write_parallel( records, format::fastq, 0, true, 1 ) ==
+          write_serial( records, format::fastq, 0 ) );
+  assert( write_parallel( records, format::fasta, 7, true, 4 ) ==
+          write_serial( records, format::fasta, 7 ) );
+  assert( write_parallel( records, format::mix, 13, true, 2 ) ==
+          write_serial( records, format::mix, 13 ) );
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying unordered multi-producer writing..." << std::endl;
+  assert( split_records( write_parallel( records, format::fastq, 0, false, 3 ) ) ==
+          split_records( write_serial( records, format::fastq, 0 ) ) );
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying rejection of resubmitted chunks..." << std::endl;
+  {
+    std::string filename = get_tmpfile();
+    {
+      SeqStreamOut oss( filename.c_str(), format::fastq );
+      KOrderedStreamOut< SeqStreamOut > ooss( oss );
+      KChunk chunk = ooss.chunk();
+      chunk << records[ 0 ];
+      assert( ooss.submit( 1, chunk ) );  // waits for chunk 0
+      auto rejected = [&]( KOrderedStreamOut< SeqStreamOut >::seq_type seq ) {
+            chunk << records[ 1 ];
+            bool thrown = false;
+            try {
+              ooss.submit( seq, chunk );
+            }
+            catch ( std::invalid_argument const& ) {
+              thrown = true;
+            }
+            assert( chunk.counts() == ( thrown ? 1 : 0 ) );  // left untouched if rejected
+            chunk.clear();
+            return thrown;
+          };
+      assert( rejected( 1 ) );   // duplicate of a waiting chunk
+      assert( !rejected( 0 ) );  // fills the gap
+      assert( rejected( 0 ) );   // already written
+      assert( ooss.counts() == 2 && ooss.pending() == 0 );
+      oss << kend;
+    }
+    ::unlink( filename.c_str() );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/**
+ *    @file  paired_test.cpp
+ *   @brief  Test for paired.hpp header file
+ *
+ *  Test cases for `paired.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  09:45
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <kseq++/seqio.hpp>
+#include "tmpfile.hpp"
+
+
+using namespace klibpp;
+
+  void
+write_mates( std::vector< KSeq > const& records, std::string const& r1, std::string const& r2,
+             std::string const& interleaved, std::size_t skip )
+{
+  SeqStreamOut oss1( r1.c_str(), true );
+  SeqStreamOut oss2( r2.c_str() );
+  SeqStreamOut ossi( interleaved.c_str() );
+  for ( std::size_t i = 0; i < records.size(); ++i ) {
+    KSeq mate = records[ i ];
+    mate.name += "/1";
+    oss1 << mate;
+    ossi << mate;
+    if ( i == skip ) continue;
+    mate.name.back() = '2';
+    oss2 << mate;
+    ossi << mate;
+  }
+}
+
+  void
+check_pairs( PairedSeqStreamIn& piss, std::vector< KSeq > const& records, std::size_t skip )
+{
+  KSeqPair pair;
+  std::size_t count = 0;
+  while ( piss >> pair ) {
+    assert( count < skip );
+    assert( pair.first.name == records[ count ].name + "/1" );
+    assert( pair.second.name == records[ count ].name + "/2" );
+    assert( pair.first.seq == records[ count ].seq );
+    assert( pair.second.qual == records[ count ].qual );
+    ++count;
+  }
+  assert( count == std::min( skip, records.size() ) );
+  assert( piss.counts() == count );
+  assert( piss.unpaired() == ( skip < records.size() ) );
+  assert( !piss.err() && !piss.tqs() );
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector< KSeq > records = SeqStreamIn( argv[1] ).read();
+  std::string r1 = get_tmpfile();
+  std::string r2 = get_tmpfile();
+  std::string ri = get_tmpfile();
+  std::cout << "Output temporary files: " << r1 << ", " << r2 << ", " << ri << std::endl;
+
+  for ( std::size_t skip : { records.size(), records.size() - 1 } ) {
+    write_mates( records, r1, r2, ri, skip );
+    std::cout << "Verifying paired files..." << std::endl;
+    {
+      PairedSeqStreamIn piss( r1.c_str(), r2.c_str() );
+      check_pairs( piss, records, skip );
+    }
+    std::cout << "PASSED" << std::endl;
+    std::cout << "Verifying interleaved file..." << std::endl;
+    {
+      PairedSeqStreamIn piss( ri.c_str() );
+      check_pairs( piss, records, skip );
+    }
+    std::cout << "PASSED" << std::endl;
+  }
+
+  std::cout << "Verifying batched reads..." << std::endl;
+  write_mates( records, r1, r2, ri, records.size() );
+  KPairedStreamIn< SeqStreamIn > piss( SeqStreamIn( r1.c_str() ), SeqStreamIn( r2.c_str() ), true, 2 );
+  auto pairs = piss.read( 2 );
+  assert( pairs.size() == 2 );
+  auto rest = piss.read();
+  assert( rest.size() == records.size() - 2 );
+  assert( rest.back().second.name == records.back().name + "/2" );
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying subsampling..." << std::endl;
+  std::vector< KSeq > many;
+  for ( int i = 0; i < 500; ++i ) {
+    many.push_back( records[ i % records.size() ] );
+    many.back().name = std::to_string( i );
+  }
+  write_mates( many, r1, r2, ri, many.size() );
+  {
+    SeqStreamIn iss1( r1.c_str() );
+    SeqStreamIn iss2( r2.c_str() );
+    iss1.set_sampling( 0.2, 11 );
+    iss2.set_sampling( 0.2, 11 );
+    KPairedStreamIn< SeqStreamIn > spiss( std::move( iss1 ), std::move( iss2 ) );
+    auto sampled = spiss.read();
+    assert( !spiss.unpaired() && sampled.size() > 50 && sampled.size() < 150 );
+  }
+  {
+    SeqStreamIn iss( ri.c_str() );
+    iss.set_sampling( 0.2, 11, 2 );
+    KPairedStreamIn< SeqStreamIn > spiss( std::move( iss ) );
+    auto sampled = spiss.read();
+    assert( !spiss.unpaired() && sampled.size() > 50 && sampled.size() < 150 );
+  }
+  {
+    SeqStreamIn iss1( r1.c_str() );
+    SeqStreamIn iss2( r2.c_str() );
+    auto sampled = sample_pairs( iss1, iss2, 20, 5 );
+    assert( sampled.size() == 20 );
+    for ( auto const& pair : sampled ) {
+      assert( KPairedStreamIn< SeqStreamIn >::is_mate( pair.first.name, pair.second.name ) );
+    }
+    SeqStreamIn iss( ri.c_str() );
+    auto isampled = sample_pairs( iss, 20, 5 );
+    assert( isampled.size() == 20 );
+    for ( std::size_t i = 0; i < isampled.size(); ++i ) {
+      assert( isampled[ i ].first.name == sampled[ i ].first.name );
+      assert( isampled[ i ].second.name == sampled[ i ].second.name );
+    }
+  }
+  std::cout << "PASSED" << std::endl;
+
+  return EXIT_SUCCESS;
+}
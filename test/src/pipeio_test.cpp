@@ -0,0 +1,128 @@
+/**
+ *    @file  pipeio_test.cpp
+ *   @brief  Test for pipeio.hpp header file
+ *
+ *  Test cases for `pipeio.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:19
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include <kseq++/seqio.hpp>
+#include <kseq++/pipeio.hpp>
+
+
+using namespace klibpp;
+
+  inline std::string
+read_all( int fd )
+{
+  std::string text;
+  char buf[ 4096 ];
+  long int n;
+  while ( ( n = pipeio::read( fd, buf, sizeof( buf ) ) ) > 0 ) text.append( buf, n );
+  return text;
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector< KSeq > records = SeqStreamIn( argv[1] ).read();
+  std::string text;
+  {
+    int fd = ::open( argv[1], O_RDONLY );
+    text = read_all( fd );
+    ::close( fd );
+  }
+
+  std::cout << "Verifying pipe streams..." << std::endl;
+  {
+    int p[ 2 ];
+    assert( ::pipe( p ) == 0 );
+    assert( pipeio::is_pipe( p[ 0 ] ) && pipeio::is_pipe( p[ 1 ] ) );
+    std::thread producer( [&records, &p]() {
+      PipeStreamOut out( p[ 1 ], format::mix, true );
+      for ( auto const& r : records ) out << r;
+      assert( out );
+    } );
+    PipeStreamIn in( p[ 0 ], true );
+    std::vector< KSeq > piped = in.read();
+    producer.join();
+    assert( piped.size() == records.size() );
+    for ( std::size_t i = 0; i < records.size(); ++i ) {
+      assert( piped[ i ].name == records[ i ].name );
+      assert( piped[ i ].seq == records[ i ].seq );
+      assert( piped[ i ].qual == records[ i ].qual );
+    }
+  }
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying passthrough..." << std::endl;
+  {
+    int in_p[ 2 ];
+    int out_p[ 2 ];
+    assert( ::pipe( in_p ) == 0 && ::pipe( out_p ) == 0 );
+    std::thread producer( [&text, &in_p]() {
+      long int len = text.size();
+      assert( pipeio::write( in_p[ 1 ], text.data(), len ) == len );
+      ::close( in_p[ 1 ] );
+    } );
+    std::string passed;
+    std::thread consumer( [&passed, &out_p]() {
+      passed = read_all( out_p[ 0 ] );
+      ::close( out_p[ 0 ] );
+    } );
+    std::size_t first = 0;
+    {
+      PipeStreamIn in( in_p[ 0 ], true );
+      KSeq record;
+      KRaw raw;
+      assert( in.read( record, raw ) );
+      assert( record.name == records[ 0 ].name );
+      first = text.find( raw.bytes ) + raw.bytes.size();
+      assert( in.passthrough( out_p[ 1 ] ) == static_cast< long long int >( text.size() - first ) );
+      assert( in.eof() && !( in >> record ) );
+    }
+    ::close( out_p[ 1 ] );
+    producer.join();
+    consumer.join();
+    assert( passed == text.substr( first ) );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying copy between regular files..." << std::endl;
+  {
+    char tmpl[] = "/tmp/kseqpp-XXXXXX";
+    int out = ::mkstemp( tmpl );
+    int in = ::open( argv[1], O_RDONLY );
+    assert( !pipeio::is_pipe( in ) && pipeio::set_pipe_size( in ) == -1 );
+    assert( pipeio::copy( in, out ) == static_cast< long long int >( text.size() ) );
+    ::close( in );
+    ::lseek( out, 0, SEEK_SET );
+    assert( read_all( out ) == text );
+    ::close( out );
+    ::unlink( tmpl );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  return EXIT_SUCCESS;
+}
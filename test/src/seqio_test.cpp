@@ -18,58 +18,19 @@
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 #include <kseq++/seqio.hpp>
 #include "kseq.h"
-
-#define DEFAULT_TMPDIR "/tmp"
-#define TMPFILE_TEMPLATE "/kseqpp-XXXXXX"
+#include "tmpfile.hpp"
 
 
 using namespace klibpp;
 
 KSEQ_INIT(gzFile, gzread)
 
-  inline std::string
-get_env( const std::string& var )
-{
-  const char* val = ::getenv( var.c_str() );
-  if ( val == 0 ) {
-    return "";
-  }
-  else {
-    return val;
-  }
-}
-
-  inline std::string
-get_tmpdir_env( )
-{
-  return get_env( "TMPDIR" );
-}
-
-  inline std::string
-get_tmpdir( )
-{
-  std::string tmpdir = get_tmpdir_env();
-  if ( tmpdir.size() == 0 ) tmpdir = DEFAULT_TMPDIR;
-  return tmpdir;
-}
-
-  inline std::string
-get_tmpfile( )
-{
-  std::string tmpfile_templ = get_tmpdir() + TMPFILE_TEMPLATE;
-  char* tmpl = new char [ tmpfile_templ.size() + 1 ];
-  std::strcpy( tmpl, tmpfile_templ.c_str() );
-  int fd = mkstemp( tmpl );
-  tmpfile_templ = tmpl;
-
-  ::close( fd );
-  delete[] tmpl;
-  return tmpfile_templ;
-}
-
   void
 check( const char* filename, size_t nrec, size_t tot, size_t min, size_t max )
 {
@@ -98,6 +59,72 @@ check( const char* filename, size_t nrec, size_t tot, size_t min, size_t max )
   gzclose(fp);
 }
 
+/* Check the progress reports against the file size. */
+template< typename TStream >
+    inline void
+  check_progress( TStream& iks, std::uint64_t size, size_t nrec )
+  {
+    std::vector< KProgress > reports;
+    iks.set_progress( [&reports]( KProgress const& p ) { reports.push_back( p ); }, 0 );
+    KSeq record;
+    while ( iks >> record );
+    assert( !reports.empty() );
+    for ( auto const& r : reports ) assert( r.bytes <= size );
+    for ( std::size_t i = 1; i < reports.size(); ++i ) {
+      assert( reports[ i - 1 ].bytes <= reports[ i ].bytes );
+      assert( reports[ i - 1 ].records <= reports[ i ].records );
+      assert( reports[ i - 1 ].elapsed <= reports[ i ].elapsed );
+    }
+    assert( reports.back().bytes == size );
+    KProgress p = iks.progress();
+    assert( p.records == nrec && iks.counts() == nrec );
+    assert( p.bytes == size );
+    if ( iks.get_total() != 0 ) {
+      assert( p.total == size && p.fraction() == 1 && p.eta() == 0 );
+    }
+    else assert( p.fraction() < 0 && p.eta() < 0 );
+    assert( p.records_per_sec() >= 0 && p.bytes_per_sec() >= 0 );
+  }
+
+  inline std::string
+read_bytes( const char* filename, bool decompress )
+{
+  std::string text;
+  char buf[ 4096 ];
+  if ( decompress ) {
+    gzFile fp = gzopen( filename, "r" );
+    int n;
+    while ( ( n = gzread( fp, buf, sizeof( buf ) ) ) > 0 ) text.append( buf, n );
+    gzclose( fp );
+  }
+  else {
+    std::FILE* fp = std::fopen( filename, "rb" );
+    std::size_t n;
+    while ( ( n = std::fread( buf, 1, sizeof( buf ), fp ) ) > 0 ) text.append( buf, n );
+    std::fclose( fp );
+  }
+  return text;
+}
+
+  inline void
+check_checksums( KChecksum const& sum, std::string const& bytes )
+{
+  KChecksum expected;
+  expected.update( bytes.data(), bytes.size() );
+  assert( sum.size() == bytes.size() );
+  assert( sum.get_crc32c() == expected.get_crc32c() );
+  assert( sum.get_md5() == expected.get_md5() );
+  assert( sum.get_xxh64() == expected.get_xxh64() );
+}
+
+  inline std::uint64_t
+file_size( const char* filename )
+{
+  struct stat st;
+  assert( ::stat( filename, &st ) == 0 );
+  return st.st_size;
+}
+
   int
 main( int argc, char* argv[] )
 {
@@ -133,6 +160,30 @@ main( int argc, char* argv[] )
     }
     std::cout << "Verifying..." << std::endl;
     check( argv[1], count, total_len, min_len, max_len );
+    {
+      SeqStreamIn pss( tmpfile.c_str() );
+      assert( pss.get_total() == file_size( tmpfile.c_str() ) );
+      check_progress( pss, file_size( tmpfile.c_str() ), count );
+    }
+    {
+      int fd = open( argv[1], O_RDONLY );
+      auto pks = make_ikstream( fd, read, 16 );
+      check_progress( pks, file_size( argv[1] ), count );
+      close( fd );
+    }
+    {
+      // checksums of the output and the file
+      SeqStreamOut oss( tmpfile.c_str(), compressed, checksum::all );
+      for ( int round = 0; round < 100; ++round ) {
+        SeqStreamIn iss( argv[1] );
+        while ( iss >> record ) oss << record;
+      }
+      assert( oss.finish() );
+      check_checksums( oss.checksums(), read_bytes( tmpfile.c_str(), true ) );
+      check_checksums( oss.file_checksums(), read_bytes( tmpfile.c_str(), false ) );
+      if ( compressed ) assert( oss.file_checksums().size() < oss.checksums().size() );
+      else assert( oss.file_checksums().get_md5() == oss.checksums().get_md5() );
+    }
     std::cout << "PASSED" << std::endl;
 
     compressed = !compressed;
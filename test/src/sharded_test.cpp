@@ -0,0 +1,148 @@
+/**
+ *    @file  sharded_test.cpp
+ *   @brief  Test for sharded.hpp header file
+ *
+ *  Test cases for `sharded.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  09:46
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <kseq++/seqio.hpp>
+#include "tmpfile.hpp"
+
+
+using namespace klibpp;
+
+  void
+check( std::vector< std::string > const& files, std::vector< KSeq > const& records,
+       std::size_t nshards, bool roundrobin )
+{
+  assert( files.size() == nshards );
+  std::vector< std::vector< KSeq > > shards;
+  for ( auto const& f : files ) shards.push_back( SeqStreamIn( f.c_str() ).read() );
+  std::size_t total = 0;
+  for ( auto const& s : shards ) {
+    assert( !s.empty() );
+    total += s.size();
+  }
+  assert( total == records.size() );
+  for ( std::size_t i = 0, j = 0, k = 0; i < records.size(); ++i ) {
+    if ( roundrobin ) {
+      j = i % nshards;
+      k = i / nshards;
+    }
+    else if ( k == shards[ j ].size() ) {
+      ++j;
+      k = 0;
+    }
+    assert( shards[ j ][ k ].name == records[ i ].name );
+    assert( shards[ j ][ k ].seq == records[ i ].seq );
+    assert( shards[ j ][ k ].qual == records[ i ].qual );
+    if ( !roundrobin ) ++k;
+  }
+  for ( auto const& f : files ) ::unlink( f.c_str() );
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector< KSeq > records = SeqStreamIn( argv[1] ).read();
+  std::string tmpdir = get_tmpsubdir();
+  std::string pattern = tmpdir + "/shard-%03d.fq.gz";
+  std::cout << "Output temporary directory: " << tmpdir << std::endl;
+
+  std::cout << "Verifying sharding by records..." << std::endl;
+  std::vector< std::string > files;
+  {
+    ShardedSeqStreamOut oss( pattern, shard::records, 2, true );
+    for ( auto const& r : records ) oss << r;
+    assert( oss && oss.counts() == records.size() );
+    files = oss.files();
+  }
+  check( files, records, ( records.size() + 1 ) / 2, false );
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying sharding by bytes..." << std::endl;
+  {
+    ShardedSeqStreamOut oss( pattern, shard::bytes, 1 );
+    for ( auto const& r : records ) oss << r;
+    files = oss.files();
+  }
+  check( files, records, records.size(), false );
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying round-robin sharding..." << std::endl;
+  {
+    ShardedSeqStreamOut oss( pattern, shard::roundrobin, 2, true );
+    for ( auto const& r : records ) oss << r;
+    files = oss.files();
+  }
+  check( files, records, 2, true );
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying shard name patterns..." << std::endl;
+  for ( std::string bad : { "/shard.fq", "/shard-%s.fq", "/shard-%d-%d.fq", "/shard-%x.fq", "/shard-%" } ) {
+    bool thrown = false;
+    try {
+      ShardedSeqStreamOut oss( tmpdir + bad, shard::records, 2 );
+    }
+    catch ( std::invalid_argument const& ) {
+      thrown = true;
+    }
+    assert( thrown );
+  }
+  {
+    ShardedSeqStreamOut oss( tmpdir + "/100%%-%3d.fq", shard::records, 2 );
+    for ( auto const& r : records ) oss << r;
+    assert( oss.finish() && oss );
+    files = oss.files();
+    assert( files[ 0 ] == tmpdir + "/100%-  0.fq" );
+  }
+  check( files, records, ( records.size() + 1 ) / 2, false );
+  {
+    bool thrown = false;
+    try {
+      ShardedSeqStreamOut oss( tmpdir + "/missing/shard-%d.fq", shard::records, 2 );
+    }
+    catch ( std::runtime_error const& ) {
+      thrown = true;
+    }
+    assert( thrown );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  std::cout << "Verifying failures in closing shards..." << std::endl;
+  {
+    using stream_type = KStreamOut< int, ssize_t(*)( int, const void*, size_t ) >;
+    auto fail_write = []( int, const void*, size_t ) -> ssize_t { return 0; };
+    KShardedStreamOut< stream_type > oss( "shard-%d", shard::records, 1,
+        [fail_write]( std::string const& ) { return new stream_type( -1, fail_write ); } );
+    for ( auto const& r : records ) oss << r;  // buffered until the shards are closed
+    assert( !oss.finish() && !oss );
+    oss << records[ 0 ];
+    assert( !oss );
+  }
+  std::cout << "PASSED" << std::endl;
+  ::rmdir( tmpdir.c_str() );
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+/**
+ *    @file  shared_test.cpp
+ *   @brief  Test for shared.hpp header file
+ *
+ *  Test cases for `shared.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:34
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include <kseq++/seqio.hpp>
+#include <kseq++/shared.hpp>
+#include "tmpfile.hpp"
+
+
+using namespace klibpp;
+
+  inline bool
+equal( KSeq const& a, KSeq const& b )
+{
+  return a.name == b.name && a.comment == b.comment && a.seq == b.seq && a.qual == b.qual;
+}
+
+/* Read the file by several threads and put the batches back in order. */
+  inline std::vector< KSeq >
+read_shared( std::string const& filename, unsigned long int batchsize, unsigned long int depth,
+    unsigned int nthreads )
+{
+  using reader_type = KSharedStreamIn< SeqStreamIn >;
+  reader_type reader( SeqStreamIn( filename.c_str() ), batchsize, depth );
+  std::map< std::uint64_t, std::vector< KSeq > > batches;
+  std::mutex mutex;
+  std::vector< std::thread > workers;
+  for ( unsigned int t = 0; t < nthreads; ++t ) {
+    workers.emplace_back( [&]() {
+          reader_type::Batch batch;
+          while ( reader.next_batch( batch ) ) {
+            assert( batch.size > 0 && batch.size <= batchsize );
+            std::vector< KSeq > records( batch.records.begin(), batch.records.begin() + batch.size );
+            std::unique_lock< std::mutex > lock( mutex );
+            assert( batches.count( batch.index ) == 0 );
+            batches[ batch.index ] = std::move( records );
+          }
+          assert( batch.size == 0 );
+        } );
+  }
+  for ( auto& w : workers ) w.join();
+  assert( reader.finished() && !reader.err() && !reader.tqs() );
+  std::vector< KSeq > ret;
+  std::uint64_t expected = 0;
+  for ( auto& b : batches ) {
+    assert( b.first == expected++ );
+    for ( auto& rec : b.second ) ret.push_back( std::move( rec ) );
+  }
+  return ret;
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Verifying shared reading..." << std::endl;
+  {
+    auto records = read_shared( argv[1], 2, 1, 4 );
+    auto expected = SeqStreamIn( argv[1] ).read();
+    assert( records.size() == expected.size() );
+    for ( std::size_t i = 0; i < records.size(); ++i ) assert( equal( records[ i ], expected[ i ] ) );
+  }
+  {
+    // the test records repeated with multi-line sequences and no trailing newline
+    std::string filename = get_tmpfile();
+    {
+      std::vector< KSeq > base = SeqStreamIn( argv[1] ).read();
+      SeqStreamOut oss( filename.c_str() );
+      oss.set_wraplen( 11 );
+      for ( int round = 0; round < 200; ++round ) {
+        for ( auto rec : base ) {
+          rec.name += "_" + std::to_string( round );
+          oss << rec;
+        }
+      }
+    }
+    {
+      std::string text;
+      std::FILE* fp = std::fopen( filename.c_str(), "rb" );
+      for ( int c; ( c = std::fgetc( fp ) ) != EOF; ) text += static_cast< char >( c );
+      std::fclose( fp );
+      text.pop_back();
+      fp = std::fopen( filename.c_str(), "wb" );
+      std::fwrite( text.data(), 1, text.size(), fp );
+      std::fclose( fp );
+    }
+    auto expected = SeqStreamIn( filename.c_str() ).read();
+    for ( unsigned long int bs : { 1, 7, 1024 } ) {
+      auto records = read_shared( filename, bs, 3, 8 );
+      assert( records.size() == expected.size() );
+      for ( std::size_t i = 0; i < records.size(); ++i ) assert( equal( records[ i ], expected[ i ] ) );
+    }
+    ::unlink( filename.c_str() );
+  }
+  std::cout << "PASSED" << std::endl;
+
+  return EXIT_SUCCESS;
+}
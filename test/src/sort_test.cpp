@@ -0,0 +1,232 @@
+/**
+ *    @file  sort_test.cpp
+ *   @brief  Test for sort.hpp header file
+ *
+ *  Test cases for `sort.hpp` header file.
+ *
+ *  @author  agent, <agent@local>
+ *
+ *  @internal
+ *       Created:  Sun Oct 18, 2026  10:27
+ *     Copyright:  Copyright (c) 2026, agent
+ *
+ *  This source code is released under the terms of the MIT License.
+ *  See LICENSE file for more information.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <kseq++/seqio.hpp>
+#include <kseq++/sort.hpp>
+#include "tmpfile.hpp"
+
+
+using namespace klibpp;
+
+  inline std::size_t
+count_files( std::string const& dirname )
+{
+  std::size_t n = 0;
+  DIR* dir = ::opendir( dirname.c_str() );
+  while ( struct dirent* e = ::readdir( dir ) ) {
+    if ( e->d_name[ 0 ] != '.' ) ++n;
+  }
+  ::closedir( dir );
+  return n;
+}
+
+  inline std::uint64_t
+min_hash( std::string const& seq, unsigned int k )
+{
+  std::uint64_t min = std::numeric_limits< std::uint64_t >::max();
+  auto sink = make_kmer_sink( k, [&min]( std::uint64_t km, std::size_t ) {
+        min = std::min( min, kmer::hash( km ) );
+      } );
+  sink.append( seq.data(), seq.size() );
+  return min;
+}
+
+/* Input stream calling a hook before the given record is read. */
+struct HookedStreamIn {
+  SeqStreamIn& in;
+  unsigned long int at;
+  std::function< void() > hook;
+  unsigned long int n = 0;
+
+  HookedStreamIn& operator>>( KSeq& rec )
+  {
+    if ( ++this->n == this->at ) this->hook();
+    this->in >> rec;
+    return *this;
+  }
+
+  operator bool( ) const
+  {
+    return static_cast< bool >( this->in );
+  }
+};
+
+/* Sort records of `input` with the given options and compare with an in-memory stable sort. */
+  inline void
+check( std::string const& input, std::vector< KSeq > records, KSortOptions const& opts )
+{
+  std::string output = get_tmpfile();
+  unsigned long int n;
+  {
+    SeqStreamIn iss( input.c_str() );
+    SeqStreamOut oss( output.c_str() );
+    n = sort_records( iss, oss, opts );
+    assert( iss.eof() && !iss.err() );
+  }
+  assert( n == records.size() );
+  std::stable_sort( records.begin(), records.end(), [&opts]( KSeq const& a, KSeq const& b ) {
+        switch ( opts.order ) {
+          case sorting::name: return a.name < b.name;
+          case sorting::seq: return a.seq < b.seq;
+          case sorting::minimizer: {
+            std::uint64_t ha = min_hash( a.seq, opts.k );
+            std::uint64_t hb = min_hash( b.seq, opts.k );
+            return ha < hb || ( ha == hb && a.seq < b.seq );
+          }
+        }
+        return false;
+      } );
+  auto sorted = SeqStreamIn( output.c_str() ).read();
+  assert( sorted.size() == records.size() );
+  for ( std::size_t i = 0; i < records.size(); ++i ) {
+    assert( sorted[ i ].name == records[ i ].name );
+    assert( sorted[ i ].comment == records[ i ].comment );
+    assert( sorted[ i ].seq == records[ i ].seq );
+    assert( sorted[ i ].qual == records[ i ].qual );
+  }
+  ::unlink( output.c_str() );
+}
+
+  int
+main( int argc, char* argv[] )
+{
+  if ( argc == 1 ) {
+    std::cerr << "Usage: " << argv[0] << " FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // the test records followed by random ones with repeated names and sequences
+  std::vector< KSeq > records = SeqStreamIn( argv[1] ).read();
+  std::mt19937 rng( 7 );
+  for ( int i = 0; i < 500; ++i ) {
+    records.emplace_back();
+    records.back().name = "r" + std::to_string( rng() % 200 );
+    records.back().comment = "c" + std::to_string( i );
+    std::size_t len = 10 + rng() % 60;
+    if ( i % 7 == 0 ) records.back().seq = records[ rng() % records.size() ].seq;
+    else for ( std::size_t j = 0; j < len; ++j ) records.back().seq += "ACGT"[ rng() % 4 ];
+    records.back().qual = std::string( records.back().seq.size(), 'I' );
+  }
+  std::string input = get_tmpfile();
+  {
+    SeqStreamOut oss( input.c_str() );
+    for ( auto const& r : records ) oss << r;
+  }
+  char tmpl[] = "/tmp/kseqpp-sort-XXXXXX";
+  std::string tmpdir = ::mkdtemp( tmpl );
+
+  for ( auto order : { sorting::name, sorting::seq, sorting::minimizer } ) {
+    KSortOptions opts;
+    opts.order = order;
+    opts.tmpdir = tmpdir;
+    opts.k = 5;
+    std::cout << "Verifying sorting in memory (order " << order << ")..." << std::endl;
+    check( input, records, opts );
+    std::cout << "PASSED" << std::endl;
+
+    std::cout << "Verifying external sorting (order " << order << ")..." << std::endl;
+    for ( unsigned int threads : { 1, 3 } ) {
+      for ( int level : { 0, 1 } ) {
+        opts.memory = 4096;
+        opts.threads = threads;
+        opts.level = level;
+        check( input, records, opts );
+        assert( count_files( tmpdir ) == 0 );
+      }
+    }
+    std::cout << "PASSED" << std::endl;
+
+    std::cout << "Verifying multi-pass merging (order " << order << ")..." << std::endl;
+    for ( unsigned int fanin : { 2, 3 } ) {
+      opts.memory = 4096;
+      opts.threads = 2;
+      opts.fanin = fanin;
+      check( input, records, opts );
+      assert( count_files( tmpdir ) == 0 );
+    }
+    std::cout << "PASSED" << std::endl;
+  }
+
+  bool thrown = false;
+  try {
+    KSortOptions opts;
+    opts.memory = 1;
+    opts.tmpdir = tmpdir + "/none";
+    SeqStreamIn iss( input.c_str() );
+    SeqStreamOut oss( "/dev/null" );
+    sort_records( iss, oss, opts );
+  }
+  catch ( std::runtime_error const& ) {
+    thrown = true;
+  }
+  assert( thrown );
+
+  for ( std::size_t memory : { KSortOptions::DEFAULT_MEMORY, std::size_t( 4096 ) } ) {
+    thrown = false;
+    try {
+      KSortOptions opts;
+      opts.memory = memory;
+      opts.tmpdir = tmpdir;
+      SeqStreamIn iss( input.c_str() );
+      auto fail_write = []( int, const void*, size_t ) -> ssize_t { return 0; };
+      KStreamOut< int, ssize_t(*)( int, const void*, size_t ) > oks( -1, fail_write );
+      sort_records( iss, oks, opts );
+    }
+    catch ( std::runtime_error const& ) {
+      thrown = true;
+    }
+    assert( thrown );
+    assert( count_files( tmpdir ) == 0 );
+  }
+
+  // the temporary directory disappears while runs are being spilled
+  thrown = false;
+  std::string moved = tmpdir + "-moved";
+  try {
+    KSortOptions opts;
+    opts.memory = 4096;
+    opts.threads = 1;
+    opts.tmpdir = tmpdir;
+    SeqStreamIn iss( input.c_str() );
+    HookedStreamIn hss{ iss, 100, [&]() { ::rename( tmpdir.c_str(), moved.c_str() ); } };
+    SeqStreamOut oss( "/dev/null" );
+    sort_records( hss, oss, opts );
+  }
+  catch ( std::runtime_error const& ) {
+    thrown = true;
+  }
+  assert( thrown );
+  DIR* dir = ::opendir( moved.c_str() );
+  while ( struct dirent* e = ::readdir( dir ) ) {
+    if ( e->d_name[ 0 ] != '.' ) ::unlink( ( moved + "/" + e->d_name ).c_str() );
+  }
+  ::closedir( dir );
+  ::rmdir( moved.c_str() );
+
+  ::unlink( input.c_str() );
+  return EXIT_SUCCESS;
+}